@@ -18,10 +18,7 @@
 #include "ItemInitScriptResponse.h"
 #include "CombineItems.h"
 #include "DialogueResponse.h"
-#include "TileAddLayer.h"
-#include "TileRemoveLayer.h"
-#include "TileClearLayers.h"
-#include "TileExtentClearLayers.h"
+#include "TileUpdateBatch.h"
 #include "InventoryOperation.h"
 #include "PlayerMovementUpdate.h"
 #include "Log.h"
@@ -117,26 +114,11 @@ void MessageProcessor::processReceivedMessage(Uint8 messageType,
                                               networkEventDispatcher);
             break;
         }
-        case EngineMessageType::TileAddLayer: {
-            dispatchMessage<TileAddLayer>(messageBuffer, messageSize,
-                                          networkEventDispatcher);
-            break;
-        }
-        case EngineMessageType::TileRemoveLayer: {
-            dispatchMessage<TileRemoveLayer>(messageBuffer, messageSize,
-                                             networkEventDispatcher);
-            break;
-        }
-        case EngineMessageType::TileClearLayers: {
-            dispatchMessage<TileClearLayers>(messageBuffer, messageSize,
+        case EngineMessageType::TileUpdateBatch: {
+            dispatchMessage<TileUpdateBatch>(messageBuffer, messageSize,
                                              networkEventDispatcher);
             break;
         }
-        case EngineMessageType::TileExtentClearLayers: {
-            dispatchMessage<TileExtentClearLayers>(messageBuffer, messageSize,
-                                                   networkEventDispatcher);
-            break;
-        }
         case EngineMessageType::InventoryOperation: {
             dispatchMessage<InventoryOperation>(messageBuffer, messageSize,
                                                 networkEventDispatcher);
@@ -0,0 +1,196 @@
+#include "ChunkPrefetcher.h"
+#include "Position.h"
+#include "Config.h"
+#include "SharedConfig.h"
+#include <algorithm>
+
+namespace AM
+{
+namespace Client
+{
+ChunkExtent
+    ChunkPrefetcher::getInRangeExtent(const ChunkPosition& chunkPosition,
+                                      const ChunkExtent& mapChunkExtent)
+{
+    ChunkExtent inRangeExtent{(chunkPosition.x - 1),
+                              (chunkPosition.y - 1),
+                              mapChunkExtent.z,
+                              3,
+                              3,
+                              mapChunkExtent.zLength};
+    inRangeExtent.intersectWith(mapChunkExtent);
+    return inRangeExtent;
+}
+
+float ChunkPrefetcher::getSquaredDistance(const Position& position,
+                                          const ChunkPosition& chunkPosition)
+{
+    static constexpr float CHUNK_WORLD_WIDTH{
+        static_cast<float>(SharedConfig::CHUNK_WIDTH
+                           * SharedConfig::TILE_WORLD_WIDTH)};
+    static constexpr float TILE_WORLD_HEIGHT{
+        static_cast<float>(SharedConfig::TILE_WORLD_HEIGHT)};
+
+    Position chunkCenter{
+        ((static_cast<float>(chunkPosition.x) + 0.5f) * CHUNK_WORLD_WIDTH),
+        ((static_cast<float>(chunkPosition.y) + 0.5f) * CHUNK_WORLD_WIDTH),
+        ((static_cast<float>(chunkPosition.z) + 0.5f) * TILE_WORLD_HEIGHT)};
+    return position.squaredDistanceTo(chunkCenter);
+}
+
+void ChunkPrefetcher::sortByDistance(std::span<ChunkPosition> chunks,
+                                     const Position& position)
+{
+    std::sort(chunks.begin(), chunks.end(),
+              [&](const ChunkPosition& a, const ChunkPosition& b) {
+                  return getSquaredDistance(position, a)
+                         < getSquaredDistance(position, b);
+              });
+}
+
+void ChunkPrefetcher::getAllInRangeChunks(
+    const Position& position, const ChunkExtent& mapChunkExtent,
+    std::vector<ChunkPosition>& outChunks)
+{
+    // Iterate over the range, adding all chunks to the list.
+    ChunkExtent currentExtent{
+        getInRangeExtent(position.asChunkPosition(), mapChunkExtent)};
+    std::size_t startIndex{outChunks.size()};
+    for (int z{currentExtent.z}; z <= currentExtent.zMax(); ++z) {
+        for (int y{currentExtent.y}; y <= currentExtent.yMax(); ++y) {
+            for (int x{currentExtent.x}; x <= currentExtent.xMax(); ++x) {
+                outChunks.emplace_back(x, y, z);
+            }
+        }
+    }
+
+    // Sort the new chunks so the nearest ones are requested first.
+    sortByDistance({(outChunks.begin() + startIndex), outChunks.end()},
+                   position);
+
+    // Everything in range is being requested, so nothing is prefetched.
+    reset();
+}
+
+bool ChunkPrefetcher::getChunksToRequest(
+    const Position& position, const Position& previousPosition,
+    const ChunkExtent& mapChunkExtent, std::vector<ChunkPosition>& outChunks)
+{
+    // If we moved into a new chunk, add the chunks that we're now in range 
+    // of.
+    ChunkPosition previousChunk{previousPosition.asChunkPosition()};
+    bool enteredNewChunk{previousChunk != position.asChunkPosition()};
+    if (enteredNewChunk) {
+        getNewInRangeChunks(previousChunk, position, mapChunkExtent,
+                            outChunks);
+        reset();
+    }
+
+    // Add the chunks that we're about to be in range of.
+    getChunksToPrefetch(position, previousPosition, mapChunkExtent,
+                        outChunks);
+
+    return enteredNewChunk;
+}
+
+void ChunkPrefetcher::getNewInRangeChunks(
+    const ChunkPosition& previousChunk, const Position& position,
+    const ChunkExtent& mapChunkExtent,
+    std::vector<ChunkPosition>& outChunks) const
+{
+    // Determine which chunks are in range of each chunk position.
+    ChunkExtent previousExtent{
+        getInRangeExtent(previousChunk, mapChunkExtent)};
+    ChunkExtent currentExtent{
+        getInRangeExtent(position.asChunkPosition(), mapChunkExtent)};
+
+    // Iterate over the current extent, adding any new chunks to the list.
+    std::size_t startIndex{outChunks.size()};
+    for (int z{currentExtent.z}; z <= currentExtent.zMax(); ++z) {
+        for (int y{currentExtent.y}; y <= currentExtent.yMax(); ++y) {
+            for (int x{currentExtent.x}; x <= currentExtent.xMax(); ++x) {
+                // If this chunk isn't in range of the previous chunk and we 
+                // haven't already prefetched it, add it.
+                ChunkPosition chunkPosition{x, y, z};
+                if (!(previousExtent.containsPosition(chunkPosition))
+                    && !wasPrefetched(chunkPosition)) {
+                    outChunks.push_back(chunkPosition);
+                }
+            }
+        }
+    }
+
+    // Sort the new chunks so the nearest ones are requested first.
+    sortByDistance({(outChunks.begin() + startIndex), outChunks.end()},
+                   position);
+}
+
+void ChunkPrefetcher::getChunksToPrefetch(const Position& position,
+                                          const Position& previousPosition,
+                                          const ChunkExtent& mapChunkExtent,
+                                          std::vector<ChunkPosition>& outChunks)
+{
+    static constexpr float LOOKAHEAD_TICKS{
+        static_cast<float>(Config::CHUNK_PREFETCH_LOOKAHEAD_S
+                           / SharedConfig::SIM_TICK_TIMESTEP_S)};
+
+    // If we aren't moving, there's nothing to predict.
+    Position velocity{position - previousPosition};
+    if ((velocity.x == 0) && (velocity.y == 0)) {
+        return;
+    }
+
+    // If we won't leave our current chunk within the lookahead time, 
+    // there's nothing to prefetch.
+    Position predictedPosition{position.x + (velocity.x * LOOKAHEAD_TICKS),
+                               position.y + (velocity.y * LOOKAHEAD_TICKS),
+                               position.z};
+    ChunkPosition currentChunk{position.asChunkPosition()};
+    ChunkPosition predictedChunk{predictedPosition.asChunkPosition()};
+    if (predictedChunk == currentChunk) {
+        return;
+    }
+
+    // Add any chunks that will be in range of the predicted chunk, that 
+    // aren't in range now and haven't already been prefetched.
+    ChunkExtent currentExtent{getInRangeExtent(currentChunk, mapChunkExtent)};
+    ChunkExtent predictedExtent{
+        getInRangeExtent(predictedChunk, mapChunkExtent)};
+    std::size_t startIndex{outChunks.size()};
+    for (int z{predictedExtent.z}; z <= predictedExtent.zMax(); ++z) {
+        for (int y{predictedExtent.y}; y <= predictedExtent.yMax(); ++y) {
+            for (int x{predictedExtent.x}; x <= predictedExtent.xMax(); ++x) {
+                ChunkPosition chunkPosition{x, y, z};
+                if (!(currentExtent.containsPosition(chunkPosition))
+                    && !wasPrefetched(chunkPosition)) {
+                    outChunks.push_back(chunkPosition);
+                    prefetchedChunks.push_back(chunkPosition);
+                }
+            }
+        }
+    }
+
+    // Sort the new chunks so the nearest ones are requested first.
+    sortByDistance({(outChunks.begin() + startIndex), outChunks.end()},
+                   position);
+}
+
+bool ChunkPrefetcher::wasPrefetched(const ChunkPosition& chunkPosition) const
+{
+    return std::find(prefetchedChunks.begin(), prefetchedChunks.end(),
+                     chunkPosition)
+           != prefetchedChunks.end();
+}
+
+void ChunkPrefetcher::forget(const ChunkPosition& chunkPosition)
+{
+    std::erase(prefetchedChunks, chunkPosition);
+}
+
+void ChunkPrefetcher::reset()
+{
+    prefetchedChunks.clear();
+}
+
+} // namespace Client
+} // namespace AM
@@ -8,11 +8,18 @@
 #include "ChunkExtent.h"
 #include "ChunkDataRequest.h"
 #include "ChunkWireSnapshot.h"
+#include "ChunkCache.h"
+#include "ChunkPrefetcher.h"
+#include "Serialize.h"
+#include "Deserialize.h"
+#include "Paths.h"
 #include "Morton.h"
 #include "SharedConfig.h"
 #include "Config.h"
 #include "Log.h"
+#include <algorithm>
 #include <memory>
+#include <filesystem>
 
 namespace AM
 {
@@ -22,7 +29,22 @@ ChunkUpdateSystem::ChunkUpdateSystem(World& inWorld, Network& inNetwork)
 : world{inWorld}
 , network{inNetwork}
 , chunkUpdateQueue{network.getEventDispatcher()}
+, chunkPrefetcher{}
+, workChunks{}
+, evictedChunks{}
+, chunkCache{}
+, chunkCacheLru{}
+, chunkCacheBytes{0}
+, cachedSnapshots{}
+, cachedPositions{}
 {
+    // Load all chunks from ChunkCache.bin.
+    loadChunkCache();
+}
+
+ChunkUpdateSystem::~ChunkUpdateSystem()
+{
+    saveChunkCache();
 }
 
 void ChunkUpdateSystem::updateChunks()
@@ -32,6 +54,9 @@ void ChunkUpdateSystem::updateChunks()
 
     // Process any received chunk updates.
     receiveAndApplyUpdates();
+
+    // If we're over our memory budget, evict unused chunks.
+    evictUnusedChunks();
 }
 
 void ChunkUpdateSystem::requestNeededUpdates()
@@ -41,122 +66,255 @@ void ChunkUpdateSystem::requestNeededUpdates()
     PreviousPosition& previousPosition{
         registry.get<PreviousPosition>(world.playerEntity)};
 
+    const ChunkExtent& mapChunkExtent{world.tileMap.getChunkExtent()};
+
     // If we're flagged as needing to load all adjacent chunks, request them.
     if (registry.all_of<NeedsAdjacentChunks>(world.playerEntity)) {
-        requestAllInRangeChunks(currentPosition.asChunkPosition());
+        workChunks.clear();
+        chunkPrefetcher.getAllInRangeChunks(currentPosition, mapChunkExtent,
+                                            workChunks);
+        sendRequest(workChunks);
+        touchInRangeChunks(currentPosition);
 
         registry.remove<NeedsAdjacentChunks>(world.playerEntity);
     }
-    // If we moved, check if we're in range of any new chunks.
+    // If we moved, request any chunks that we're now in range of or are 
+    // about to be in range of.
     else if (previousPosition != currentPosition) {
-        // If we moved into a new chunk.
-        ChunkPosition previousChunk{previousPosition.asChunkPosition()};
-        ChunkPosition currentChunk{currentPosition.asChunkPosition()};
-        if (previousChunk != currentChunk) {
-            // Request the chunks that we're now in range of.
-            requestNewInRangeChunks(previousChunk, currentChunk);
+        workChunks.clear();
+        bool enteredNewChunk{chunkPrefetcher.getChunksToRequest(
+            currentPosition, previousPosition, mapChunkExtent, workChunks)};
+        sendRequest(workChunks);
+
+        if (enteredNewChunk) {
+            touchInRangeChunks(currentPosition);
         }
     }
 }
 
-void ChunkUpdateSystem::requestAllInRangeChunks(
-    const ChunkPosition& currentChunk)
+void ChunkUpdateSystem::sendRequest(const std::vector<ChunkPosition>& chunks)
 {
-    // Determine which chunks are in range of the given position.
-    // Note: The range is hardcoded to be all chunks directly surrounding the 
-    //       given chunk in the X/Y directions, and every chunk along the Z 
-    //       axis.
-    const ChunkExtent& mapChunkExtent{world.tileMap.getChunkExtent()};
-    ChunkExtent currentExtent{
-        (currentChunk.x - 1),  (currentChunk.y - 1), mapChunkExtent.z, 3, 3,
-        mapChunkExtent.zLength};
-
-    // Bound the range to the map boundaries.
-    currentExtent.intersectWith(mapChunkExtent);
+    if (chunks.empty()) {
+        return;
+    }
 
-    // Iterate over the range, adding all chunks to a request.
     ChunkDataRequest chunkDataRequest{};
-    for (int i{0}; i < currentExtent.zLength; ++i) {
-        for (int j{0}; j < currentExtent.yLength; ++j) {
-            for (int k{0}; k < currentExtent.xLength; ++k) {
-                int chunkX{currentExtent.x + k};
-                int chunkY{currentExtent.y + j};
-                int chunkZ{currentExtent.z + i};
-                chunkDataRequest.requestedChunks.emplace_back(chunkX, chunkY,
-                                                              chunkZ);
-            }
-        }
+    for (const ChunkPosition& chunkPosition : chunks) {
+        addToRequest(chunkPosition, chunkDataRequest);
     }
 
-    // Send the request.
     network.serializeAndSend(chunkDataRequest);
 }
 
-void ChunkUpdateSystem::requestNewInRangeChunks(
-    const ChunkPosition& previousChunk, const ChunkPosition& currentChunk)
+void ChunkUpdateSystem::receiveAndApplyUpdates()
 {
-    // Determine which chunks are in range of each chunk position.
-    // Note: The range is hardcoded to be all chunks directly surrounding the 
-    //       given chunk in the X/Y directions, and every chunk in the Z 
-    //       direction.
-    const ChunkExtent& mapChunkExtent{world.tileMap.getChunkExtent()};
-    ChunkExtent previousExtent{
-        (previousChunk.x - 1), (previousChunk.y - 1), 0, 3, 3,
-        mapChunkExtent.zLength};
-    ChunkExtent currentExtent{
-        (currentChunk.x - 1),  (currentChunk.y - 1), 0, 3, 3,
-        mapChunkExtent.zLength};
-
-    // Bound each range to the map boundaries.
-    previousExtent.intersectWith(mapChunkExtent);
-    currentExtent.intersectWith(mapChunkExtent);
-
-    // Iterate over the current extent, adding any new chunks to a request.
-    ChunkDataRequest chunkDataRequest;
-    for (int z{0}; z < currentExtent.zLength; ++z) {
-        for (int y{0}; y < currentExtent.yLength; ++y) {
-            for (int x{0}; x < currentExtent.xLength; ++x) {
-                // If this chunk isn't in range of the previous chunk, add it.
-                ChunkPosition chunkPosition{currentExtent.x + x,
-                                            currentExtent.y + y,
-                                            currentExtent.z + z};
-
-                if (!(previousExtent.containsPosition(chunkPosition))) {
-                    chunkDataRequest.requestedChunks.emplace_back(
-                        chunkPosition.x, chunkPosition.y, chunkPosition.z);
-                }
+    // Process any received chunk updates.
+    // Note: The chunks in each update are built in parallel. Collision is 
+    //       built along with them, so there's nothing to rebuild after.
+    std::shared_ptr<const ChunkUpdate> receivedUpdate{nullptr};
+    while (chunkUpdateQueue.pop(receivedUpdate)) {
+        // Load any unchanged chunks from the cache.
+        // Note: We do this before caching the new chunks, since doing so may 
+        //       trim the cache.
+        cachedSnapshots.clear();
+        cachedPositions.clear();
+        workChunks.clear();
+        for (const ChunkPosition& chunkPosition :
+             receivedUpdate->unchangedChunks) {
+            if (const ChunkWireSnapshot*
+                    chunkSnapshot{useCachedChunk(chunkPosition)}) {
+                cachedSnapshots.push_back(chunkSnapshot);
+                cachedPositions.push_back(chunkPosition);
+            }
+            else {
+                // The chunk was dropped from the cache after we requested 
+                // it. Request it again, this time without a version.
+                workChunks.push_back(chunkPosition);
+            }
+        }
+        world.tileMap.loadChunks(cachedSnapshots, cachedPositions,
+                                 world.threadPool);
+        for (const ChunkPosition& chunkPosition : cachedPositions) {
+            world.tileMap.trackChunk(chunkPosition);
+        }
+        sendRequest(workChunks);
+
+        world.tileMap.loadChunks(receivedUpdate->chunks, world.threadPool);
+
+        // Cache the new chunks and start tracking their memory usage. If a 
+        // chunk is empty, it no longer exists on the server, so we don't 
+        // need to cache it.
+        for (const ChunkWireSnapshot& chunkSnapshot : receivedUpdate->chunks) {
+            ChunkPosition chunkPosition{chunkSnapshot.x, chunkSnapshot.y,
+                                        chunkSnapshot.z};
+            world.tileMap.trackChunk(chunkPosition);
+            if (chunkSnapshot.tileLayers.empty()) {
+                uncacheChunk(chunkPosition);
+            }
+            else {
+                cacheChunk(chunkSnapshot);
             }
         }
     }
+}
 
-    // Send the request.
-    network.serializeAndSend(chunkDataRequest);
+void ChunkUpdateSystem::touchInRangeChunks(const Position& currentPosition)
+{
+    world.tileMap.touchChunks(ChunkPrefetcher::getInRangeExtent(
+        currentPosition.asChunkPosition(), world.tileMap.getChunkExtent()));
 }
 
-void ChunkUpdateSystem::receiveAndApplyUpdates()
+void ChunkUpdateSystem::evictUnusedChunks()
 {
-    // Disable auto collision rebuild (it's more efficient to do it all after).
-    world.tileMap.setAutoRebuildCollision(false);
+    // Evict chunks, keeping any that are in range of the player.
+    const Position& currentPosition{
+        world.registry.get<Position>(world.playerEntity)};
+    ChunkExtent keepExtent{ChunkPrefetcher::getInRangeExtent(
+        currentPosition.asChunkPosition(), world.tileMap.getChunkExtent())};
+    evictedChunks.clear();
+    world.tileMap.evictChunks(keepExtent, evictedChunks);
 
-    // Process any received chunk updates.
-    std::shared_ptr<const ChunkUpdate> receivedUpdate{nullptr};
-    while (chunkUpdateQueue.pop(receivedUpdate)) {
-        // Apply all chunk snapshots from the update to our map.
-        for (const ChunkWireSnapshot& chunk : receivedUpdate->chunks) {
-            applyChunkSnapshot(chunk);
-        }
+    // If we evicted a chunk that was prefetched, it needs to be re-requested 
+    // when we come in range of it.
+    // Note: Evicted chunks stay in chunkCache until it runs out of budget, so 
+    //       re-requesting them will usually just get us an "unchanged" 
+    //       response.
+    for (const ChunkPosition& chunkPosition : evictedChunks) {
+        chunkPrefetcher.forget(chunkPosition);
+    }
+}
+
+void ChunkUpdateSystem::cacheChunk(ChunkWireSnapshot chunkSnapshot)
+{
+    // Add or replace the snapshot, and move it to the front.
+    ChunkPosition chunkPosition{chunkSnapshot.x, chunkSnapshot.y,
+                                chunkSnapshot.z};
+    auto [cacheIt, wasInserted]{chunkCache.try_emplace(chunkPosition)};
+    CachedChunk& cachedChunk{cacheIt->second};
+    if (wasInserted) {
+        chunkCacheLru.push_front(chunkPosition);
+        cachedChunk.lruIt = chunkCacheLru.begin();
     }
+    else {
+        chunkCacheLru.splice(chunkCacheLru.begin(), chunkCacheLru,
+                             cachedChunk.lruIt);
+        chunkCacheBytes -= cachedChunk.bytes;
+    }
+
+    cachedChunk.snapshot = std::move(chunkSnapshot);
+    cachedChunk.bytes = getSnapshotMemoryUsage(cachedChunk.snapshot);
+    chunkCacheBytes += cachedChunk.bytes;
+
+    trimChunkCache();
+}
+
+const ChunkWireSnapshot*
+    ChunkUpdateSystem::useCachedChunk(const ChunkPosition& chunkPosition)
+{
+    auto cacheIt{chunkCache.find(chunkPosition)};
+    if (cacheIt == chunkCache.end()) {
+        return nullptr;
+    }
+
+    chunkCacheLru.splice(chunkCacheLru.begin(), chunkCacheLru,
+                         cacheIt->second.lruIt);
+    return &(cacheIt->second.snapshot);
+}
 
-    // Re-enable auto collision rebuild (rebuilds any dirty tiles).
-    world.tileMap.setAutoRebuildCollision(true);
+void ChunkUpdateSystem::uncacheChunk(const ChunkPosition& chunkPosition)
+{
+    auto cacheIt{chunkCache.find(chunkPosition)};
+    if (cacheIt != chunkCache.end()) {
+        chunkCacheBytes -= cacheIt->second.bytes;
+        chunkCacheLru.erase(cacheIt->second.lruIt);
+        chunkCache.erase(cacheIt);
+    }
 }
 
-void ChunkUpdateSystem::applyChunkSnapshot(
+void ChunkUpdateSystem::trimChunkCache()
+{
+    // Note: We always keep the most recently used chunk, even if it's over 
+    //       budget on its own.
+    while ((chunkCacheBytes > Config::CHUNK_CACHE_BUDGET_BYTES)
+           && (chunkCacheLru.size() > 1)) {
+        uncacheChunk(chunkCacheLru.back());
+    }
+}
+
+std::size_t ChunkUpdateSystem::getSnapshotMemoryUsage(
     const ChunkWireSnapshot& chunkSnapshot)
 {
-    // Load the chunk snapshot into our map.
-    world.tileMap.loadChunk(
-        chunkSnapshot, {chunkSnapshot.x, chunkSnapshot.y, chunkSnapshot.z});
+    // Note: Like TileMap's chunk tracking, this ignores allocator and hash 
+    //       node overhead.
+    return sizeof(CachedChunk)
+           + (chunkSnapshot.palette.capacity()
+              * sizeof(ChunkWireSnapshot::PaletteEntry))
+           + (chunkSnapshot.tileLayers.capacity() * sizeof(Uint8))
+           + (chunkSnapshot.tileOffsets.capacity() * sizeof(TileOffset));
+}
+
+void ChunkUpdateSystem::addToRequest(const ChunkPosition& chunkPosition,
+                                     ChunkDataRequest& chunkDataRequest)
+{
+    // If we have the chunk cached, send its version and mark it as the most 
+    // recently used, so it's still cached if the server says it's unchanged.
+    Uint64 knownVersion{0};
+    if (const ChunkWireSnapshot*
+            chunkSnapshot{useCachedChunk(chunkPosition)}) {
+        knownVersion = chunkSnapshot->version;
+    }
+
+    chunkDataRequest.requestedChunks.emplace_back(chunkPosition, knownVersion);
+}
+
+void ChunkUpdateSystem::loadChunkCache()
+{
+    // If the cache doesn't exist, return early.
+    std::string cachePath{Paths::BASE_PATH + "ChunkCache.bin"};
+    if (!std::filesystem::exists(cachePath)) {
+        return;
+    }
+
+    // Deserialize the chunk cache.
+    // Note: Unlike the item cache, a bad chunk cache isn't fatal. We can 
+    //       just re-download the chunks.
+    ChunkCache cache{};
+    if (!(Deserialize::fromFile(cachePath, cache))) {
+        LOG_INFO("Failed to deserialize chunk cache. Ignoring it.");
+        return;
+    }
+
+    // Note: The chunks were saved from most to least recently used, so we 
+    //       add them in reverse to restore that order.
+    for (auto it{cache.chunks.rbegin()}; it != cache.chunks.rend(); ++it) {
+        cacheChunk(std::move(*it));
+    }
+}
+
+void ChunkUpdateSystem::saveChunkCache()
+{
+    // Gather the cached chunks, from most to least recently used.
+    // Note: The file can only hold ChunkCache::MAX_CHUNKS, so if we have 
+    //       more than that, we drop the least recently used ones.
+    ChunkCache cache{};
+    cache.chunks.reserve(
+        std::min(chunkCacheLru.size(), ChunkCache::MAX_CHUNKS));
+    for (const ChunkPosition& chunkPosition : chunkCacheLru) {
+        if (cache.chunks.size() == ChunkCache::MAX_CHUNKS) {
+            break;
+        }
+
+        cache.chunks.push_back(
+            std::move(chunkCache.at(chunkPosition).snapshot));
+    }
+    chunkCache.clear();
+    chunkCacheLru.clear();
+    chunkCacheBytes = 0;
+
+    // Serialize the chunk cache and write it into a file.
+    if (!(Serialize::toFile((Paths::BASE_PATH + "ChunkCache.bin"), cache))) {
+        LOG_INFO("Failed to save the chunk cache.");
+    }
 }
 
 } // namespace Client
@@ -7,11 +7,14 @@
 #include "Deserialize.h"
 #include "ByteTools.h"
 #include "TileMapSnapshot.h"
+#include "Chunk.h"
+#include "BoundingBox.h"
 #include "Config.h"
 #include "SharedConfig.h"
 #include "Timer.h"
 #include "Log.h"
 #include "AMAssert.h"
+#include "tracy/Tracy.hpp"
 
 namespace AM
 {
@@ -19,6 +22,9 @@ namespace Client
 {
 TileMap::TileMap(GraphicData& inGraphicData)
 : TileMapBase{inGraphicData, false}
+, chunkLru{}
+, chunkUsage{}
+, residentChunkBytes{0}
 , sizeChangedSig{}
 , sizeChanged{sizeChangedSig}
 {
@@ -55,5 +61,115 @@ void TileMap::setMapSize(Uint16 inMapXLengthChunks, Uint16 inMapYLengthChunks,
     sizeChangedSig.publish(tileExtent);
 }
 
+void TileMap::trackChunk(const ChunkPosition& chunkPosition)
+{
+    // If the chunk doesn't exist, make sure we aren't tracking it.
+    auto chunkIt{chunks.find(chunkPosition)};
+    if (chunkIt == chunks.end()) {
+        untrackChunk(chunkPosition);
+        return;
+    }
+
+    // Add or update the chunk's usage info, and move it to the front.
+    auto [usageIt, wasInserted]{chunkUsage.try_emplace(chunkPosition)};
+    ChunkUsage& usage{usageIt->second};
+    if (wasInserted) {
+        chunkLru.push_front(chunkPosition);
+        usage.lruIt = chunkLru.begin();
+    }
+    else {
+        chunkLru.splice(chunkLru.begin(), chunkLru, usage.lruIt);
+        residentChunkBytes -= usage.bytes;
+    }
+
+    usage.bytes = getChunkMemoryUsage(chunkIt->second);
+    residentChunkBytes += usage.bytes;
+}
+
+void TileMap::touchChunks(const ChunkExtent& extent)
+{
+    for (int z{extent.z}; z <= extent.zMax(); ++z) {
+        for (int y{extent.y}; y <= extent.yMax(); ++y) {
+            for (int x{extent.x}; x <= extent.xMax(); ++x) {
+                auto usageIt{chunkUsage.find({x, y, z})};
+                if (usageIt != chunkUsage.end()) {
+                    chunkLru.splice(chunkLru.begin(), chunkLru,
+                                    usageIt->second.lruIt);
+                }
+            }
+        }
+    }
+}
+
+void TileMap::evictChunks(const ChunkExtent& keepExtent,
+                          std::vector<ChunkPosition>& outEvictedChunks)
+{
+    ZoneScoped;
+
+    // Walk from the least recently used chunk, evicting until we're under 
+    // budget.
+    // Note: Tile updates may erase a chunk without us knowing, so we also 
+    //       drop any tracked chunks that no longer exist.
+    auto lruIt{chunkLru.end()};
+    while ((residentChunkBytes > Config::CHUNK_MEMORY_BUDGET_BYTES)
+           && (lruIt != chunkLru.begin())) {
+        --lruIt;
+        ChunkPosition chunkPosition{*lruIt};
+        if (keepExtent.containsPosition(chunkPosition)
+            && chunks.contains(chunkPosition)) {
+            continue;
+        }
+
+        // Step forward before erasing, so our iterator stays valid.
+        ++lruIt;
+        if (chunks.erase(chunkPosition) > 0) {
+            outEvictedChunks.push_back(chunkPosition);
+        }
+        untrackChunk(chunkPosition);
+    }
+
+    TracyPlot("Resident chunks",
+              static_cast<int64_t>(getResidentChunkCount()));
+    TracyPlot("Resident chunk bytes",
+              static_cast<int64_t>(getResidentChunkBytes()));
+}
+
+std::size_t TileMap::getResidentChunkCount() const
+{
+    return chunkUsage.size();
+}
+
+std::size_t TileMap::getResidentChunkBytes() const
+{
+    return residentChunkBytes;
+}
+
+std::size_t TileMap::getChunkMemoryUsage(const Chunk& chunk)
+{
+    // Note: This ignores allocator and hash node overhead, so it's an 
+    //       underestimate. It's only used for budgeting, so that's fine.
+    std::size_t bytes{sizeof(Chunk)};
+    for (const Tile& tile : chunk.tiles) {
+        bytes += (tile.getAllLayers().capacity() * sizeof(TileLayer));
+        bytes
+            += (tile.getCollisionVolumes().capacity() * sizeof(BoundingBox));
+    }
+
+    // The collision index stores 6 floats per volume.
+    bytes += (chunk.collisionIndex.getVolumeCount() * 6 * sizeof(float));
+
+    return bytes;
+}
+
+void TileMap::untrackChunk(const ChunkPosition& chunkPosition)
+{
+    auto usageIt{chunkUsage.find(chunkPosition)};
+    if (usageIt != chunkUsage.end()) {
+        residentChunkBytes -= usageIt->second.bytes;
+        chunkLru.erase(usageIt->second.lruIt);
+        chunkUsage.erase(usageIt);
+    }
+}
+
 } // End namespace Client
 } // End namespace AM
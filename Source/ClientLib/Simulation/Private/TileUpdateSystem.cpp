@@ -2,6 +2,7 @@
 #include "World.h"
 #include "Network.h"
 #include "AMAssert.h"
+#include <algorithm>
 #include <variant>
 
 namespace AM
@@ -11,10 +12,8 @@ namespace Client
 TileUpdateSystem::TileUpdateSystem(World& inWorld, Network& inNetwork)
 : world{inWorld}
 , network{inNetwork}
-, addLayerQueue{network.getEventDispatcher()}
-, removeLayerQueue{network.getEventDispatcher()}
-, clearLayersQueue{network.getEventDispatcher()}
-, extentClearLayersQueue{network.getEventDispatcher()}
+, updateBatchQueue{network.getEventDispatcher()}
+, updatedChunks{}
 {
 }
 
@@ -23,78 +22,106 @@ void TileUpdateSystem::updateTiles()
     // Disable auto collision rebuild (it's more efficient to do it all after).
     world.tileMap.setAutoRebuildCollision(false);
 
-    // Process any waiting tile updates from the server.
-    TileClearLayers tileClearLayers{};
-    while (clearLayersQueue.pop(tileClearLayers)) {
-        clearTileLayers(tileClearLayers);
+    // Process any waiting tile updates from the server, in the order that 
+    // they occurred.
+    updatedChunks.clear();
+    TileUpdateBatch updateBatch{};
+    while (updateBatchQueue.pop(updateBatch)) {
+        for (const TileUpdateBatch::UpdateVariant& update :
+             updateBatch.updates) {
+            if (const auto* layerRun{
+                    std::get_if<TileUpdateBatch::LayerRun>(&update)}) {
+                applyLayerRun(*layerRun);
+            }
+            else if (const auto* clearLayers{
+                         std::get_if<TileClearLayers>(&update)}) {
+                clearTileLayers(*clearLayers);
+            }
+            else if (const auto* extentClearLayers{
+                         std::get_if<TileExtentClearLayers>(&update)}) {
+                clearExtentLayers(*extentClearLayers);
+            }
+        }
     }
 
-    TileExtentClearLayers tileExtentClearLayers{};
-    while (extentClearLayersQueue.pop(tileExtentClearLayers)) {
-        clearExtentLayers(tileExtentClearLayers);
-    }
+    // Re-enable auto collision rebuild (rebuilds any dirty tiles).
+    world.tileMap.setAutoRebuildCollision(true);
 
-    TileAddLayer tileAddLayer{};
-    while (addLayerQueue.pop(tileAddLayer)) {
-        addTileLayer(tileAddLayer);
+    // Update the memory tracking of each chunk that we touched (including 
+    // any that were created or erased).
+    std::sort(updatedChunks.begin(), updatedChunks.end());
+    auto lastIt{std::unique(updatedChunks.begin(), updatedChunks.end())};
+    for (auto it{updatedChunks.begin()}; it != lastIt; ++it) {
+        world.tileMap.trackChunk(*it);
     }
+}
 
-    TileRemoveLayer tileRemoveLayer{};
-    while (removeLayerQueue.pop(tileRemoveLayer)) {
-        remTileLayer(tileRemoveLayer);
-    }
+void TileUpdateSystem::applyLayerRun(const TileUpdateBatch::LayerRun& layerRun)
+{
+    for (int i{0}; i < layerRun.length; ++i) {
+        TilePosition tilePosition{layerRun.getPosition(i)};
+        ChunkPosition chunkPosition{tilePosition};
+        if (updatedChunks.empty() || (updatedChunks.back() != chunkPosition)) {
+            updatedChunks.push_back(chunkPosition);
+        }
 
-    // Re-enable auto collision rebuild (rebuilds any dirty tiles).
-    world.tileMap.setAutoRebuildCollision(true);
+        if (layerRun.operation == TileUpdateBatch::LayerRun::Operation::Add) {
+            addTileLayer(layerRun, tilePosition);
+        }
+        else {
+            remTileLayer(layerRun, tilePosition);
+        }
+    }
 }
 
-void TileUpdateSystem::addTileLayer(const TileAddLayer& addLayerRequest)
+void TileUpdateSystem::addTileLayer(
+    const TileUpdateBatch::LayerRun& layerRun, const TilePosition& tilePosition)
 {
-    if (addLayerRequest.layerType == TileLayer::Type::Terrain) {
+    if (layerRun.layerType == TileLayer::Type::Terrain) {
         world.tileMap.addTerrain(
-            addLayerRequest.tilePosition, addLayerRequest.graphicSetID,
-            static_cast<Terrain::Value>(addLayerRequest.graphicValue));
+            tilePosition, layerRun.graphicSetID,
+            static_cast<Terrain::Value>(layerRun.graphicValue));
     }
-    else if (addLayerRequest.layerType == TileLayer::Type::Floor) {
+    else if (layerRun.layerType == TileLayer::Type::Floor) {
         world.tileMap.addFloor(
-            addLayerRequest.tilePosition, addLayerRequest.tileOffset,
-            addLayerRequest.graphicSetID,
-            static_cast<Rotation::Direction>(addLayerRequest.graphicValue));
+            tilePosition, layerRun.tileOffset,
+            layerRun.graphicSetID,
+            static_cast<Rotation::Direction>(layerRun.graphicValue));
     }
-    else if (addLayerRequest.layerType == TileLayer::Type::Wall) {
+    else if (layerRun.layerType == TileLayer::Type::Wall) {
         world.tileMap.addWall(
-            addLayerRequest.tilePosition, addLayerRequest.graphicSetID,
-            static_cast<Wall::Type>(addLayerRequest.graphicValue));
+            tilePosition, layerRun.graphicSetID,
+            static_cast<Wall::Type>(layerRun.graphicValue));
     }
-    else if (addLayerRequest.layerType == TileLayer::Type::Object) {
+    else if (layerRun.layerType == TileLayer::Type::Object) {
         world.tileMap.addObject(
-            addLayerRequest.tilePosition, addLayerRequest.tileOffset,
-            addLayerRequest.graphicSetID,
-            static_cast<Rotation::Direction>(addLayerRequest.graphicValue));
+            tilePosition, layerRun.tileOffset,
+            layerRun.graphicSetID,
+            static_cast<Rotation::Direction>(layerRun.graphicValue));
     }
 }
 
-void TileUpdateSystem::remTileLayer(const TileRemoveLayer& remLayerRequest)
+void TileUpdateSystem::remTileLayer(
+    const TileUpdateBatch::LayerRun& layerRun, const TilePosition& tilePosition)
 {
-    if (remLayerRequest.layerType == TileLayer::Type::Terrain) {
-        world.tileMap.remTerrain(remLayerRequest.tilePosition);
+    if (layerRun.layerType == TileLayer::Type::Terrain) {
+        world.tileMap.remTerrain(tilePosition);
     }
-    else if (remLayerRequest.layerType == TileLayer::Type::Floor) {
+    else if (layerRun.layerType == TileLayer::Type::Floor) {
         world.tileMap.remFloor(
-            remLayerRequest.tilePosition, remLayerRequest.tileOffset,
-            remLayerRequest.graphicSetID,
-            static_cast<Rotation::Direction>(remLayerRequest.graphicValue));
+            tilePosition, layerRun.tileOffset,
+            layerRun.graphicSetID,
+            static_cast<Rotation::Direction>(layerRun.graphicValue));
     }
-    else if (remLayerRequest.layerType == TileLayer::Type::Wall) {
-        world.tileMap.remWall(
-            remLayerRequest.tilePosition,
-            static_cast<Wall::Type>(remLayerRequest.graphicValue));
+    else if (layerRun.layerType == TileLayer::Type::Wall) {
+        world.tileMap.remWall(tilePosition,
+                              static_cast<Wall::Type>(layerRun.graphicValue));
     }
-    else if (remLayerRequest.layerType == TileLayer::Type::Object) {
+    else if (layerRun.layerType == TileLayer::Type::Object) {
         world.tileMap.remObject(
-            remLayerRequest.tilePosition, remLayerRequest.tileOffset,
-            remLayerRequest.graphicSetID,
-            static_cast<Rotation::Direction>(remLayerRequest.graphicValue));
+            tilePosition, layerRun.tileOffset,
+            layerRun.graphicSetID,
+            static_cast<Rotation::Direction>(layerRun.graphicValue));
     }
 }
 
@@ -103,13 +130,27 @@ void TileUpdateSystem::clearTileLayers(
 {
     world.tileMap.clearTileLayers(clearLayersRequest.tilePosition,
                                   clearLayersRequest.layerTypesToClear);
+    updatedChunks.emplace_back(clearLayersRequest.tilePosition);
 }
 
 void TileUpdateSystem::clearExtentLayers(
     const TileExtentClearLayers& clearExtentLayersRequest)
 {
-    world.tileMap.clearExtentLayers(clearExtentLayersRequest.tileExtent,
+    const TileExtent& tileExtent{clearExtentLayersRequest.tileExtent};
+    world.tileMap.clearExtentLayers(tileExtent,
                                     clearExtentLayersRequest.layerTypesToClear);
+
+    ChunkPosition minChunk{
+        TilePosition{tileExtent.x, tileExtent.y, tileExtent.z}};
+    ChunkPosition maxChunk{
+        TilePosition{tileExtent.xMax(), tileExtent.yMax(), tileExtent.zMax()}};
+    for (int z{minChunk.z}; z <= maxChunk.z; ++z) {
+        for (int y{minChunk.y}; y <= maxChunk.y; ++y) {
+            for (int x{minChunk.x}; x <= maxChunk.x; ++x) {
+                updatedChunks.emplace_back(x, y, z);
+            }
+        }
+    }
 }
 
 } // End namespace Client
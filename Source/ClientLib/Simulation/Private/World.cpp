@@ -10,6 +10,7 @@ World::World(GraphicData& graphicData)
 : registry{}
 , itemData{}
 , playerEntity{entt::null}
+, threadPool{}
 , tileMap{graphicData}
 , entityLocator{registry}
 {
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "ChunkPosition.h"
+#include "ChunkExtent.h"
+#include <vector>
+#include <span>
+
+namespace AM
+{
+struct Position;
+
+namespace Client
+{
+/**
+ * Decides which chunks to request as the player moves. Along with the chunks 
+ * that the player just came in range of, predicts which chunks the player is 
+ * about to come in range of, so they can be requested before the player 
+ * actually crosses into a new chunk.
+ *
+ * The prediction extrapolates the player's current velocity (the distance 
+ * they moved in the last tick) by Config::CHUNK_PREFETCH_LOOKAHEAD_S.
+ *
+ * Note: This doesn't touch the world or network, so test sandboxes can 
+ *       drive it the same way that ChunkUpdateSystem does.
+ */
+class ChunkPrefetcher
+{
+public:
+    /**
+     * Returns the extent of chunks that are in range of the given chunk.
+     * Note: The range is hardcoded to be all chunks directly surrounding the 
+     *       given chunk in the X/Y directions, and every chunk along the Z 
+     *       axis.
+     */
+    static ChunkExtent getInRangeExtent(const ChunkPosition& chunkPosition,
+                                        const ChunkExtent& mapChunkExtent);
+
+    /**
+     * Returns the squared distance, in world units, between the given 
+     * position and the center of the given chunk.
+     */
+    static float getSquaredDistance(const Position& position,
+                                    const ChunkPosition& chunkPosition);
+
+    /**
+     * Sorts the given chunks from nearest to furthest from the given 
+     * position.
+     */
+    static void sortByDistance(std::span<ChunkPosition> chunks,
+                               const Position& position);
+
+    /**
+     * Pushes every chunk that's in range of the given position into 
+     * outChunks, sorted by distance, and forgets any prefetched chunks.
+     * Used when the player needs all of their in-range chunks (e.g. after 
+     * connecting).
+     */
+    void getAllInRangeChunks(const Position& position,
+                             const ChunkExtent& mapChunkExtent,
+                             std::vector<ChunkPosition>& outChunks);
+
+    /**
+     * Pushes the chunks that should be requested after the player moved 
+     * from previousPosition to position into outChunks.
+     *
+     * If the player crossed into a new chunk, pushes the chunks that just 
+     * came in range (see getNewInRangeChunks()), then forgets the prefetched 
+     * chunks. Then, pushes the chunks that the player is about to come in 
+     * range of (see getChunksToPrefetch()).
+     *
+     * @return true if the player crossed into a new chunk, else false.
+     */
+    bool getChunksToRequest(const Position& position,
+                            const Position& previousPosition,
+                            const ChunkExtent& mapChunkExtent,
+                            std::vector<ChunkPosition>& outChunks);
+
+    /**
+     * Pushes the chunks that are in range of the given position but weren't 
+     * in range of previousChunk (skipping any that were already prefetched) 
+     * into outChunks, sorted by distance.
+     */
+    void getNewInRangeChunks(const ChunkPosition& previousChunk,
+                             const Position& position,
+                             const ChunkExtent& mapChunkExtent,
+                             std::vector<ChunkPosition>& outChunks) const;
+
+    /**
+     * Predicts where the player will be, and pushes any chunks that will 
+     * be in range there (but aren't in range now, and haven't already been 
+     * prefetched) into outChunks, sorted by distance.
+     *
+     * @param position  The player's current position.
+     * @param previousPosition  The player's position during the last tick.
+     * @param mapChunkExtent  The map's extent. Results are bound to it.
+     * @param outChunks  The vector to push the chunks into.
+     */
+    void getChunksToPrefetch(const Position& position,
+                             const Position& previousPosition,
+                             const ChunkExtent& mapChunkExtent,
+                             std::vector<ChunkPosition>& outChunks);
+
+    /**
+     * Returns true if the given chunk has been prefetched since the last 
+     * reset().
+     */
+    bool wasPrefetched(const ChunkPosition& chunkPosition) const;
+
+    /**
+     * Forgets that the given chunk was prefetched, so it'll be requested 
+     * again when it comes into range. Used when a chunk is evicted.
+     */
+    void forget(const ChunkPosition& chunkPosition);
+
+    /**
+     * Forgets all prefetched chunks. Should be called after the player 
+     * moves into a new chunk (and the new chunk's requests are built).
+     */
+    void reset();
+
+private:
+    /** The chunks that we've prefetched since the last reset. */
+    std::vector<ChunkPosition> prefetchedChunks;
+};
+
+} // namespace Client
+} // namespace AM
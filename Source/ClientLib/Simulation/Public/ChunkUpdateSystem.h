@@ -2,12 +2,18 @@
 
 #include "QueuedEvents.h"
 #include "ChunkUpdate.h"
+#include "ChunkDataRequest.h"
 #include "ChunkPosition.h"
+#include "ChunkWireSnapshot.h"
+#include "ChunkPrefetcher.h"
 #include <SDL_stdinc.h>
+#include <list>
+#include <unordered_map>
+#include <vector>
 
 namespace AM
 {
-struct ChunkWireSnapshot;
+struct Position;
 
 namespace Client
 {
@@ -18,12 +24,29 @@ class TileMap;
 
 /**
  * Requests needed tile map chunk data, and applies received chunk updates.
+ *
+ * Received chunks are cached along with their server version. When we request 
+ * a chunk that we have cached, we send its version so the server can tell us 
+ * to use our cached copy if it hasn't changed. The cache is saved to 
+ * ChunkCache.bin, so it carries over between sessions. When the cache goes 
+ * over Config::CHUNK_CACHE_BUDGET_BYTES, the least recently used snapshots 
+ * are dropped.
+ *
+ * Chunks that we haven't been near for a while are evicted from the tile map 
+ * when it goes over its memory budget. Evicted chunks are requested again 
+ * through the usual path when they come back in range, and are usually 
+ * served from the cache.
  */
 class ChunkUpdateSystem
 {
 public:
     ChunkUpdateSystem(World& inWorld, Network& inNetwork);
 
+    /**
+     * Saves the chunk cache to ChunkCache.bin.
+     */
+    ~ChunkUpdateSystem();
+
     /**
      * Requests any needed chunk data and applies received chunk updates.
      */
@@ -37,32 +60,78 @@ private:
     void requestNeededUpdates();
 
     /**
-     * Requests all currently in-range chunks from the server.
-     *
-     * @param currentChunk  The chunk that we are currently in.
+     * If the given list isn't empty, sends a request for its chunks.
      */
-    void requestAllInRangeChunks(const ChunkPosition& currentChunk);
+    void sendRequest(const std::vector<ChunkPosition>& chunks);
 
     /**
-     * Determines which chunks we just got in range of and requests them from
-     * the server.
+     * Receives any waiting chunk updates from the queue and applies them
+     * to our tile map.
      *
-     * @param previousChunk  The chunk that we were previously in.
-     * @param currentChunk  The chunk that we are now in.
+     * If an update says a chunk is unchanged but it's no longer in the cache, 
+     * the chunk is requested again without a version.
      */
-    void requestNewInRangeChunks(const ChunkPosition& previousChunk,
-                                 const ChunkPosition& currentChunk);
+    void receiveAndApplyUpdates();
 
     /**
-     * Receives any waiting chunk updates from the queue and applies them
-     * to our tile map.
+     * Marks the chunks in range of the given position as recently used, so 
+     * they'll be the last to be evicted once we move away from them.
      */
-    void receiveAndApplyUpdates();
+    void touchInRangeChunks(const Position& currentPosition);
+
+    /**
+     * If the tile map is over its memory budget, evicts the least recently 
+     * used chunks that aren't in range of the player.
+     */
+    void evictUnusedChunks();
+
+    /**
+     * Adds or replaces the given chunk in the cache and marks it as the most 
+     * recently used, then trims the cache if it's over budget.
+     */
+    void cacheChunk(ChunkWireSnapshot chunkSnapshot);
+
+    /**
+     * If the given chunk is in the cache, marks it as the most recently used 
+     * and returns it. Else, returns nullptr.
+     */
+    const ChunkWireSnapshot* useCachedChunk(const ChunkPosition& chunkPosition);
+
+    /**
+     * Removes the given chunk from the cache, if it's present.
+     */
+    void uncacheChunk(const ChunkPosition& chunkPosition);
 
     /**
-     * Applies the given chunk snapshot's state to our tile map.
+     * Drops the least recently used snapshots until the cache is within 
+     * Config::CHUNK_CACHE_BUDGET_BYTES.
      */
-    void applyChunkSnapshot(const ChunkWireSnapshot& chunkSnapshot);
+    void trimChunkCache();
+
+    /**
+     * Returns the approximate number of bytes used by the given snapshot.
+     */
+    static std::size_t getSnapshotMemoryUsage(
+        const ChunkWireSnapshot& chunkSnapshot);
+
+    /**
+     * Adds the given chunk to the given request, along with our cached 
+     * version of it (if we have one).
+     * If we have one, also marks it as the most recently used.
+     */
+    void addToRequest(const ChunkPosition& chunkPosition,
+                      ChunkDataRequest& chunkDataRequest);
+
+    /**
+     * Loads all chunks from ChunkCache.bin into chunkCache.
+     */
+    void loadChunkCache();
+
+    /**
+     * Saves the most recently used ChunkCache::MAX_CHUNKS chunks from 
+     * chunkCache into ChunkCache.bin.
+     */
+    void saveChunkCache();
 
     /** Used to access the player entity and components. */
     World& world;
@@ -70,6 +139,40 @@ private:
     Network& network;
 
     EventQueue<std::shared_ptr<const ChunkUpdate>> chunkUpdateQueue;
+
+    /** Predicts which chunks we'll need next, so we can request them early. */
+    ChunkPrefetcher chunkPrefetcher;
+
+    /** Used for building lists of chunks to request. */
+    std::vector<ChunkPosition> workChunks;
+
+    /** Used for receiving the chunks that the tile map evicted. */
+    std::vector<ChunkPosition> evictedChunks;
+
+    struct CachedChunk {
+        /** The latest version of the chunk that we've received. */
+        ChunkWireSnapshot snapshot{};
+
+        /** This chunk's position in chunkCacheLru. */
+        std::list<ChunkPosition>::iterator lruIt{};
+
+        /** The approximate number of bytes used by snapshot. */
+        std::size_t bytes{0};
+    };
+
+    /** The chunks that we've received, which may not be in the tile map. */
+    std::unordered_map<ChunkPosition, CachedChunk> chunkCache;
+
+    /** The cached chunks, ordered from most to least recently used. */
+    std::list<ChunkPosition> chunkCacheLru;
+
+    /** The sum of each cached chunk's bytes. */
+    std::size_t chunkCacheBytes;
+
+    /** Used while loading chunks from the cache. Kept around to re-use the 
+        allocations. */
+    std::vector<const ChunkWireSnapshot*> cachedSnapshots;
+    std::vector<ChunkPosition> cachedPositions;
 };
 
 } // namespace Client
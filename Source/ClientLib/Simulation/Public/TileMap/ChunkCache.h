@@ -0,0 +1,32 @@
+#pragma once
+
+#include "ChunkWireSnapshot.h"
+#include <vector>
+
+namespace AM
+{
+namespace Client
+{
+
+/**
+ * Used to save/load ChunkCache.bin.
+ *
+ * Holds a list of versioned chunk snapshots in a serializable form.
+ */
+struct ChunkCache
+{
+    /** The max number of chunks in the cache file. If the in-memory cache 
+        holds more than this, only the most recently used ones are saved. */
+    static constexpr std::size_t MAX_CHUNKS{100000};
+
+    std::vector<ChunkWireSnapshot> chunks{};
+};
+
+template<typename S>
+void serialize(S& serializer, ChunkCache& chunkCache)
+{
+    serializer.container(chunkCache.chunks, ChunkCache::MAX_CHUNKS);
+}
+
+} // End namespace Client
+} // End namespace AM
@@ -3,6 +3,9 @@
 #include "TileMapBase.h"
 #include "entt/signal/sigh.hpp"
 #include <SDL_stdinc.h>
+#include <list>
+#include <unordered_map>
+#include <vector>
 
 namespace AM
 {
@@ -15,6 +18,12 @@ class GraphicData;
  * Tiles are conceptually organized into 16x16 chunks.
  *
  * Tile map data is streamed from the server at runtime.
+ *
+ * To keep memory bounded during long sessions, we track how recently each 
+ * chunk was used. When the resident chunks go over 
+ * Config::CHUNK_MEMORY_BUDGET_BYTES, the least recently used chunks outside 
+ * of the player's range are evicted. Evicted chunks are re-requested (and 
+ * usually served from the chunk cache) when they come back into range.
  */
 class TileMap : public TileMapBase
 {
@@ -32,7 +41,69 @@ public:
     void setMapSize(Uint16 inMapXLengthChunks, Uint16 inMapYLengthChunks,
                     Uint16 inMapZLengthChunks);
 
+    /**
+     * Starts tracking the given chunk's memory usage and marks it as the 
+     * most recently used chunk. Call this after loading a chunk.
+     *
+     * If the chunk doesn't exist (e.g. it was empty), stops tracking it.
+     */
+    void trackChunk(const ChunkPosition& chunkPosition);
+
+    /**
+     * Marks each tracked chunk in the given extent as the most recently used.
+     */
+    void touchChunks(const ChunkExtent& extent);
+
+    /**
+     * If we're over our memory budget, evicts the least recently used chunks 
+     * until we're back under it.
+     *
+     * @param keepExtent  Chunks within this extent won't be evicted.
+     * @param outEvictedChunks  The vector to push evicted chunks into.
+     */
+    void evictChunks(const ChunkExtent& keepExtent,
+                     std::vector<ChunkPosition>& outEvictedChunks);
+
+    /**
+     * Returns the number of chunks that we're tracking.
+     */
+    std::size_t getResidentChunkCount() const;
+
+    /**
+     * Returns the approximate number of bytes used by the chunks that we're 
+     * tracking.
+     */
+    std::size_t getResidentChunkBytes() const;
+
 private:
+    /**
+     * Returns the approximate number of bytes used by the given chunk.
+     */
+    static std::size_t getChunkMemoryUsage(const Chunk& chunk);
+
+    /**
+     * Stops tracking the given chunk.
+     */
+    void untrackChunk(const ChunkPosition& chunkPosition);
+
+    struct ChunkUsage {
+        /** This chunk's position in chunkLru. */
+        std::list<ChunkPosition>::iterator lruIt{};
+
+        /** The approximate number of bytes used by this chunk, as of the 
+            last time it was tracked. */
+        std::size_t bytes{0};
+    };
+
+    /** The tracked chunks, ordered from most to least recently used. */
+    std::list<ChunkPosition> chunkLru;
+
+    /** The usage info for each tracked chunk. */
+    std::unordered_map<ChunkPosition, ChunkUsage> chunkUsage;
+
+    /** The sum of each tracked chunk's bytes. */
+    std::size_t residentChunkBytes;
+
     entt::sigh<void(TileExtent)> sizeChangedSig;
 
 public:
@@ -1,10 +1,9 @@
 #pragma once
 
 #include "QueuedEvents.h"
-#include "TileAddLayer.h"
-#include "TileRemoveLayer.h"
-#include "TileClearLayers.h"
-#include "TileExtentClearLayers.h"
+#include "TileUpdateBatch.h"
+#include "ChunkPosition.h"
+#include <vector>
 
 namespace AM
 {
@@ -29,20 +28,32 @@ public:
     TileUpdateSystem(World& inWorld, Network& inNetwork);
 
     /**
-     * Processes received tile updates, applying them to the tile map.
+     * Processes received tile update batches, applying them to the tile map.
+     * Collision is rebuilt once, after all batches are applied.
+     *
+     * Each updated chunk is then re-tracked by the tile map, so chunks that 
+     * were created by the updates can be evicted, and the memory budget 
+     * reflects any size changes.
      */
     void updateTiles();
 
 private:
     /**
-     * Adds the tile layer to the map.
+     * Adds or removes the run's tile layer to/from each tile in the run.
      */
-    void addTileLayer(const TileAddLayer& addLayer);
+    void applyLayerRun(const TileUpdateBatch::LayerRun& layerRun);
 
     /**
-     * Removes the tile layer from the map.
+     * Adds the tile layer to the given tile.
      */
-    void remTileLayer(const TileRemoveLayer& remLayer);
+    void addTileLayer(const TileUpdateBatch::LayerRun& layerRun,
+                      const TilePosition& tilePosition);
+
+    /**
+     * Removes the tile layer from the given tile.
+     */
+    void remTileLayer(const TileUpdateBatch::LayerRun& layerRun,
+                      const TilePosition& tilePosition);
 
     /**
      * Clears the tile layers from the map.
@@ -60,10 +71,11 @@ private:
     Network& network;
 
     /** Tile updates, received from the network. */
-    EventQueue<TileAddLayer> addLayerQueue;
-    EventQueue<TileRemoveLayer> removeLayerQueue;
-    EventQueue<TileClearLayers> clearLayersQueue;
-    EventQueue<TileExtentClearLayers> extentClearLayersQueue;
+    EventQueue<TileUpdateBatch> updateBatchQueue;
+
+    /** The chunks that were touched by this tick's updates. May contain 
+        duplicates until updateTiles() sorts it. */
+    std::vector<ChunkPosition> updatedChunks;
 };
 
 } // namespace Client
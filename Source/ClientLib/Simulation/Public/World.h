@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ItemData.h"
+#include "ThreadPool.h"
 #include "TileMap.h"
 #include "EntityLocator.h"
 #include "entt/entity/registry.hpp"
@@ -38,6 +39,11 @@ public:
     /** The entity that this client is controlling. */
     entt::entity playerEntity;
 
+    /** Used to split work (e.g. building received chunks) across cores. 
+        Shared so that only one set of worker threads is started.
+        Note: Only use this from the sim thread. See ThreadPool.h. */
+    ThreadPool threadPool;
+
     /** The tile map that makes up the world. */
     TileMap tileMap;
 
@@ -53,6 +53,21 @@ public:
         Note: The tile map's size must be evenly divisible by this number. */
     static constexpr std::size_t WORLD_OBJECT_LOCATOR_CELL_HEIGHT{2};
 
+    /** How far ahead, in seconds, to predict the player's movement when 
+        deciding which chunks to request early. Should be at least the round 
+        trip time to the server. 0 disables chunk prefetching. */
+    static constexpr double CHUNK_PREFETCH_LOOKAHEAD_S{0.5};
+
+    /** The max number of bytes that loaded tile map chunks can use before 
+        we start evicting the least recently used ones. Chunks in range of 
+        the player are never evicted, so this may be exceeded. */
+    static constexpr std::size_t CHUNK_MEMORY_BUDGET_BYTES{64 * 1024 * 1024};
+
+    /** The max number of bytes that cached chunk snapshots (see 
+        ChunkUpdateSystem) can use before we start dropping the least recently 
+        used ones. This cache is also what gets saved to ChunkCache.bin. */
+    static constexpr std::size_t CHUNK_CACHE_BUDGET_BYTES{32 * 1024 * 1024};
+
     //-------------------------------------------------------------------------
     // Renderer, User Interface
     //-------------------------------------------------------------------------
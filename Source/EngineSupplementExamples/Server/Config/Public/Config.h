@@ -64,6 +64,99 @@ public:
         in seconds. */
     static constexpr float SAVE_PERIOD_S{60 * 15};
 
+    /** Saves normally only write the entities that changed since the last 
+        save. Every this many saves, all entities are written instead, as a 
+        safety net for changes that weren't signaled to the registry. 
+        0 disables full saves. */
+    static constexpr unsigned int FULL_ENTITY_SAVE_INTERVAL{8};
+
+    /** If true, the world database is written directly to disk in WAL mode, 
+        so each save only costs as much as what changed. If false, it's 
+        written to memory and the whole thing is backed up to disk on each 
+        save. 
+        Note: WAL mode uses synchronous=NORMAL, so a power loss may roll 
+              back the last few saves. The database won't be corrupted. */
+    static constexpr bool USE_WAL_DATABASE{false};
+
+    /** In WAL mode, how many saves to wait between checkpointing the log 
+        into the database file. */
+    static constexpr unsigned int DATABASE_CHECKPOINT_INTERVAL{4};
+
+    /** If true, saved entity and item data is LZ4-compressed before being 
+        written to the database. Uncompressed rows can be read either way. */
+    static constexpr bool COMPRESS_PERSISTED_BLOBS{true};
+
+    /** If true, a background thread will decode the tile map's chunks after 
+        startup. If false, chunks are only loaded when they're first 
+        accessed. */
+    static constexpr bool PREFETCH_TILE_MAP{true};
+
+    /** The max number of prefetched chunks that will be moved into the tile 
+        map each tick. */
+    static constexpr unsigned int PREFETCHED_CHUNKS_PER_TICK{64};
+
+    /** The max number of chunks that will be sent to clients each tick. 
+        Requests beyond this are queued and sent during later ticks, in the 
+        order that they were requested. */
+    static constexpr unsigned int CHUNKS_SENT_PER_TICK{32};
+
+    /** The max number of compiled scripts that each Lua environment will 
+        cache. When exceeded, the cache is cleared. */
+    static constexpr std::size_t LUA_SCRIPT_CACHE_SIZE{4096};
+
+    /** The max number of Lua instructions that a single script run may 
+        execute before it's aborted with an error. 
+        If 0, scripts may run forever. */
+    static constexpr int LUA_SCRIPT_INSTRUCTION_BUDGET{1'000'000};
+
+    /** How often we should log each Lua environment's most expensive scripts.
+        If 0, script stats will never be logged. */
+    static constexpr double LUA_SCRIPT_STATS_LOG_PERIOD_S{5 * 60};
+
+    /** How many scripts to include when logging each environment's stats. */
+    static constexpr std::size_t LUA_SCRIPT_STATS_LOG_COUNT{10};
+
+    /** The max number of AI that will be ticked each sim tick. AI that are 
+        due beyond this are ticked during later sim ticks. 
+        If 0, there's no limit. */
+    static constexpr std::size_t AI_TICK_BUDGET{1000};
+
+    /** The default number of sim ticks between AI ticks, for AI that have no 
+        clients within AOI range. See AILogic::getFarTickInterval(). */
+    static constexpr Uint32 AI_FAR_TICK_INTERVAL{15};
+
+    /** How often sleeping AI (those with a far tick interval of 0) check 
+        whether a client has come near, in sim ticks. */
+    static constexpr Uint32 AI_SLEEP_CHECK_INTERVAL{15};
+
+    /** The number of AI that each worker thread ticks per job, for AI types 
+        that derive from ParallelAILogic. Each batch gets its own command 
+        buffer, so smaller batches spread better but cost more to apply. */
+    static constexpr std::size_t AI_PARALLEL_BATCH_SIZE{64};
+
+    /** The size of the bounding box that paths are planned for, in world 
+        units. Should be a little smaller than your NPCs' collision, so they 
+        fit wherever a path leads. */
+    static constexpr float PATHFINDING_AGENT_WIDTH{20};
+    static constexpr float PATHFINDING_AGENT_HEIGHT{
+        SharedConfig::TILE_WORLD_HEIGHT / 2.f};
+
+    /** The max distance, in tiles along either axis, between a path's start 
+        and goal. Longer requests fail immediately. */
+    static constexpr int PATHFINDING_MAX_DISTANCE{128};
+
+    /** How many chunks past the start and goal's bounding box that a path is 
+        allowed to detour through. */
+    static constexpr int PATHFINDING_SEARCH_MARGIN{2};
+
+    /** The max number of path requests that will be processed each sim tick. 
+        Requests beyond this wait for later ticks. */
+    static constexpr std::size_t PATHFINDING_REQUESTS_PER_TICK{256};
+
+    /** The max number of paths to keep in the path cache. When full, the 
+        cache is cleared. */
+    static constexpr std::size_t PATHFINDING_CACHE_SIZE{4096};
+
     //-------------------------------------------------------------------------
     // Network
     //-------------------------------------------------------------------------
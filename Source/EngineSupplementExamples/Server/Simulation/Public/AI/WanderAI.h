@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ParallelAILogic.h"
+#include "World.h"
+#include "Input.h"
+#include "Position.h"
+#include "Collision.h"
+#include "MovementHelpers.h"
+#include "Transforms.h"
+#include "SharedConfig.h"
+#include "Log.h"
+#include <array>
+
+namespace AM
+{
+namespace Server
+{
+/**
+ * An example of ParallelAILogic: walks in a straight line, and turns to the
+ * next direction whenever the tile ahead is blocked.
+ *
+ * Since this ticks on worker threads, it follows the ParallelAILogic rules:
+ *   - The world is only read, through const access.
+ *   - Tile reads stay within getTileReadRange(), so the chunks they touch
+ *     are loaded before the pass.
+ *   - Movement is requested through the command buffer.
+ */
+class WanderAI : public ParallelAILogic
+{
+public:
+    void tickParallel(const World& world, entt::entity entity,
+                      AICommandBuffer& commands) override
+    {
+        const entt::registry& registry{world.registry};
+        if (!(registry.all_of<Input, Position, Collision>(entity))) {
+            LOG_ERROR("WanderAI entity is missing a required component.");
+            return;
+        }
+        const Position& position{registry.get<Position>(entity)};
+        const Collision& collision{registry.get<Collision>(entity)};
+
+        // If the tile ahead is blocked, turn until we find an open one.
+        for (std::size_t i{0}; i < DIRECTIONS.size(); ++i) {
+            const Direction& direction{DIRECTIONS[directionIndex]};
+            Position lookAheadPosition{position};
+            lookAheadPosition.x
+                += (direction.x * SharedConfig::TILE_WORLD_WIDTH);
+            lookAheadPosition.y
+                += (direction.y * SharedConfig::TILE_WORLD_WIDTH);
+            BoundingBox lookAheadBounds{Transforms::modelToWorldCentered(
+                collision.modelBounds, lookAheadPosition)};
+            if (!(MovementHelpers::intersectsTileCollision(lookAheadBounds,
+                                                           world.tileMap))) {
+                break;
+            }
+
+            directionIndex = (directionIndex + 1) % DIRECTIONS.size();
+        }
+
+        // Walk in our current direction.
+        const Direction& direction{DIRECTIONS[directionIndex]};
+        Input::StateArr inputStates{};
+        inputStates[direction.inputType] = Input::Pressed;
+        commands.setInputs(entity, inputStates);
+    }
+
+    int getTileReadRange() const override
+    {
+        // We look 1 tile ahead, and our bounds may reach into the next one.
+        return 2;
+    }
+
+private:
+    struct Direction {
+        float x{0};
+        float y{0};
+        Input::Type inputType{Input::None};
+    };
+
+    /** The directions that we walk in, in the order that we turn. */
+    static constexpr std::array<Direction, 4> DIRECTIONS{
+        {{1, 0, Input::XUp},
+         {0, 1, Input::YUp},
+         {-1, 0, Input::XDown},
+         {0, -1, Input::YDown}}};
+
+    /** The index within DIRECTIONS that we're currently walking in. */
+    std::size_t directionIndex{0};
+};
+
+} // End namespace Server
+} // End namespace AM
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "WanderAI.h"
 #include "boost/mp11/list.hpp"
 
 namespace AM
@@ -11,8 +12,9 @@ namespace Server
  * Add AI classes to this list to have them be processed by the engine.
  * 
  * Note: Every type in this list must be derived from AILogic.
+ *       Types derived from ParallelAILogic are ticked on worker threads.
  */
-using ProjectAITypes = boost::mp11::mp_list<>;
+using ProjectAITypes = boost::mp11::mp_list<WanderAI>;
 
 } // End namespace Server
 } // End namespace AM
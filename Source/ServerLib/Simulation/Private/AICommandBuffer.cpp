@@ -0,0 +1,50 @@
+#include "AICommandBuffer.h"
+#include "World.h"
+
+namespace AM
+{
+namespace Server
+{
+void AICommandBuffer::setInputs(entt::entity entity,
+                                const Input::StateArr& inputStates)
+{
+    commands.emplace_back([entity, inputStates](World& world) {
+        if (!(world.registry.valid(entity))) {
+            return;
+        }
+
+        // Only replace the inputs if they changed, since replace() triggers
+        // a movement update.
+        Input* input{world.registry.try_get<Input>(entity)};
+        if (input && (input->inputStates != inputStates)) {
+            world.registry.replace<Input>(entity, inputStates);
+        }
+    });
+}
+
+void AICommandBuffer::defer(std::function<void(World&)> command)
+{
+    commands.push_back(std::move(command));
+}
+
+void AICommandBuffer::apply(World& world)
+{
+    for (std::function<void(World&)>& command : commands) {
+        command(world);
+    }
+
+    commands.clear();
+}
+
+bool AICommandBuffer::empty() const
+{
+    return commands.empty();
+}
+
+entt::registry& AICommandBuffer::getRegistry(World& world)
+{
+    return world.registry;
+}
+
+} // namespace Server
+} // namespace AM
@@ -1,8 +1,16 @@
 #include "AISystem.h"
 #include "World.h"
 #include "ProjectAITypes.h"
+#include "ParallelAILogic.h"
+#include "ThreadPool.h"
+#include "AOIObservers.h"
+#include "Position.h"
+#include "Config.h"
 #include "Log.h"
 #include "boost/mp11/algorithm.hpp"
+#include "tracy/Tracy.hpp"
+#include <algorithm>
+#include <type_traits>
 
 namespace AM
 {
@@ -11,21 +19,175 @@ namespace Server
 
 AISystem::AISystem(World& inWorld)
 : world{inWorld}
+, tickNumber{0}
+, nextTypeIndex{0}
+, resumeIndices(boost::mp11::mp_size<ProjectAITypes>::value, 0)
+, processEntities{}
+, parallelEntities{}
+, commandBuffers{}
 {
 }
 
 void AISystem::processAITick()
 {
-    // For each AI type in the list, update all AI components of that type.
-    boost::mp11::mp_for_each<ProjectAITypes>(
-        [&](auto I) { 
-            using AIType = decltype(I);
-
-            auto view{world.registry.view<AIType>()};
-            for (auto [entity, aiLogic] : view.each()) {
-                aiLogic.tick(world, entity);
-            }
-        });
+    ZoneScoped;
+
+    // For each AI type in the list, tick any AI of that type that are due.
+    // Note: We start with a different type each tick, so the first type can't 
+    //       use up the whole budget every time.
+    constexpr std::size_t TYPE_COUNT{
+        boost::mp11::mp_size<ProjectAITypes>::value};
+    if constexpr (TYPE_COUNT > 0) {
+        std::size_t budget{(Config::AI_TICK_BUDGET > 0)
+                               ? Config::AI_TICK_BUDGET
+                               : SDL_MAX_UINT32};
+        for (std::size_t i{0}; i < TYPE_COUNT; ++i) {
+            std::size_t typeIndex{(nextTypeIndex + i) % TYPE_COUNT};
+            boost::mp11::mp_with_index<TYPE_COUNT>(typeIndex, [&](auto I) {
+                using AIType = boost::mp11::mp_at_c<ProjectAITypes, I>;
+                processAIType<AIType>(typeIndex, budget);
+            });
+        }
+        nextTypeIndex = (nextTypeIndex + 1) % TYPE_COUNT;
+    }
+
+    tickNumber++;
+}
+
+template<typename AIType>
+void AISystem::processAIType(std::size_t typeIndex, std::size_t& budget)
+{
+    auto& storage{world.registry.storage<AIType>()};
+    std::size_t& resumeIndex{resumeIndices[typeIndex]};
+
+    // Parallel types are gathered here and ticked after the loop.
+    constexpr bool IS_PARALLEL{std::is_base_of_v<ParallelAILogic, AIType>};
+    parallelEntities.clear();
+
+    // Visit each AI once, starting where we left off last tick.
+    // Note: We visit a copy of the storage's entities, since tick() may add 
+    //       or remove AI. Removals swap other AI into the removed slots, so 
+    //       we also can't hold onto a component across a tick() call.
+    processEntities.assign(storage.data(), (storage.data() + storage.size()));
+    std::size_t entityCount{processEntities.size()};
+    std::size_t startIndex{resumeIndex};
+    resumeIndex = 0;
+    for (std::size_t i{0}; i < entityCount; ++i) {
+        std::size_t index{(startIndex + i) % entityCount};
+        entt::entity entity{processEntities[index]};
+        if (!(storage.contains(entity))) {
+            // A previous tick() removed this AI.
+            continue;
+        }
+
+        AIType& aiLogic{storage.get(entity)};
+        if (tickNumber < aiLogic.nextTickNumber) {
+            continue;
+        }
+
+        // If no clients are near and this AI sleeps while far, just check 
+        // again later.
+        bool isNear{isNearClient(entity)};
+        Uint32 interval{isNear ? aiLogic.getNearTickInterval()
+                               : aiLogic.getFarTickInterval()};
+        if (interval == 0) {
+            aiLogic.nextTickNumber
+                = tickNumber + Config::AI_SLEEP_CHECK_INTERVAL;
+            continue;
+        }
+
+        // If we're out of budget, resume from this AI next tick.
+        if (budget == 0) {
+            resumeIndex = index;
+            break;
+        }
+
+        // Note: This must happen before tick(), since aiLogic may no longer 
+        //       be this entity's AI afterwards.
+        aiLogic.nextTickNumber = tickNumber + interval;
+        budget--;
+
+        if constexpr (IS_PARALLEL) {
+            parallelEntities.push_back(entity);
+        }
+        else {
+            aiLogic.tick(world, entity);
+        }
+    }
+
+    if constexpr (IS_PARALLEL) {
+        tickParallel<AIType>();
+    }
+}
+
+template<typename AIType>
+void AISystem::tickParallel()
+{
+    if (parallelEntities.empty()) {
+        return;
+    }
+
+    // Load the chunks that each AI may read, since the workers can't.
+    auto& storage{world.registry.storage<AIType>()};
+    for (entt::entity entity : parallelEntities) {
+        int range{storage.get(entity).getTileReadRange()};
+        const Position* position{world.registry.try_get<Position>(entity)};
+        if ((range <= 0) || !position) {
+            continue;
+        }
+
+        TilePosition tilePosition{position->asTilePosition()};
+        ChunkPosition minChunk{TilePosition{(tilePosition.x - range),
+                                            (tilePosition.y - range),
+                                            (tilePosition.z - 1)}};
+        ChunkPosition maxChunk{TilePosition{(tilePosition.x + range),
+                                            (tilePosition.y + range),
+                                            (tilePosition.z + 1)}};
+        world.tileMap.ensureChunksLoaded({minChunk.x, minChunk.y, minChunk.z,
+                                          (maxChunk.x - minChunk.x + 1),
+                                          (maxChunk.y - minChunk.y + 1),
+                                          (maxChunk.z - minChunk.z + 1)});
+    }
+
+    // Split the AI into batches, each with its own command buffer.
+    std::size_t batchCount{
+        (parallelEntities.size() + Config::AI_PARALLEL_BATCH_SIZE - 1)
+        / Config::AI_PARALLEL_BATCH_SIZE};
+    if (commandBuffers.size() < batchCount) {
+        commandBuffers.resize(batchCount);
+    }
+
+    // Tick each batch on the world's thread pool.
+    // Note: Nothing modifies the registry until the pool is done, so the 
+    //       AI components are safe to access from the workers.
+    const World& constWorld{world};
+    world.threadPool.parallelFor(batchCount, [&](std::size_t batchIndex) {
+        std::size_t begin{batchIndex * Config::AI_PARALLEL_BATCH_SIZE};
+        std::size_t end{std::min((begin + Config::AI_PARALLEL_BATCH_SIZE),
+                                 parallelEntities.size())};
+        AICommandBuffer& commands{commandBuffers[batchIndex]};
+        for (std::size_t i{begin}; i < end; ++i) {
+            entt::entity entity{parallelEntities[i]};
+            storage.get(entity).tickParallel(constWorld, entity, commands);
+        }
+    });
+
+    // Apply the commands in batch order, so the result doesn't depend on 
+    // which thread finished first.
+    for (std::size_t i{0}; i < batchCount; ++i) {
+        commandBuffers[i].apply(world);
+    }
+}
+
+bool AISystem::isNearClient(entt::entity entity) const
+{
+    if (!(world.registry.all_of<Position>(entity))) {
+        return true;
+    }
+
+    // If any client has this entity in its AOI, it's near.
+    const auto* aoiObservers{world.registry.try_get<AOIObservers>(entity)};
+    return (aoiObservers && !(aoiObservers->clientEntities.empty()));
 }
 
 } // End namespace Server
@@ -8,6 +8,7 @@
 #include "ChunkUpdate.h"
 #include "Tile.h"
 #include "ChunkWireSnapshot.h"
+#include "Config.h"
 #include "SharedConfig.h"
 #include "Log.h"
 #include <SDL_rect.h>
@@ -22,6 +23,8 @@ ChunkStreamingSystem::ChunkStreamingSystem(World& inWorld, Network& inNetwork)
 : world{inWorld}
 , network{inNetwork}
 , chunkDataRequestQueue{inNetwork.getEventDispatcher()}
+, pendingRequests{}
+, nextRequestedChunkIndex{0}
 {
 }
 
@@ -29,39 +32,127 @@ void ChunkStreamingSystem::sendChunks()
 {
     ZoneScoped;
 
-    // Process all chunk data requests.
+    // Drop the subscriptions of any clients that moved out of range.
+    updateSubscriptions();
+
+    // Queue any new chunk data requests.
     ChunkDataRequest chunkDataRequest{};
     while (chunkDataRequestQueue.pop(chunkDataRequest)) {
-        sendChunkUpdate(chunkDataRequest);
+        pendingRequests.push_back(std::move(chunkDataRequest));
+    }
+
+    // Send as many requested chunks as we can this tick, in the order that 
+    // they were requested.
+    // Note: Clients sort their requests by distance, so the most important 
+    //       chunks are sent first.
+    std::size_t chunkBudget{Config::CHUNKS_SENT_PER_TICK};
+    while (!(pendingRequests.empty()) && (chunkBudget > 0)) {
+        const ChunkDataRequest& request{pendingRequests.front()};
+        chunkBudget -= sendChunkUpdate(request, chunkBudget);
+
+        // If we finished this request, move on to the next.
+        if (nextRequestedChunkIndex >= request.requestedChunks.size()) {
+            pendingRequests.pop_front();
+            nextRequestedChunkIndex = 0;
+        }
+    }
+}
+
+ChunkExtent ChunkStreamingSystem::getInRangeExtent(
+    const ChunkPosition& chunkPosition) const
+{
+    const ChunkExtent& mapChunkExtent{world.tileMap.getChunkExtent()};
+    ChunkExtent inRangeExtent{(chunkPosition.x - 1),
+                              (chunkPosition.y - 1),
+                              mapChunkExtent.z,
+                              3,
+                              3,
+                              mapChunkExtent.zLength};
+    inRangeExtent.intersectWith(mapChunkExtent);
+    return inRangeExtent;
+}
+
+void ChunkStreamingSystem::updateSubscriptions()
+{
+    auto view{world.registry.view<ClientSimData, Position, PreviousPosition>()};
+    for (auto [entity, client, position, previousPosition] : view.each()) {
+        // If this client moved into a new chunk, drop any chunks that it's 
+        // no longer in range of.
+        ChunkPosition currentChunk{position.asChunkPosition()};
+        if (currentChunk != previousPosition.asChunkPosition()) {
+            world.chunkSubscriptions.unsubscribeOutsideOf(
+                entity, getInRangeExtent(currentChunk));
+        }
     }
 }
 
-void ChunkStreamingSystem::sendChunkUpdate(
-    const ChunkDataRequest& chunkDataRequest)
+std::size_t ChunkStreamingSystem::sendChunkUpdate(
+    const ChunkDataRequest& chunkDataRequest, std::size_t maxChunks)
 {
-    // Add the requested chunks to the message.
+    // If the client has already disconnected, skip the request.
+    auto entityIt{world.netIDMap.find(chunkDataRequest.netID)};
+    if (entityIt == world.netIDMap.end()) {
+        nextRequestedChunkIndex = chunkDataRequest.requestedChunks.size();
+        return 0;
+    }
+    entt::entity clientEntity{entityIt->second};
+
+    // Add the requested chunks to the message and subscribe the client to 
+    // them.
+    // Note: Only chunks that we send data for count towards maxChunks. 
+    //       Unchanged and empty chunks are cheap.
+    const ChunkExtent& mapChunkExtent{world.tileMap.getChunkExtent()};
+    const auto& requestedChunks{chunkDataRequest.requestedChunks};
     ChunkUpdate chunkUpdate{};
-    for (const ChunkPosition& requestedChunk :
-         chunkDataRequest.requestedChunks) {
+    while ((nextRequestedChunkIndex < requestedChunks.size())
+           && (chunkUpdate.chunks.size() < maxChunks)) {
+        const ChunkDataRequest::RequestedChunk& requestedChunk{
+            requestedChunks[nextRequestedChunkIndex]};
+        nextRequestedChunkIndex++;
+        if (!(mapChunkExtent.containsPosition(requestedChunk.position))) {
+            continue;
+        }
+
         addChunkToMessage(requestedChunk, chunkUpdate);
+
+        // Note: We subscribe even if the chunk is empty, since the client 
+        //       will still need to hear about any layers that get added.
+        world.chunkSubscriptions.subscribe(clientEntity,
+                                           requestedChunk.position);
     }
 
     // Send the message.
-    network.serializeAndSend(chunkDataRequest.netID, chunkUpdate);
+    if (!(chunkUpdate.chunks.empty())
+        || !(chunkUpdate.unchangedChunks.empty())) {
+        network.serializeAndSend(chunkDataRequest.netID, chunkUpdate);
+    }
+
+    return chunkUpdate.chunks.size();
 }
 
-void ChunkStreamingSystem::addChunkToMessage(const ChunkPosition& chunkPosition,
-                                             ChunkUpdate& chunkUpdate)
+void ChunkStreamingSystem::addChunkToMessage(
+    const ChunkDataRequest::RequestedChunk& requestedChunk,
+    ChunkUpdate& chunkUpdate)
 {
-    if (const Chunk* chunk{world.tileMap.cgetChunk(chunkPosition)}) {
+    // If the client already has the latest version of this chunk, tell it to 
+    // use its cached copy.
+    const ChunkPosition& chunkPosition{requestedChunk.position};
+    Uint64 currentVersion{world.tileMap.getChunkVersion(chunkPosition)};
+    if (requestedChunk.knownVersion == currentVersion) {
+        chunkUpdate.unchangedChunks.push_back(chunkPosition);
+        return;
+    }
+
+    if (const Chunk* chunk{world.tileMap.ensureChunkLoaded(chunkPosition)}) {
         // Push the new chunk and get a ref to it.
         chunkUpdate.chunks.emplace_back();
         ChunkWireSnapshot& chunkSnapshot{chunkUpdate.chunks.back()};
 
-        // Save the chunk's position.
+        // Save the chunk's position and version.
         chunkSnapshot.x = chunkPosition.x;
         chunkSnapshot.y = chunkPosition.y;
         chunkSnapshot.z = chunkPosition.z;
+        chunkSnapshot.version = currentVersion;
 
         // Copy all of the chunk's tile layers into the snapshot.
         chunkSnapshot.tileLayers.resize(chunk->tileLayerCount);
@@ -90,6 +181,15 @@ void ChunkStreamingSystem::addChunkToMessage(const ChunkPosition& chunkPosition,
             }
         }
     }
+    else if (requestedChunk.knownVersion != 0) {
+        // This chunk doesn't exist, but the client has an old version of it 
+        // cached. Send an empty snapshot so it knows to clear it.
+        ChunkWireSnapshot& chunkSnapshot{chunkUpdate.chunks.emplace_back()};
+        chunkSnapshot.x = chunkPosition.x;
+        chunkSnapshot.y = chunkPosition.y;
+        chunkSnapshot.z = chunkPosition.z;
+        chunkSnapshot.version = currentVersion;
+    }
     else {
         // This chunk doesn't exist, we don't need to send anything.
     }
@@ -4,6 +4,7 @@
 #include "Network.h"
 #include "Serialize.h"
 #include "ClientSimData.h"
+#include "AOIObservers.h"
 #include "BoundingBox.h"
 #include "Cylinder.h"
 #include "ReplicatedComponent.h"
@@ -59,6 +60,15 @@ ClientAOISystem::ClientAOISystem(Simulation& inSimulation, World& inWorld,
 , entitiesThatLeft{}
 , entitiesThatEntered{}
 {
+    // When a client entity is destroyed, stop sending it updates.
+    world.registry.on_destroy<ClientSimData>()
+        .connect<&ClientAOISystem::onClientDestroyed>(this);
+}
+
+ClientAOISystem::~ClientAOISystem()
+{
+    // Stop listening to the registry, since it outlives us.
+    world.registry.on_destroy<ClientSimData>().disconnect(this);
 }
 
 void ClientAOISystem::updateAOILists()
@@ -89,7 +99,7 @@ void ClientAOISystem::updateAOILists()
 
         // Process the entities that left this entity's AOI.
         if (entitiesThatLeft.size() > 0) {
-            processEntitiesThatLeft(client);
+            processEntitiesThatLeft(entity, client);
         }
 
         // Fill entitiesThatEntered with the entities that entered this entity's
@@ -101,7 +111,7 @@ void ClientAOISystem::updateAOILists()
 
         // Process the entities that entered this entity's AOI.
         if (entitiesThatEntered.size() > 0) {
-            processEntitiesThatEntered(client);
+            processEntitiesThatEntered(entity, client);
         }
 
         // Save the new list.
@@ -109,17 +119,51 @@ void ClientAOISystem::updateAOILists()
     }
 }
 
-void ClientAOISystem::processEntitiesThatLeft(ClientSimData& client)
+void ClientAOISystem::onClientDestroyed(entt::registry& registry,
+                                        entt::entity entity)
 {
+    const ClientSimData& client{registry.get<ClientSimData>(entity)};
+    for (entt::entity entityInAOI : client.entitiesInAOI) {
+        // Note: The entity may have already been destroyed, or may be the
+        //       client itself (whose AOIObservers may already be removed).
+        AOIObservers* aoiObservers{registry.valid(entityInAOI)
+                                       ? registry.try_get<AOIObservers>(
+                                           entityInAOI)
+                                       : nullptr};
+        if (aoiObservers != nullptr) {
+            std::erase(aoiObservers->clientEntities, entity);
+        }
+    }
+}
+
+void ClientAOISystem::processEntitiesThatLeft(entt::entity clientEntity,
+                                              ClientSimData& client)
+{
+    entt::registry& registry{world.registry};
+
     // Send the client an EntityDelete for each entity that left its AOI.
     for (entt::entity entityThatLeft : entitiesThatLeft) {
+        // If the entity still exists, stop tracking the client as an
+        // observer.
+        // Note: Destroyed entities' AOIObservers are removed with them.
+        //       Entities may also have lost their components, e.g. while
+        //       being re-initialized, so we can't assume it's present.
+        AOIObservers* aoiObservers{
+            registry.valid(entityThatLeft)
+                ? registry.try_get<AOIObservers>(entityThatLeft)
+                : nullptr};
+        if (aoiObservers != nullptr) {
+            std::erase(aoiObservers->clientEntities, clientEntity);
+        }
+
         network.serializeAndSend(
             client.netID,
             EntityDelete{simulation.getCurrentTick(), entityThatLeft});
     }
 }
 
-void ClientAOISystem::processEntitiesThatEntered(ClientSimData& client)
+void ClientAOISystem::processEntitiesThatEntered(entt::entity clientEntity,
+                                                 ClientSimData& client)
 {
     entt::registry& registry{world.registry};
 
@@ -127,6 +171,10 @@ void ClientAOISystem::processEntitiesThatEntered(ClientSimData& client)
     // AOI.
     EntityInit entityInit{simulation.getCurrentTick()};
     for (entt::entity entityThatEntered : entitiesThatEntered) {
+        // Track the client as an observer.
+        registry.get_or_emplace<AOIObservers>(entityThatEntered)
+            .clientEntities.push_back(clientEntity);
+
         const auto& replicatedComponentList{
             registry.get<ReplicatedComponentList>(entityThatEntered)};
 
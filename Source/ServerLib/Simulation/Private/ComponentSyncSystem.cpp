@@ -7,11 +7,9 @@
 #include "ProjectObservedComponentTypes.h"
 #include "ReplicatedComponent.h"
 #include "ClientSimData.h"
-#include "Cylinder.h"
+#include "AOIObservers.h"
 #include "Collision.h"
-#include "SharedConfig.h"
 #include "Log.h"
-#include "entt/entity/observer.hpp"
 #include "boost/mp11/algorithm.hpp"
 #include "boost/mp11/map.hpp"
 #include "boost/mp11/bind.hpp"
@@ -29,9 +27,8 @@ using ObservedComponentTypes
     = boost::mp11::mp_append<EngineObservedComponentTypes,
                              ProjectObservedComponentTypes>;
 
-/** A group and update observer for each observed component type. */
-std::array<entt::observer, boost::mp11::mp_size<ObservedComponentTypes>::value>
-    observers{};
+static_assert(boost::mp11::mp_size<ObservedComponentTypes>::value <= 64,
+              "Dirty masks only have room for 64 observed component types.");
 
 ComponentSyncSystem::ComponentSyncSystem(Simulation& inSimulation,
                                          World& inWorld, Network& inNetwork,
@@ -40,6 +37,9 @@ ComponentSyncSystem::ComponentSyncSystem(Simulation& inSimulation,
 , world{inWorld}
 , network{inNetwork}
 , graphicData{inGraphicData}
+, dirtyMasks{}
+, dirtyEntities{}
+, componentUpdate{}
 {
     boost::mp11::mp_for_each<ObservedComponentTypes>([&](auto I) {
         using ComponentType = decltype(I);
@@ -49,12 +49,29 @@ ComponentSyncSystem::ComponentSyncSystem(Simulation& inSimulation,
 
         // TODO: If a client is near an entity when it's constructed, it'll
         //       receive both an EntityInit and a ComponentUpdate (from the
-        //       group observer). It'd be nice if we could find a way to just
-        //       send one, but until then it isn't a huge cost.
-        observers[typeIndex].connect(world.registry,
-                                     entt::collector.group<ComponentType>()
-                                         .template update<ComponentType>());
+        //       construct signal). It'd be nice if we could find a way to
+        //       just send one, but until then it isn't a huge cost.
+        world.registry.on_construct<ComponentType>()
+            .template connect<
+                &ComponentSyncSystem::onComponentChanged<typeIndex>>(this);
+        world.registry.on_update<ComponentType>()
+            .template connect<
+                &ComponentSyncSystem::onComponentChanged<typeIndex>>(this);
     });
+
+    world.registry.on_destroy<entt::entity>()
+        .connect<&ComponentSyncSystem::onEntityDestroyed>(this);
+}
+
+ComponentSyncSystem::~ComponentSyncSystem()
+{
+    // Stop listening to the registry, since it outlives us.
+    boost::mp11::mp_for_each<ObservedComponentTypes>([&](auto I) {
+        using ComponentType = decltype(I);
+        world.registry.on_construct<ComponentType>().disconnect(this);
+        world.registry.on_update<ComponentType>().disconnect(this);
+    });
+    world.registry.on_destroy<entt::entity>().disconnect(this);
 }
 
 void ComponentSyncSystem::sendUpdates()
@@ -62,66 +79,87 @@ void ComponentSyncSystem::sendUpdates()
     ZoneScoped;
 
     entt::registry& registry{world.registry};
+    auto clientView{registry.view<ClientSimData>()};
+    for (entt::entity entity : dirtyEntities) {
+        // Skip entities that were destroyed, or that no clients can see.
+        if (!(registry.valid(entity))) {
+            continue;
+        }
+        const auto* aoiObservers{registry.try_get<AOIObservers>(entity)};
+        if (!aoiObservers || aoiObservers->clientEntities.empty()) {
+            continue;
+        }
 
-    // TODO: We build a message for each updated entity, even if there aren't
-    //       any clients nearby to send it to. There may be ways to optimize by
-    //       making it client-by-client like MovementSyncSystem.
-    // Build an EntityUpdate for each entity that has an updated component.
-    boost::mp11::mp_for_each<ObservedComponentTypes>([&](auto I) {
-        using ComponentType = decltype(I);
-        constexpr std::size_t typeIndex{
-            boost::mp11::mp_find<ObservedComponentTypes,
-                                 ComponentType>::value};
+        // Build an update with each of the entity's dirty components.
+        Uint64 dirtyMask{dirtyMasks[entt::to_entity(entity)]};
+        componentUpdate.components.clear();
+        boost::mp11::mp_for_each<ObservedComponentTypes>([&](auto I) {
+            using ComponentType = decltype(I);
+            constexpr std::size_t typeIndex{
+                boost::mp11::mp_find<ObservedComponentTypes,
+                                     ComponentType>::value};
+
+            // Skip components that didn't change, or were since removed.
+            if (!(dirtyMask & (Uint64{1} << typeIndex))
+                || !(registry.all_of<ComponentType>(entity))) {
+                return;
+            }
 
-        // For each entity that was updated, push its components into its
-        // message.
-        for (entt::entity entity : observers[typeIndex]) {
             if constexpr (std::is_empty_v<ComponentType>) {
                 // Note: Can't registry.get() empty types.
-                componentUpdateMap[entity].components.push_back(
-                    ComponentType{});
+                componentUpdate.components.push_back(ComponentType{});
             }
             else {
                 const auto& component{registry.get<ComponentType>(entity)};
-                componentUpdateMap[entity].components.push_back(component);
+                componentUpdate.components.push_back(component);
             }
+        });
+        if (componentUpdate.components.empty()) {
+            continue;
         }
 
-        observers[typeIndex].clear();
-    });
-
-    // Send each update to all nearby clients.
-    auto view{registry.view<Position, ClientSimData>()};
-    for (auto& [updatedEntity, componentUpdate] : componentUpdateMap) {
         // Serialize the message.
-        componentUpdate.entity = updatedEntity;
+        componentUpdate.entity = entity;
         componentUpdate.tickNum = simulation.getCurrentTick();
         BinaryBufferSharedPtr message{network.serialize(componentUpdate)};
 
-        // Get the list of entities that are in range of the updated entity.
-        const std::vector<entt::entity>* entitiesInRange{nullptr};
-        if (const auto* client
-            = registry.try_get<ClientSimData>(updatedEntity)) {
-            // Clients already have their AOI list built.
-            entitiesInRange = &(client->entitiesInAOI);
-        }
-        else {
-            const auto& updatedEntityPosition{
-                view.get<Position>(updatedEntity)};
-            entitiesInRange = &(world.entityLocator.getEntities(
-                {updatedEntityPosition, SharedConfig::AOI_RADIUS}));
+        // Send the update to each client that can see the entity.
+        for (entt::entity clientEntity : aoiObservers->clientEntities) {
+            const auto& client{clientView.get<ClientSimData>(clientEntity)};
+            network.send(client.netID, message, componentUpdate.tickNum);
         }
+    }
 
-        // Send the update to all nearby clients.
-        for (entt::entity entity : *entitiesInRange) {
-            if (view.contains(entity)) {
-                const auto& client{view.get<ClientSimData>(entity)};
-                network.send(client.netID, message, componentUpdate.tickNum);
-            }
-        }
+    // Clear the dirty state.
+    for (entt::entity entity : dirtyEntities) {
+        dirtyMasks[entt::to_entity(entity)] = 0;
     }
+    dirtyEntities.clear();
+}
 
-    componentUpdateMap.clear();
+template<std::size_t TypeIndex>
+void ComponentSyncSystem::onComponentChanged(entt::registry&,
+                                             entt::entity entity)
+{
+    std::size_t entityIndex{entt::to_entity(entity)};
+    if (entityIndex >= dirtyMasks.size()) {
+        dirtyMasks.resize(entityIndex + 1);
+    }
+
+    Uint64& dirtyMask{dirtyMasks[entityIndex]};
+    if (dirtyMask == 0) {
+        dirtyEntities.push_back(entity);
+    }
+    dirtyMask |= (Uint64{1} << TypeIndex);
+}
+
+void ComponentSyncSystem::onEntityDestroyed(entt::registry&,
+                                            entt::entity entity)
+{
+    std::size_t entityIndex{entt::to_entity(entity)};
+    if (entityIndex < dirtyMasks.size()) {
+        dirtyMasks[entityIndex] = 0;
+    }
 }
 
 } // namespace Server
@@ -1,47 +1,51 @@
 #include "StoredValues.h"
-#include "World.h"
+#include "AMAssert.h"
 
 namespace AM
 {
 namespace Server
 {
 
-bool StoredValues::storeValue(std::string_view stringID, Uint32 newValue,
-                              World& world)
+void StoredValues::storeValue(EntityStoredValueID numericID, Uint32 newValue)
 {
-    // Try to get a numeric ID for the given string ID.
-    EntityStoredValueID numericID{world.getEntityStoredValueID(stringID)};
-    if (!numericID) {
-        return false;
-    }
-
-    // If we're setting the value to 0, don't add it to the map (default values 
-    // don't need to be stored).
+    AM_ASSERT(numericID, "Tried to store a value with a null ID.");
+
+    auto valueIt{std::lower_bound(
+        values.begin(), values.end(), numericID,
+        [](const ValuePair& valuePair, EntityStoredValueID id) {
+            return valuePair.first < id;
+        })};
+    bool valueExists{(valueIt != values.end())
+                     && (valueIt->first == numericID)};
+
+    // If we're setting the value to 0, don't add it (default values don't 
+    // need to be stored).
     if (newValue == 0) {
         // If the value already exists, erase it.
-        auto valueIt{valueMap.find(numericID)};
-        if (valueIt != valueMap.end()) {
-            valueMap.erase(valueIt);
+        if (valueExists) {
+            values.erase(valueIt);
         }
 
-        return true;
+        return;
     }
 
-    valueMap[numericID] = newValue;
-    return true;
+    if (valueExists) {
+        valueIt->second = newValue;
+    }
+    else {
+        values.insert(valueIt, {numericID, newValue});
+    }
 }
 
-Uint32 StoredValues::getStoredValue(std::string_view stringID, World& world)
+Uint32 StoredValues::getStoredValue(EntityStoredValueID numericID) const
 {
-    // Try to get the numeric ID for the given string ID.
-    EntityStoredValueID numericID{world.getEntityStoredValueID(stringID)};
-    if (!numericID) {
-        return 0;
-    }
-
     // If the value exists, return it.
-    auto valueIt{valueMap.find(numericID)};
-    if (valueIt != valueMap.end()) {
+    auto valueIt{std::lower_bound(
+        values.begin(), values.end(), numericID,
+        [](const ValuePair& valuePair, EntityStoredValueID id) {
+            return valuePair.first < id;
+        })};
+    if ((valueIt != values.end()) && (valueIt->first == numericID)) {
         return valueIt->second;
     }
 
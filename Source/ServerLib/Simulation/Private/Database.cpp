@@ -1,7 +1,7 @@
 #include "Database.h"
 #include "SQLiteCpp/VariadicBind.h"
 #include "SQLiteCpp/Backup.h"
-#include "Paths.h"
+#include "Config.h"
 #include "AMAssert.h"
 #include "Log.h"
 
@@ -23,10 +23,12 @@ namespace AM
 {
 namespace Server
 {
-Database::Database()
-: database{":memory:", SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE}
-, backupDatabase{(Paths::BASE_PATH + "/Database.db3"),
-                 SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE}
+Database::Database(StorageMode inStorageMode, const std::string& filePath)
+: storageMode{inStorageMode}
+, database{((storageMode == StorageMode::InMemory) ? ":memory:" : filePath),
+           SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE}
+, backupDatabase{filePath, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE}
+, backupsSinceCheckpoint{0}
 , currentTransaction{}
 , backupThreadObj{}
 , exitRequested{false} 
@@ -44,6 +46,22 @@ Database::Database()
 , insertGlobalStoredValueMapQuery{nullptr}
 , getGlobalStoredValueMapQuery{nullptr}
 {
+    if (storageMode == StorageMode::InMemory) {
+        // Start the in-memory database off with the file's contents. Saves 
+        // are incremental, so the backup would otherwise drop anything that 
+        // didn't change since startup.
+        try {
+            SQLite::Backup restore(database, backupDatabase);
+            restore.executeStep();
+        } catch (std::exception& e) {
+            LOG_FATAL("Failed to load database file: %s", e.what());
+        }
+    }
+    else {
+        initWriteAheadLog(database);
+        initWriteAheadLog(backupDatabase);
+    }
+
     initTables();
 
     // Note: We build these queries after initTables() because they'll 
@@ -124,6 +142,16 @@ void Database::backupToFile()
         return;
     }
 
+    // In WAL mode, the data is already in the file. We only need to 
+    // checkpoint every so often, to keep the log from growing.
+    if (storageMode == StorageMode::WriteAheadLog) {
+        backupsSinceCheckpoint++;
+        if (backupsSinceCheckpoint < Config::DATABASE_CHECKPOINT_INTERVAL) {
+            return;
+        }
+        backupsSinceCheckpoint = 0;
+    }
+
     // Wake the backup thread.
     {
         std::unique_lock lock{backupMutex};
@@ -278,6 +306,23 @@ void Database::initTables()
     }
 }
 
+void Database::initWriteAheadLog(SQLite::Database& connection)
+{
+    try {
+        // Note: NORMAL is safe in WAL mode. A power loss may roll back the 
+        //       last few commits, but won't corrupt the database.
+        connection.exec("PRAGMA journal_mode=WAL");
+        connection.exec("PRAGMA synchronous=NORMAL");
+
+        // We checkpoint on our own thread (see backupToFile()), so the 
+        // thread that's writing doesn't have to.
+        connection.exec("PRAGMA wal_autocheckpoint=0");
+        connection.setBusyTimeout(1000);
+    } catch (std::exception& e) {
+        LOG_FATAL("Failed to enable WAL mode: %s", e.what());
+    }
+}
+
 void Database::performBackup()
 {
     while (!exitRequested) {
@@ -285,10 +330,18 @@ void Database::performBackup()
         std::unique_lock lock{backupMutex};
         backupCondVar.wait(lock, [this] { return backupRequested.load(); });
 
-        // Execute all backup steps at once.
         try {
-            SQLite::Backup backup(backupDatabase, database);
-            backup.executeStep();
+            if (storageMode == StorageMode::InMemory) {
+                // Execute all backup steps at once.
+                SQLite::Backup backup(backupDatabase, database);
+                backup.executeStep();
+            }
+            else {
+                // Copy the log into the database file and truncate it.
+                // Note: SaveSystem doesn't write while a backup is in 
+                //       progress, so this won't be blocked by a writer.
+                backupDatabase.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+            }
         } catch (std::exception& e) {
             LOG_ERROR("Failed to save database to file: %s", e.what());
         }
@@ -48,8 +48,9 @@ void DialogueSystem::processTalkInteraction(entt::entity clientEntity,
                                             entt::entity targetEntity,
                                             NetworkID clientID)
 {
-    const Dialogue* dialogue{world.registry.try_get<Dialogue>(targetEntity)};
-    if (!dialogue) {
+    const Dialogue* dialogueComponent{
+        world.registry.try_get<Dialogue>(targetEntity)};
+    if (!dialogueComponent) {
         // This can happen if the init script has an addTalkInteraction() 
         // but doesn't have any topic() declarations.
         network.serializeAndSend(
@@ -58,6 +59,7 @@ void DialogueSystem::processTalkInteraction(entt::entity clientEntity,
                           "Dialogue component."});
         return;
     }
+    const Dialogue::Definition* dialogue{dialogueComponent->definition.get()};
     AM_ASSERT(dialogue->topics.size() > 0,
               "Dialogue should always have at least 1 topic.");
 
@@ -72,10 +74,11 @@ void DialogueSystem::processTalkInteraction(entt::entity clientEntity,
     std::size_t topicNavigationCount{0};
     const Dialogue::Topic* lastTopic{&(dialogue->topics[0])};
     const Dialogue::Topic* nextTopic{
-        runTopic(*dialogue, dialogue->topics[0], clientID)};
+        runTopic(*dialogue, dialogue->topics[0], targetEntity, clientID)};
     while (nextTopic && (topicNavigationCount < TOPIC_NAVIGATION_MAX)) {
         lastTopic = nextTopic;
-        nextTopic = runTopic(*dialogue, *nextTopic, clientID);
+        nextTopic
+            = runTopic(*dialogue, *nextTopic, targetEntity, clientID);
         topicNavigationCount++;
     }
 
@@ -99,7 +102,7 @@ void DialogueSystem::processDialogueChoice(
 
     // Validate the request.
     entt::entity clientEntity{clientEntityIt->second};
-    const Dialogue* dialogue{
+    const Dialogue::Definition* dialogue{
         validateChoiceRequest(choiceRequest, clientEntity)};
     if (!dialogue) {
         return;
@@ -121,7 +124,8 @@ void DialogueSystem::processDialogueChoice(
 
     const Dialogue::Topic* nextTopic{
         runChoice(*dialogue, choice, choiceTopic.name,
-                  choiceRequest.choiceIndex, choiceRequest.netID)};
+                  choiceRequest.choiceIndex, choiceRequest.targetEntity,
+                  choiceRequest.netID)};
 
     // If the choice contained a valid setNextTopic(), run the next topic script, 
     // following any setNextTopic and pushing dialogue events into the response.
@@ -129,7 +133,8 @@ void DialogueSystem::processDialogueChoice(
     const Dialogue::Topic* lastTopic{nullptr};
     while (nextTopic && (topicNavigationCount < TOPIC_NAVIGATION_MAX)) {
         lastTopic = nextTopic;
-        nextTopic = runTopic(*dialogue, *nextTopic, choiceRequest.netID);
+        nextTopic = runTopic(*dialogue, *nextTopic, choiceRequest.targetEntity,
+                             choiceRequest.netID);
         topicNavigationCount++;
     }
 
@@ -145,15 +150,16 @@ void DialogueSystem::processDialogueChoice(
 }
 
 const Dialogue::Topic*
-    DialogueSystem::runChoice(const Dialogue& dialogue,
+    DialogueSystem::runChoice(const Dialogue::Definition& dialogue,
                               const Dialogue::Choice& choice,
                               std::string_view choiceTopicName,
-                              Uint8 choiceIndex, NetworkID clientID)
+                              Uint8 choiceIndex, entt::entity targetEntity,
+                              NetworkID clientID)
 {
     // Run the choice's action script, pushing dialogue events into the response.
     dialogueLua.nextTopicName = "";
-    auto scriptResult{dialogueLua.luaState.script(choice.actionScript,
-                                                  &sol::script_pass_on_error)};
+    auto scriptResult{dialogueLua.scriptCache.run(
+        choice.actionScript, {"Choice action", choiceTopicName, targetEntity})};
 
     if (!(scriptResult.valid())) {
         sol::error err = scriptResult;
@@ -188,14 +194,15 @@ const Dialogue::Topic*
     return nullptr;
 }
 
-const Dialogue::Topic* DialogueSystem::runTopic(const Dialogue& dialogue,
-                                                const Dialogue::Topic& topic,
-                                                NetworkID clientID)
+const Dialogue::Topic*
+    DialogueSystem::runTopic(const Dialogue::Definition& dialogue,
+                             const Dialogue::Topic& topic,
+                             entt::entity targetEntity, NetworkID clientID)
 {
     // Run the topic script, pushing dialogue events into the response.
     dialogueLua.nextTopicName = "";
-    auto scriptResult{dialogueLua.luaState.script(topic.topicScript,
-                                                  &sol::script_pass_on_error)};
+    auto scriptResult{dialogueLua.scriptCache.run(
+        topic.topicScript, {"Topic", topic.name, targetEntity})};
 
     if (!(scriptResult.valid())) {
         sol::error err = scriptResult;
@@ -228,7 +235,7 @@ const Dialogue::Topic* DialogueSystem::runTopic(const Dialogue& dialogue,
     return nullptr;
 }
 
-const Dialogue* DialogueSystem::validateChoiceRequest(
+const Dialogue::Definition* DialogueSystem::validateChoiceRequest(
     const DialogueChoiceRequest& choiceRequest, entt::entity clientEntity)
 {
     entt::registry& registry{world.registry};
@@ -246,9 +253,9 @@ const Dialogue* DialogueSystem::validateChoiceRequest(
     }
 
     // Check that the dialogue is valid.
-    const Dialogue* dialogue{
+    const Dialogue* dialogueComponent{
         registry.try_get<Dialogue>(choiceRequest.targetEntity)};
-    if (!dialogue) {
+    if (!dialogueComponent) {
         // This can happen if the init script has an addTalkInteraction() 
         // but doesn't have any topic() declarations.
         network.serializeAndSend(
@@ -257,7 +264,9 @@ const Dialogue* DialogueSystem::validateChoiceRequest(
                           "Dialogue component."});
         return nullptr;
     }
-    else if ((choiceRequest.topicIndex >= dialogue->topics.size())
+
+    const Dialogue::Definition* dialogue{dialogueComponent->definition.get()};
+    if ((choiceRequest.topicIndex >= dialogue->topics.size())
              || (choiceRequest.choiceIndex
                  >= dialogue->topics[choiceRequest.topicIndex]
                         .choices.size())) {
@@ -288,6 +297,8 @@ bool DialogueSystem::runChoiceCondition(const Dialogue::Choice& choice,
                                         bool sendAccessErrorMessage)
 {
     // Append "r=" to the script so the result gets saved to a variable.
+    // Note: The cache is keyed on the full string, so this is only compiled 
+    //       the first time it's seen.
     workString.clear();
     workString.append("r=");
     workString.append(choice.conditionScript);
@@ -295,8 +306,8 @@ bool DialogueSystem::runChoiceCondition(const Dialogue::Choice& choice,
     // Run the condition script.
     dialogueChoiceConditionLua.luaState["user"] = clientEntity;
     dialogueChoiceConditionLua.luaState["self"] = targetEntity;
-    auto scriptResult{dialogueChoiceConditionLua.luaState.script(
-        workString, &sol::script_pass_on_error)};
+    auto scriptResult{dialogueChoiceConditionLua.scriptCache.run(
+        workString, {"Choice condition", "", targetEntity})};
 
     if (!(scriptResult.valid())) {
         sol::error err = scriptResult;
@@ -197,7 +197,7 @@ void ItemSystem::useItemOnEntity(Uint8 sourceSlotIndex,
         // If we found a handler, run it.
         if (handlerScript) {
             runEntityItemHandlerScript(clientID, clientEntity, targetEntity,
-                                       *handlerScript);
+                                       sourceItemID, *handlerScript);
         }
         else {
             // No handler for the item. Give the user feedback.
@@ -357,14 +357,17 @@ bool ItemSystem::runItemInitScript(NetworkID clientID,
 
 void ItemSystem::runEntityItemHandlerScript(
     NetworkID clientID, entt::entity clientEntity, entt::entity targetEntity,
-    const EntityItemHandlerScript& itemHandlerScript)
+    ItemID itemID, const EntityItemHandlerScript& itemHandlerScript)
 {
     // Run the given handler script.
     entityItemHandlerLua.clientID = clientID;
     entityItemHandlerLua.luaState["user"] = clientEntity;
     entityItemHandlerLua.luaState["self"] = targetEntity;
-    auto result{entityItemHandlerLua.luaState.script(
-        itemHandlerScript.script, &sol::script_pass_on_error)};
+    const Item* item{world.itemData.getItem(itemID)};
+    std::string_view itemStringID{item ? item->stringID : std::string_view{}};
+    auto result{entityItemHandlerLua.scriptCache.run(
+        itemHandlerScript.script,
+        {"Item handler", itemStringID, targetEntity})};
 
     // If there was an error while running the handler script, tell the
     // user.
@@ -20,6 +20,44 @@ namespace AM
 {
 namespace Server
 {
+/**
+ * sol2 customization points, so the stored value bindings can take a 
+ * StoredValueKey wherever Lua passes a string ID or handle.
+ */
+template<typename Handler>
+bool sol_lua_check(sol::types<StoredValueKey>, lua_State* luaState,
+                   int index, Handler&& handler, sol::stack::record& tracking)
+{
+    tracking.use(1);
+
+    int type{lua_type(luaState, index)};
+    if ((type == LUA_TSTRING) || (type == LUA_TNUMBER)) {
+        return true;
+    }
+
+    handler(luaState, index, sol::type::string, sol::type_of(luaState, index),
+            "expected a stored value string ID or handle");
+    return false;
+}
+
+StoredValueKey sol_lua_get(sol::types<StoredValueKey>, lua_State* luaState,
+                           int index, sol::stack::record& tracking)
+{
+    tracking.use(1);
+
+    if (lua_type(luaState, index) == LUA_TNUMBER) {
+        // Note: Out-of-range handles become null, which the bindings reject.
+        lua_Integer handle{lua_tointeger(luaState, index)};
+        if ((handle <= 0) || (handle > SDL_MAX_UINT16)) {
+            handle = NULL_ENTITY_STORED_VALUE_ID;
+        }
+        return {{}, static_cast<EntityStoredValueID>(handle)};
+    }
+
+    std::size_t length{0};
+    const char* stringID{lua_tolstring(luaState, index, &length)};
+    return {{stringID, length}, NULL_ENTITY_STORED_VALUE_ID};
+}
 
 EngineLuaBindings::EngineLuaBindings(
     EntityInitLua& inEntityInitLua,
@@ -86,6 +124,8 @@ void EngineLuaBindings::addEntityItemHandlerBindings()
             return getItemCount(entityToCount, itemID,
                                 entityItemHandlerLua.clientID);
         });
+    entityItemHandlerLua.luaState.set_function(
+        "getStoredValueHandle", &EngineLuaBindings::getStoredValueHandle, this);
     entityItemHandlerLua.luaState.set_function(
         "storeUint", &EngineLuaBindings::storeUint, this);
     entityItemHandlerLua.luaState.set_function(
@@ -160,6 +200,8 @@ void EngineLuaBindings::addDialogueBindings()
         [&](entt::entity entityToCount, std::string_view itemID) {
             return getItemCount(entityToCount, itemID, dialogueLua.clientID);
         });
+    dialogueLua.luaState.set_function(
+        "getStoredValueHandle", &EngineLuaBindings::getStoredValueHandle, this);
     dialogueLua.luaState.set_function("storeUint",
                                       &EngineLuaBindings::storeUint, this);
     dialogueLua.luaState.set_function("storeBool",
@@ -208,6 +250,8 @@ void EngineLuaBindings::addDialogueChoiceConditionBindings()
             return getItemCount(entityToCount, itemID,
                                 dialogueChoiceConditionLua.clientID);
         });
+    dialogueChoiceConditionLua.luaState.set_function(
+        "getStoredValueHandle", &EngineLuaBindings::getStoredValueHandle, this);
     dialogueChoiceConditionLua.luaState.set_function(
         "getStoredUint", &EngineLuaBindings::getStoredUint, this);
     dialogueChoiceConditionLua.luaState.set_function(
@@ -261,7 +305,20 @@ void EngineLuaBindings::topic(std::string_view topicName,
                               std::string_view choiceScript)
 {
     entt::entity entity{entityInitLua.selfEntity};
-    Dialogue& dialogue{world.registry.get_or_emplace<Dialogue>(entity)};
+    Dialogue& dialogueComponent{
+        world.registry.get_or_emplace<Dialogue>(entity)};
+
+    // If the definition is missing or shared, give this entity its own.
+    std::shared_ptr<Dialogue::Definition>& definition{
+        dialogueComponent.definition};
+    if (!definition) {
+        definition = std::make_shared<Dialogue::Definition>();
+    }
+    else if (definition.use_count() > 1) {
+        definition = std::make_shared<Dialogue::Definition>(*definition);
+    }
+
+    Dialogue::Definition& dialogue{*definition};
     if ((dialogue.topics.size() - 1) == SDL_MAX_UINT8) {
         workString.clear();
         workString.append("Failed to add topic \"");
@@ -463,8 +520,20 @@ std::size_t EngineLuaBindings::getItemCount(entt::entity entityToCount,
     return 0;
 }
 
-void EngineLuaBindings::storeUint(entt::entity entity,
-                                  std::string_view stringID, Uint32 newValue)
+EntityStoredValueID
+    EngineLuaBindings::getStoredValueHandle(std::string_view stringID)
+{
+    EntityStoredValueID handle{world.getEntityStoredValueID(stringID)};
+    if (!handle) {
+        throw std::runtime_error{
+            "Failed to get stored value handle: value limit is reached."};
+    }
+
+    return handle;
+}
+
+void EngineLuaBindings::storeUint(entt::entity entity, StoredValueKey key,
+                                  Uint32 newValue)
 {
     // If we were given a non-null entity, use its store.
     if (entity != entt::null) {
@@ -473,63 +542,61 @@ void EngineLuaBindings::storeUint(entt::entity entity,
                 "Failed to store value: Invalid entity ID."};
         }
 
-        // Try to store the value.
+        // Store the value.
+        EntityStoredValueID numericID{getEntityStoredValueID(key)};
         StoredValues& storedValues{
             world.registry.get_or_emplace<StoredValues>(entity)};
-        if (!(storedValues.storeValue(stringID, newValue, world))) {
-            workString.clear();
-            workString.append("Failed to store value \"");
-            workString.append(stringID);
-            workString.append("\": value doesn't exist and value limit is reached");
-            throw std::runtime_error{workString};
-        }
+        storedValues.storeValue(numericID, newValue);
+
+        // Let any observers know that the values changed.
+        world.registry.patch<StoredValues>(entity);
     }
     else {
         // We were given entt::null, use the global store.
-        world.storeGlobalValue(stringID, newValue);
+        world.storeGlobalValue(getGlobalStoredValueID(key), newValue);
     }
 }
 
-void EngineLuaBindings::storeBool(entt::entity entity,
-                                  std::string_view stringID, bool newValue)
+void EngineLuaBindings::storeBool(entt::entity entity, StoredValueKey key,
+                                  bool newValue)
 {
-    storeUint(entity, stringID, static_cast<Uint32>(newValue));
+    storeUint(entity, key, static_cast<Uint32>(newValue));
 }
 
-void EngineLuaBindings::storeInt(entt::entity entity, std::string_view stringID,
+void EngineLuaBindings::storeInt(entt::entity entity, StoredValueKey key,
                                  int newValue)
 {
-    storeUint(entity, stringID, static_cast<Uint32>(newValue));
+    storeUint(entity, key, static_cast<Uint32>(newValue));
 }
 
-void EngineLuaBindings::storeFloat(entt::entity entity,
-                                   std::string_view stringID, float newValue)
+void EngineLuaBindings::storeFloat(entt::entity entity, StoredValueKey key,
+                                   float newValue)
 {
     static_assert(sizeof(float) == 4, "float is expected to be 4 bytes.");
 
     // Copy the float's bytes to a Uint32 without converting.
     Uint32 newValueUint{};
     std::memcpy(&newValueUint, &newValue, 4);
-    storeUint(entity, stringID, newValueUint);
+    storeUint(entity, key, newValueUint);
 }
 
-void EngineLuaBindings::storeTime(entt::entity entity,
-                                  std::string_view stringID, Uint32 newValue)
+void EngineLuaBindings::storeTime(entt::entity entity, StoredValueKey key,
+                                  Uint32 newValue)
 {
     // Note: Time is only a type to make scripts more readable. It's handled 
     //       the same as Uint32.
-    storeUint(entity, stringID, newValue);
+    storeUint(entity, key, newValue);
 }
 
-void EngineLuaBindings::storeBitSet(entt::entity entity,
-                                    std::string_view stringID, Uint32 newValue)
+void EngineLuaBindings::storeBitSet(entt::entity entity, StoredValueKey key,
+                                    Uint32 newValue)
 {
     // Note: BitSet is only a type to make scripts more readable. It's handled 
     //       the same as Uint32.
-    storeUint(entity, stringID, newValue);
+    storeUint(entity, key, newValue);
 }
 
-void EngineLuaBindings::storeBit(entt::entity entity, std::string_view stringID,
+void EngineLuaBindings::storeBit(entt::entity entity, StoredValueKey key,
                                  Uint8 bitToSet, bool newValue)
 {
     if (bitToSet > 31) {
@@ -539,16 +606,16 @@ void EngineLuaBindings::storeBit(entt::entity entity, std::string_view stringID,
 
     // This will give us either the current value if it already exists, or 
     // 0 (a fresh bit set).
-    Uint32 bitSet{getStoredUint(entity, stringID)};
+    Uint32 bitSet{getStoredUint(entity, key)};
 
     // Set the bit and store the new value.
     setBit(bitSet, bitToSet, newValue);
 
-    storeUint(entity, stringID, bitSet);
+    storeUint(entity, key, bitSet);
 }
 
 Uint32 EngineLuaBindings::getStoredUint(entt::entity entity,
-                                        std::string_view stringID)
+                                        StoredValueKey key)
 {
     // If we were given a non-null entity, use its store.
     if (entity != entt::null) {
@@ -557,36 +624,40 @@ Uint32 EngineLuaBindings::getStoredUint(entt::entity entity,
                 "Failed to get stored value: Invalid entity ID."};
         }
 
+        // If the value has never been stored, it has the default value.
+        EntityStoredValueID numericID{findEntityStoredValueID(key)};
+        if (!numericID) {
+            return 0;
+        }
+
         // Try to get the value.
         if (auto* storedValues{world.registry.try_get<StoredValues>(entity)}) {
-            return storedValues->getStoredValue(stringID, world);
+            return storedValues->getStoredValue(numericID);
         }
     }
     else {
         // We were given entt::null, use the global store.
-        return world.getStoredValue(stringID);
+        return world.getStoredValue(getGlobalStoredValueID(key));
     }
 
     return 0;
 }
 
-bool EngineLuaBindings::getStoredBool(entt::entity entity,
-                                      std::string_view stringID)
+bool EngineLuaBindings::getStoredBool(entt::entity entity, StoredValueKey key)
 {
-    return static_cast<bool>(getStoredUint(entity, stringID));
+    return static_cast<bool>(getStoredUint(entity, key));
 }
 
-int EngineLuaBindings::getStoredInt(entt::entity entity,
-                                    std::string_view stringID)
+int EngineLuaBindings::getStoredInt(entt::entity entity, StoredValueKey key)
 {
-    return static_cast<int>(getStoredUint(entity, stringID));
+    return static_cast<int>(getStoredUint(entity, key));
 }
 
 float EngineLuaBindings::getStoredFloat(entt::entity entity,
-                                        std::string_view stringID)
+                                        StoredValueKey key)
 {
     // Copy the stored Uint32's bytes to a float without converting.
-    Uint32 storedValue{getStoredUint(entity, stringID)};
+    Uint32 storedValue{getStoredUint(entity, key)};
     float storedValueFloat{};
     std::memcpy(&storedValueFloat, &storedValue, 4);
 
@@ -594,23 +665,23 @@ float EngineLuaBindings::getStoredFloat(entt::entity entity,
 }
 
 Uint32 EngineLuaBindings::getStoredTime(entt::entity entity,
-                                        std::string_view stringID)
+                                        StoredValueKey key)
 {
     // Note: Time is only a type to make scripts more readable. It's handled 
     //       the same as Uint32.
-    return getStoredUint(entity, stringID);
+    return getStoredUint(entity, key);
 }
 
 Uint32 EngineLuaBindings::getStoredBitSet(entt::entity entity,
-                                                   std::string_view stringID)
+                                          StoredValueKey key)
 {
     // Note: BitSet is only a type to make scripts more readable. It's handled 
     //       the same as Uint32.
-    return getStoredUint(entity, stringID);
+    return getStoredUint(entity, key);
 }
 
-bool EngineLuaBindings::getStoredBit(entt::entity entity,
-                                     std::string_view stringID, Uint8 bitToGet)
+bool EngineLuaBindings::getStoredBit(entt::entity entity, StoredValueKey key,
+                                     Uint8 bitToGet)
 {
     if (bitToGet > 31) {
         throw std::runtime_error{
@@ -619,7 +690,7 @@ bool EngineLuaBindings::getStoredBit(entt::entity entity,
 
     // This will give us either the current value if it already exists, or 
     // 0 (a fresh bit set).
-    Uint32 storedValue{getStoredUint(entity, stringID)};
+    Uint32 storedValue{getStoredUint(entity, key)};
 
     return getBit(storedValue, bitToGet);
 }
@@ -663,5 +734,63 @@ void EngineLuaBindings::sendSystemMessage(std::string_view message,
     network.serializeAndSend(clientID, SystemMessage{std::string{message}});
 }
 
+EntityStoredValueID
+    EngineLuaBindings::getEntityStoredValueID(const StoredValueKey& key)
+{
+    // If we were given a string ID, look it up (adding it if necessary).
+    if (!(key.stringID.empty())) {
+        EntityStoredValueID numericID{
+            world.getEntityStoredValueID(key.stringID)};
+        if (!numericID) {
+            workString.clear();
+            workString.append("Failed to add stored value \"");
+            workString.append(key.stringID);
+            workString.append("\": value limit is reached");
+            throw std::runtime_error{workString};
+        }
+
+        return numericID;
+    }
+
+    // We were given a handle, make sure it's one that we gave out.
+    if (world.getEntityStoredValueStringID(key.handle).empty()) {
+        throw std::runtime_error{"Invalid stored value handle."};
+    }
+
+    return key.handle;
+}
+
+EntityStoredValueID
+    EngineLuaBindings::findEntityStoredValueID(const StoredValueKey& key)
+{
+    if (!(key.stringID.empty())) {
+        return world.findEntityStoredValueID(key.stringID);
+    }
+
+    // We were given a handle, make sure it's one that we gave out.
+    if (world.getEntityStoredValueStringID(key.handle).empty()) {
+        throw std::runtime_error{"Invalid stored value handle."};
+    }
+
+    return key.handle;
+}
+
+std::string_view
+    EngineLuaBindings::getGlobalStoredValueID(const StoredValueKey& key)
+{
+    if (!(key.stringID.empty())) {
+        return key.stringID;
+    }
+
+    // We were given a handle. Global values are keyed by string ID, so use 
+    // the string that the handle was made from.
+    std::string_view stringID{world.getEntityStoredValueStringID(key.handle)};
+    if (stringID.empty()) {
+        throw std::runtime_error{"Invalid stored value handle."};
+    }
+
+    return stringID;
+}
+
 } // namespace Server
 } // namespace AM
@@ -0,0 +1,155 @@
+#include "LuaScriptCache.h"
+#include "Config.h"
+#include "Log.h"
+#include <algorithm>
+#include <vector>
+
+namespace AM
+{
+namespace Server
+{
+LuaScriptCache::LuaScriptCache(sol::state& inLuaState,
+                               std::string_view inEnvironmentName)
+: luaState{inLuaState}
+, environmentName{inEnvironmentName}
+, compiledScripts{}
+, scriptStats{}
+, runTimer{}
+, workLabel{}
+{
+}
+
+sol::protected_function_result
+    LuaScriptCache::run(std::string_view script, const ScriptSource& source)
+{
+    auto scriptIt{compiledScripts.find(script)};
+    if (scriptIt == compiledScripts.end()) {
+        // Compile the script.
+        sol::load_result loadResult{luaState.load(script)};
+        if (!(loadResult.valid())) {
+            // Let script() build the error result, so compile errors are 
+            // reported the same way as they were before we cached.
+            recordRun(source, 0, true);
+            return luaState.script(script, &sol::script_pass_on_error);
+        }
+
+        // If the cache is full, start it over.
+        if (compiledScripts.size() >= Config::LUA_SCRIPT_CACHE_SIZE) {
+            compiledScripts.clear();
+        }
+
+        scriptIt = compiledScripts
+                       .emplace(std::string{script},
+                                loadResult.get<sol::protected_function>())
+                       .first;
+    }
+
+    // Run the script, with the instruction budget hook set for the duration.
+    // Note: The count restarts each time the hook is set.
+    lua_State* state{luaState.lua_state()};
+    if (Config::LUA_SCRIPT_INSTRUCTION_BUDGET > 0) {
+        lua_sethook(state, &onInstructionBudgetExceeded, LUA_MASKCOUNT,
+                    Config::LUA_SCRIPT_INSTRUCTION_BUDGET);
+    }
+
+    runTimer.reset();
+    sol::protected_function_result result{scriptIt->second()};
+    double timeS{runTimer.getTime()};
+
+    lua_sethook(state, nullptr, 0, 0);
+
+    recordRun(source, timeS, !(result.valid()));
+
+    return result;
+}
+
+const std::unordered_map<std::string, LuaScriptCache::ScriptStats,
+                         string_hash, std::equal_to<>>&
+    LuaScriptCache::getScriptStats() const
+{
+    return scriptStats;
+}
+
+void LuaScriptCache::logHotScripts()
+{
+    if (scriptStats.empty()) {
+        return;
+    }
+
+    // Find the scripts with the highest total time.
+    using StatsPair = std::pair<const std::string, ScriptStats>;
+    std::vector<const StatsPair*> sortedStats{};
+    sortedStats.reserve(scriptStats.size());
+    for (const StatsPair& statsPair : scriptStats) {
+        sortedStats.push_back(&statsPair);
+    }
+
+    std::size_t logCount{
+        std::min(sortedStats.size(), Config::LUA_SCRIPT_STATS_LOG_COUNT)};
+    std::partial_sort(sortedStats.begin(), (sortedStats.begin() + logCount),
+                      sortedStats.end(),
+                      [](const StatsPair* a, const StatsPair* b) {
+                          return a->second.totalTimeS > b->second.totalTimeS;
+                      });
+
+    LOG_INFO("Hottest %.*s scripts:", static_cast<int>(environmentName.size()),
+             environmentName.data());
+    for (std::size_t i{0}; i < logCount; ++i) {
+        const auto& [label, stats]{*(sortedStats[i])};
+        LOG_INFO("  %s: %u calls, %u errors, %.3fms total, %.3fms max",
+                 label.c_str(), stats.callCount, stats.errorCount,
+                 (stats.totalTimeS * 1000), (stats.maxTimeS * 1000));
+    }
+
+    clearScriptStats();
+}
+
+void LuaScriptCache::clearScriptStats()
+{
+    scriptStats.clear();
+}
+
+void LuaScriptCache::onInstructionBudgetExceeded(lua_State* state,
+                                                 lua_Debug*)
+{
+    luaL_error(state, "Script exceeded its budget of %d instructions.",
+               Config::LUA_SCRIPT_INSTRUCTION_BUDGET);
+}
+
+void LuaScriptCache::recordRun(const ScriptSource& source, double timeS,
+                               bool failed)
+{
+    // Build the label.
+    workLabel.clear();
+    workLabel.append(source.type);
+    if (!(source.name.empty())) {
+        workLabel.append(" \"");
+        workLabel.append(source.name);
+        workLabel.append("\"");
+    }
+    if (source.entity != entt::null) {
+        workLabel.append(" (entity ");
+        workLabel.append(std::to_string(entt::to_integral(source.entity)));
+        workLabel.append(")");
+    }
+
+    auto statsIt{scriptStats.find(workLabel)};
+    if (statsIt == scriptStats.end()) {
+        // If we're tracking too many scripts, start over (like the cache).
+        if (scriptStats.size() >= Config::LUA_SCRIPT_CACHE_SIZE) {
+            scriptStats.clear();
+        }
+        statsIt = scriptStats.emplace(workLabel, ScriptStats{}).first;
+    }
+
+    ScriptStats& stats{statsIt->second};
+    stats.callCount++;
+    if (failed) {
+        stats.errorCount++;
+    }
+    stats.totalTimeS += timeS;
+    stats.maxTimeS = std::max(stats.maxTimeS, timeS);
+}
+
+} // namespace Server
+} // namespace AM
@@ -39,7 +39,12 @@ void MovementSystem::processMovements()
             position, input.inputStates, SharedConfig::SIM_TICK_TIMESTEP_S);
 
         // Update the direction they're facing, based on their current inputs.
+        Rotation previousRotation{rotation};
         rotation = MovementHelpers::calcRotation(rotation, input.inputStates);
+        if (rotation.direction != previousRotation.direction) {
+            // Note: We patch so that observers (e.g. SaveSystem) see it.
+            world.registry.patch<Rotation>(entity);
+        }
 
         // If they're trying to move, resolve collisions.
         if (desiredPosition != position) {
@@ -47,6 +52,10 @@ void MovementSystem::processMovements()
             BoundingBox desiredBounds{Transforms::modelToWorldCentered(
                 collision.modelBounds, desiredPosition)};
 
+            // Make sure the tiles that we're about to test are loaded.
+            world.tileMap.ensureChunksLoaded(
+                MovementHelpers::getTileCollisionChunkExtent(desiredBounds));
+
             // Resolve any collisions with the surrounding bounding boxes.
             BoundingBox resolvedBounds{MovementHelpers::resolveCollisions(
                 collision.worldBounds, desiredBounds, entity, world.registry,
@@ -64,6 +73,7 @@ void MovementSystem::processMovements()
         if (position != previousPosition) {
             world.entityLocator.setEntityLocation(entity,
                                                   collision.worldBounds);
+            world.registry.patch<Position>(entity);
         }
     }
 }
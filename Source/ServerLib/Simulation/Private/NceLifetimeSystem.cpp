@@ -6,6 +6,7 @@
 #include "Position.h"
 #include "EntityInitScript.h"
 #include "IsClientEntity.h"
+#include "AOIObservers.h"
 #include "SystemMessage.h"
 #include "ISimulationExtension.h"
 #include "ItemHandlers.h"
@@ -67,8 +68,13 @@ void NceLifetimeSystem::handleInitRequest(
         // Double-check that the ID is actually in use.
         if (world.registry.valid(entityInitRequest.entity)) {
             // This is an existing entity. Remove all of its components.
+            // Note: AOIObservers is kept, so that ClientAOISystem can keep the
+            //       reverse index in sync as the entity leaves and re-enters
+            //       each client's AOI.
             for (auto [id, storage] : world.registry.storage()) {
-                storage.remove(entityInitRequest.entity);
+                if (id != entt::type_hash<AOIObservers>::value()) {
+                    storage.remove(entityInitRequest.entity);
+                }
             }
 
             // Remove it from the entity locator.
@@ -0,0 +1,549 @@
+#include "NavGraph.h"
+#include "TileMapBase.h"
+#include "MovementHelpers.h"
+#include "Position.h"
+#include "Config.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <functional>
+
+namespace AM
+{
+namespace Server
+{
+/** The cost of a tile that can't be reached. */
+static constexpr float INFINITE_COST{std::numeric_limits<float>::infinity()};
+
+/** The cost of moving diagonally between tiles (cardinal moves cost 1). */
+static constexpr float DIAGONAL_COST{1.41421356f};
+
+/**
+ * Returns the octile distance between the given tiles.
+ */
+static float estimateCost(const TilePosition& from, const TilePosition& to)
+{
+    float xDistance{static_cast<float>(std::abs(to.x - from.x))};
+    float yDistance{static_cast<float>(std::abs(to.y - from.y))};
+    return std::max(xDistance, yDistance)
+           + ((DIAGONAL_COST - 1) * std::min(xDistance, yDistance));
+}
+
+NavGraph::NavGraph(TileMapBase& inTileMap)
+: tileMap{inTileMap}
+, navChunks{}
+{
+}
+
+void NavGraph::ensureBuilt(const ChunkExtent& extent)
+{
+    ChunkExtent mapExtent{tileMap.getChunkExtent()};
+    ChunkExtent buildExtent{extent};
+    buildExtent.intersectWith(mapExtent);
+
+    for (int z{buildExtent.z}; z <= buildExtent.zMax(); ++z) {
+        for (int y{buildExtent.y}; y <= buildExtent.yMax(); ++y) {
+            for (int x{buildExtent.x}; x <= buildExtent.xMax(); ++x) {
+                ChunkPosition chunkPosition{x, y, z};
+                auto [navChunkIt, wasInserted]{
+                    navChunks.try_emplace(chunkPosition)};
+                if (wasInserted) {
+                    // Crossings are tested against the neighbors' collision
+                    // too, so make sure they're all loaded.
+                    tileMap.ensureChunksLoaded({(x - 1), (y - 1), (z - 1), 3,
+                                                3, 3});
+                    buildNavChunk(chunkPosition, navChunkIt->second);
+                }
+            }
+        }
+    }
+}
+
+void NavGraph::invalidate(const ChunkPosition& chunkPosition)
+{
+    // A chunk's crossings are tested against its neighbors' collision, and
+    // collision is checked up to 1 tile above and below.
+    for (int z{chunkPosition.z - 1}; z <= (chunkPosition.z + 1); ++z) {
+        for (int y{chunkPosition.y - 1}; y <= (chunkPosition.y + 1); ++y) {
+            for (int x{chunkPosition.x - 1}; x <= (chunkPosition.x + 1); ++x) {
+                navChunks.erase(ChunkPosition{x, y, z});
+            }
+        }
+    }
+}
+
+void NavGraph::clear()
+{
+    navChunks.clear();
+}
+
+bool NavGraph::findPath(const TilePosition& start, const TilePosition& goal,
+                        const ChunkExtent& searchExtent,
+                        std::vector<TilePosition>& outPath) const
+{
+    outPath.clear();
+
+    // Find the start and goal chunks.
+    ChunkPosition startChunkPosition{start};
+    ChunkPosition goalChunkPosition{goal};
+    if ((start.z != goal.z)
+        || !(searchExtent.containsPosition(startChunkPosition))
+        || !(searchExtent.containsPosition(goalChunkPosition))) {
+        return false;
+    }
+    auto startChunkIt{navChunks.find(startChunkPosition)};
+    auto goalChunkIt{navChunks.find(goalChunkPosition)};
+    if ((startChunkIt == navChunks.end()) || (goalChunkIt == navChunks.end())) {
+        return false;
+    }
+    if (start == goal) {
+        return true;
+    }
+
+    const NavChunk& startChunk{startChunkIt->second};
+    const NavChunk& goalChunk{goalChunkIt->second};
+    TilePosition startOrigin{startChunkPosition};
+    TilePosition goalOrigin{goalChunkPosition};
+    int startTile{((start.y - startOrigin.y) * CHUNK_WIDTH)
+                  + (start.x - startOrigin.x)};
+    int goalTile{((goal.y - goalOrigin.y) * CHUNK_WIDTH)
+                 + (goal.x - goalOrigin.x)};
+
+    // Find the cost from the start and goal to each tile in their chunks.
+    ChunkSearch startSearch{};
+    searchChunk(startChunk, startTile, -1, startSearch);
+    ChunkSearch goalSearch{};
+    searchChunk(goalChunk, goalTile, -1, goalSearch);
+
+    // Portal nodes are keyed by their chunk's index within the search
+    // extent, and their index within the chunk.
+    static constexpr Uint32 MAX_CHUNK_PORTALS{4 * CHUNK_WIDTH};
+    static constexpr Uint32 START_KEY{SDL_MAX_UINT32 - 1};
+    static constexpr Uint32 GOAL_KEY{SDL_MAX_UINT32};
+    auto getChunkIndex = [&](const ChunkPosition& chunkPosition) {
+        return static_cast<Uint32>(
+            (((chunkPosition.z - searchExtent.z) * searchExtent.yLength)
+             + (chunkPosition.y - searchExtent.y))
+                * searchExtent.xLength
+            + (chunkPosition.x - searchExtent.x));
+    };
+    auto getChunkPosition = [&](Uint32 key) {
+        int chunkIndex{static_cast<int>(key / MAX_CHUNK_PORTALS)};
+        return ChunkPosition{
+            searchExtent.x + (chunkIndex % searchExtent.xLength),
+            searchExtent.y
+                + ((chunkIndex / searchExtent.xLength) % searchExtent.yLength),
+            searchExtent.z
+                + (chunkIndex
+                   / (searchExtent.xLength * searchExtent.yLength))};
+    };
+    auto getTilePosition = [](const TilePosition& chunkOrigin, int tile) {
+        return TilePosition{chunkOrigin.x + (tile % CHUNK_WIDTH),
+                            chunkOrigin.y + (tile / CHUNK_WIDTH),
+                            chunkOrigin.z};
+    };
+
+    // Run A* over the portals.
+    struct Node {
+        float cost{INFINITE_COST};
+        Uint32 parentKey{START_KEY};
+        bool isClosed{false};
+    };
+    std::unordered_map<Uint32, Node> nodes{};
+    using QueueEntry = std::pair<float, Uint32>;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+                        std::greater<QueueEntry>>
+        openQueue{};
+    auto pushNode = [&](Uint32 key, float cost, Uint32 parentKey,
+                        const TilePosition& tilePosition) {
+        Node& node{nodes[key]};
+        if (!(node.isClosed) && (cost < node.cost)) {
+            node.cost = cost;
+            node.parentKey = parentKey;
+            openQueue.emplace((cost + estimateCost(tilePosition, goal)), key);
+        }
+    };
+
+    // If the goal is in the start chunk, it may be reachable directly.
+    if ((startChunkPosition == goalChunkPosition)
+        && (startSearch.costs[goalTile] != INFINITE_COST)) {
+        pushNode(GOAL_KEY, startSearch.costs[goalTile], START_KEY, goal);
+    }
+    Uint32 startChunkIndex{getChunkIndex(startChunkPosition)};
+    for (std::size_t i{0}; i < startChunk.portals.size(); ++i) {
+        int portalTile{startChunk.portals[i].tileIndex};
+        if (startSearch.costs[portalTile] != INFINITE_COST) {
+            pushNode(static_cast<Uint32>((startChunkIndex * MAX_CHUNK_PORTALS)
+                                         + i),
+                     startSearch.costs[portalTile], START_KEY,
+                     getTilePosition(startOrigin, portalTile));
+        }
+    }
+
+    // The neighbor and matching tile that each crossing direction leads to.
+    struct Crossing {
+        Direction direction;
+        int xOffset;
+        int yOffset;
+        int tileOffset;
+    };
+    static constexpr std::array<Crossing, 4> CROSSINGS{
+        {{PosX, 1, 0, -(CHUNK_WIDTH - 1)},
+         {NegX, -1, 0, (CHUNK_WIDTH - 1)},
+         {PosY, 0, 1, -((CHUNK_WIDTH - 1) * CHUNK_WIDTH)},
+         {NegY, 0, -1, ((CHUNK_WIDTH - 1) * CHUNK_WIDTH)}}};
+
+    bool goalWasReached{false};
+    while (!(openQueue.empty())) {
+        Uint32 key{openQueue.top().second};
+        openQueue.pop();
+
+        // Note: We copy what we need, since pushing may rehash the map.
+        Node& node{nodes[key]};
+        if (node.isClosed) {
+            continue;
+        }
+        node.isClosed = true;
+        float cost{node.cost};
+        if (key == GOAL_KEY) {
+            goalWasReached = true;
+            break;
+        }
+
+        Uint32 chunkIndex{key / MAX_CHUNK_PORTALS};
+        std::size_t portalIndex{key % MAX_CHUNK_PORTALS};
+        ChunkPosition chunkPosition{getChunkPosition(key)};
+        TilePosition chunkOrigin{chunkPosition};
+        const NavChunk& navChunk{navChunks.find(chunkPosition)->second};
+        const Portal& portal{navChunk.portals[portalIndex]};
+
+        // Push the other portals in this chunk.
+        std::size_t portalCount{navChunk.portals.size()};
+        for (std::size_t i{0}; i < portalCount; ++i) {
+            float portalCost{
+                navChunk.portalCosts[(portalIndex * portalCount) + i]};
+            if ((i != portalIndex) && (portalCost != INFINITE_COST)) {
+                pushNode(static_cast<Uint32>((chunkIndex * MAX_CHUNK_PORTALS)
+                                             + i),
+                         (cost + portalCost), key,
+                         getTilePosition(chunkOrigin,
+                                         navChunk.portals[i].tileIndex));
+            }
+        }
+
+        // If this is the goal chunk, push the goal.
+        if ((chunkPosition == goalChunkPosition)
+            && (goalSearch.costs[portal.tileIndex] != INFINITE_COST)) {
+            pushNode(GOAL_KEY, (cost + goalSearch.costs[portal.tileIndex]),
+                     key, goal);
+        }
+
+        // Push the matching portal in each neighbor that we cross into.
+        // Note: Crossings are symmetric, so the neighbor always has a
+        //       matching portal unless one of the chunks is out of date.
+        for (const Crossing& crossing : CROSSINGS) {
+            if (!(portal.crossings & crossing.direction)) {
+                continue;
+            }
+
+            ChunkPosition neighborPosition{chunkPosition.x + crossing.xOffset,
+                                           chunkPosition.y + crossing.yOffset,
+                                           chunkPosition.z};
+            if (!(searchExtent.containsPosition(neighborPosition))) {
+                continue;
+            }
+            auto neighborIt{navChunks.find(neighborPosition)};
+            if (neighborIt == navChunks.end()) {
+                continue;
+            }
+
+            int neighborTile{portal.tileIndex + crossing.tileOffset};
+            Sint16 neighborPortalIndex{
+                neighborIt->second.portalIndices[neighborTile]};
+            if (neighborPortalIndex != -1) {
+                pushNode(static_cast<Uint32>(
+                             (getChunkIndex(neighborPosition)
+                              * MAX_CHUNK_PORTALS)
+                             + neighborPortalIndex),
+                         (cost + 1), key,
+                         getTilePosition(TilePosition{neighborPosition},
+                                         neighborTile));
+            }
+        }
+    }
+
+    if (!goalWasReached) {
+        return false;
+    }
+
+    // Walk back from the goal to get the portals that we passed through.
+    std::vector<Uint32> pathKeys{};
+    for (Uint32 key{GOAL_KEY}; key != START_KEY;
+         key = nodes.find(key)->second.parentKey) {
+        pathKeys.push_back(key);
+    }
+    std::reverse(pathKeys.begin(), pathKeys.end());
+
+    // Refine each leg of the path into tiles.
+    ChunkPosition previousChunkPosition{startChunkPosition};
+    int previousTile{startTile};
+    for (Uint32 key : pathKeys) {
+        ChunkPosition chunkPosition{goalChunkPosition};
+        int tile{goalTile};
+        if (key != GOAL_KEY) {
+            chunkPosition = getChunkPosition(key);
+            tile = navChunks.find(chunkPosition)
+                       ->second.portals[key % MAX_CHUNK_PORTALS]
+                       .tileIndex;
+        }
+
+        // If this leg crosses into a neighbor, the tiles are adjacent.
+        TilePosition chunkOrigin{chunkPosition};
+        if (chunkPosition != previousChunkPosition) {
+            outPath.push_back(getTilePosition(chunkOrigin, tile));
+        }
+        else if (!appendChunkPath(navChunks.find(chunkPosition)->second,
+                                  chunkOrigin, previousTile, tile, outPath)) {
+            outPath.clear();
+            return false;
+        }
+
+        previousChunkPosition = chunkPosition;
+        previousTile = tile;
+    }
+
+    return true;
+}
+
+void NavGraph::buildNavChunk(const ChunkPosition& chunkPosition,
+                             NavChunk& navChunk)
+{
+    // Find which directions an agent can move out of each tile in.
+    // Note: Crossing is symmetric, so we only test +X and +Y within the
+    //       chunk and mirror them.
+    TilePosition origin{chunkPosition};
+    navChunk.moves.fill(0);
+    for (int y{0}; y < CHUNK_WIDTH; ++y) {
+        for (int x{0}; x < CHUNK_WIDTH; ++x) {
+            TilePosition tile{origin.x + x, origin.y + y, origin.z};
+            int tileIndex{(y * CHUNK_WIDTH) + x};
+            Uint8& moves{navChunk.moves[tileIndex]};
+
+            if (canCross(tile, {tile.x + 1, tile.y, tile.z})) {
+                moves |= PosX;
+                if ((x + 1) < CHUNK_WIDTH) {
+                    navChunk.moves[tileIndex + 1] |= NegX;
+                }
+            }
+            if (canCross(tile, {tile.x, tile.y + 1, tile.z})) {
+                moves |= PosY;
+                if ((y + 1) < CHUNK_WIDTH) {
+                    navChunk.moves[tileIndex + CHUNK_WIDTH] |= NegY;
+                }
+            }
+            if ((x == 0) && canCross(tile, {tile.x - 1, tile.y, tile.z})) {
+                moves |= NegX;
+            }
+            if ((y == 0) && canCross(tile, {tile.x, tile.y - 1, tile.z})) {
+                moves |= NegY;
+            }
+        }
+    }
+
+    // Add the portals along each edge.
+    navChunk.portals.clear();
+    navChunk.portalIndices.fill(-1);
+    addEdgePortals(navChunk, NegX, 0, CHUNK_WIDTH);
+    addEdgePortals(navChunk, PosX, (CHUNK_WIDTH - 1), CHUNK_WIDTH);
+    addEdgePortals(navChunk, NegY, 0, 1);
+    addEdgePortals(navChunk, PosY, ((CHUNK_WIDTH - 1) * CHUNK_WIDTH), 1);
+
+    // Find the cost between each pair of portals.
+    std::size_t portalCount{navChunk.portals.size()};
+    navChunk.portalCosts.assign((portalCount * portalCount), INFINITE_COST);
+    ChunkSearch search{};
+    for (std::size_t i{0}; i < portalCount; ++i) {
+        searchChunk(navChunk, navChunk.portals[i].tileIndex, -1, search);
+        for (std::size_t j{0}; j < portalCount; ++j) {
+            navChunk.portalCosts[(i * portalCount) + j]
+                = search.costs[navChunk.portals[j].tileIndex];
+        }
+    }
+}
+
+void NavGraph::addEdgePortals(NavChunk& navChunk, Direction direction,
+                              int firstTile, int tileStride)
+{
+    auto addPortal = [&](int edgeIndex) {
+        int tileIndex{firstTile + (edgeIndex * tileStride)};
+        Sint16& portalIndex{navChunk.portalIndices[tileIndex]};
+        if (portalIndex == -1) {
+            portalIndex = static_cast<Sint16>(navChunk.portals.size());
+            navChunk.portals.push_back({static_cast<Uint16>(tileIndex), 0});
+        }
+        navChunk.portals[portalIndex].crossings |= direction;
+    };
+
+    // Find each run of crossable tiles.
+    // Note: The neighbor finds the same runs from its side, so both chunks
+    //       place their portals on matching tiles.
+    int runStart{-1};
+    for (int i{0}; i <= CHUNK_WIDTH; ++i) {
+        bool isCrossable{
+            (i < CHUNK_WIDTH)
+            && (navChunk.moves[firstTile + (i * tileStride)] & direction)};
+        if (isCrossable && (runStart == -1)) {
+            runStart = i;
+        }
+        else if (!isCrossable && (runStart != -1)) {
+            // Long runs get a portal at each end, so paths through open
+            // areas don't all funnel through the middle.
+            int runEnd{i - 1};
+            if ((runEnd - runStart + 1) > PORTAL_SPLIT_LENGTH) {
+                addPortal(runStart);
+                addPortal(runEnd);
+            }
+            else {
+                addPortal((runStart + runEnd) / 2);
+            }
+            runStart = -1;
+        }
+    }
+}
+
+BoundingBox NavGraph::getAgentBounds(const TilePosition& tilePosition)
+{
+    static constexpr float HALF_WIDTH{Config::PATHFINDING_AGENT_WIDTH / 2.f};
+    Position center{tilePosition.getCenteredBottomPosition()};
+    return {(center.x - HALF_WIDTH),
+            (center.x + HALF_WIDTH),
+            (center.y - HALF_WIDTH),
+            (center.y + HALF_WIDTH),
+            center.z,
+            (center.z + Config::PATHFINDING_AGENT_HEIGHT)};
+}
+
+bool NavGraph::canCross(const TilePosition& from, const TilePosition& to) const
+{
+    if (!(tileMap.getTileExtent().containsPosition(to))) {
+        return false;
+    }
+
+    // Check the volume that an agent sweeps through while moving between
+    // the two tile centers.
+    BoundingBox fromBounds{getAgentBounds(from)};
+    BoundingBox toBounds{getAgentBounds(to)};
+    BoundingBox sweptBounds{std::min(fromBounds.minX, toBounds.minX),
+                            std::max(fromBounds.maxX, toBounds.maxX),
+                            std::min(fromBounds.minY, toBounds.minY),
+                            std::max(fromBounds.maxY, toBounds.maxY),
+                            fromBounds.minZ,
+                            fromBounds.maxZ};
+
+    return !(MovementHelpers::intersectsTileCollision(sweptBounds, tileMap));
+}
+
+void NavGraph::searchChunk(const NavChunk& navChunk, int startTile,
+                           int goalTile, ChunkSearch& outSearch)
+{
+    outSearch.costs.fill(INFINITE_COST);
+    outSearch.costs[startTile] = 0;
+    outSearch.parents[startTile] = static_cast<Uint16>(startTile);
+
+    using QueueEntry = std::pair<float, int>;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+                        std::greater<QueueEntry>>
+        openQueue{};
+    openQueue.emplace(0.f, startTile);
+    while (!(openQueue.empty())) {
+        auto [cost, tile]{openQueue.top()};
+        openQueue.pop();
+        if (cost > outSearch.costs[tile]) {
+            // Stale entry.
+            continue;
+        }
+        if (tile == goalTile) {
+            return;
+        }
+
+        auto visit = [&](int neighbor, float stepCost) {
+            float newCost{cost + stepCost};
+            if (newCost < outSearch.costs[neighbor]) {
+                outSearch.costs[neighbor] = newCost;
+                outSearch.parents[neighbor] = static_cast<Uint16>(tile);
+                openQueue.emplace(newCost, neighbor);
+            }
+        };
+
+        // Visit the cardinal neighbors (ignoring moves out of the chunk).
+        int x{tile % CHUNK_WIDTH};
+        int y{tile / CHUNK_WIDTH};
+        Uint8 moves{navChunk.moves[tile]};
+        bool canPosX{(moves & PosX) && ((x + 1) < CHUNK_WIDTH)};
+        bool canNegX{(moves & NegX) && (x > 0)};
+        bool canPosY{(moves & PosY) && ((y + 1) < CHUNK_WIDTH)};
+        bool canNegY{(moves & NegY) && (y > 0)};
+        if (canPosX) {
+            visit((tile + 1), 1);
+        }
+        if (canNegX) {
+            visit((tile - 1), 1);
+        }
+        if (canPosY) {
+            visit((tile + CHUNK_WIDTH), 1);
+        }
+        if (canNegY) {
+            visit((tile - CHUNK_WIDTH), 1);
+        }
+
+        // Visit the diagonal neighbors. Both L-shaped routes must be open,
+        // so we never cut a corner.
+        auto canMoveDiagonally = [&](bool canX, bool canY, int xStep,
+                                     Direction xDirection, int yStep,
+                                     Direction yDirection) {
+            return canX && canY
+                   && (navChunk.moves[tile + xStep] & yDirection)
+                   && (navChunk.moves[tile + yStep] & xDirection);
+        };
+        if (canMoveDiagonally(canPosX, canPosY, 1, PosX, CHUNK_WIDTH, PosY)) {
+            visit((tile + 1 + CHUNK_WIDTH), DIAGONAL_COST);
+        }
+        if (canMoveDiagonally(canNegX, canPosY, -1, NegX, CHUNK_WIDTH, PosY)) {
+            visit((tile - 1 + CHUNK_WIDTH), DIAGONAL_COST);
+        }
+        if (canMoveDiagonally(canPosX, canNegY, 1, PosX, -CHUNK_WIDTH, NegY)) {
+            visit((tile + 1 - CHUNK_WIDTH), DIAGONAL_COST);
+        }
+        if (canMoveDiagonally(canNegX, canNegY, -1, NegX, -CHUNK_WIDTH,
+                              NegY)) {
+            visit((tile - 1 - CHUNK_WIDTH), DIAGONAL_COST);
+        }
+    }
+}
+
+bool NavGraph::appendChunkPath(const NavChunk& navChunk,
+                               const TilePosition& chunkOrigin,
+                               int startTile, int goalTile,
+                               std::vector<TilePosition>& outPath)
+{
+    ChunkSearch search{};
+    searchChunk(navChunk, startTile, goalTile, search);
+    if (search.costs[goalTile] == INFINITE_COST) {
+        return false;
+    }
+
+    // Walk back from the goal, then put the tiles in order.
+    std::size_t legStart{outPath.size()};
+    for (int tile{goalTile}; tile != startTile; tile = search.parents[tile]) {
+        outPath.emplace_back(chunkOrigin.x + (tile % CHUNK_WIDTH),
+                             chunkOrigin.y + (tile / CHUNK_WIDTH),
+                             chunkOrigin.z);
+    }
+    std::reverse((outPath.begin() + legStart), outPath.end());
+
+    return true;
+}
+
+} // End namespace Server
+} // End namespace AM
@@ -0,0 +1,196 @@
+#include "PathfindingSystem.h"
+#include "World.h"
+#include "PathRequest.h"
+#include "PathResult.h"
+#include "Position.h"
+#include "Config.h"
+#include "ThreadPool.h"
+#include "HashTools.h"
+#include "tracy/Tracy.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_set>
+
+namespace AM
+{
+namespace Server
+{
+PathfindingSystem::PathfindingSystem(World& inWorld)
+: world{inWorld}
+, navGraph{inWorld.tileMap}
+, pathCache{}
+, jobs{}
+, searchJobIndices{}
+{
+    world.tileMap.setTrackCollisionChanges(true);
+}
+
+void PathfindingSystem::processPathRequests()
+{
+    ZoneScoped;
+
+    processCollisionChanges();
+
+    // Take this tick's requests.
+    jobs.clear();
+    for (auto [entity, pathRequest, position] :
+         world.registry.view<PathRequest, Position>().each()) {
+        if (jobs.size() >= Config::PATHFINDING_REQUESTS_PER_TICK) {
+            break;
+        }
+
+        PathJob& job{jobs.emplace_back()};
+        job.entity = entity;
+        job.key = {position.asTilePosition(), pathRequest.goal};
+    }
+    for (const PathJob& job : jobs) {
+        world.registry.remove<PathRequest>(job.entity);
+    }
+
+    // Answer what we can from the cache, and prepare the rest.
+    searchJobIndices.clear();
+    for (std::size_t i{0}; i < jobs.size(); ++i) {
+        PathJob& job{jobs[i]};
+        const PathKey& key{job.key};
+        if ((key.start.z != key.goal.z)
+            || (std::abs(key.goal.x - key.start.x)
+                > Config::PATHFINDING_MAX_DISTANCE)
+            || (std::abs(key.goal.y - key.start.y)
+                > Config::PATHFINDING_MAX_DISTANCE)) {
+            continue;
+        }
+
+        auto cacheIt{pathCache.find(key)};
+        if (cacheIt != pathCache.end()) {
+            job.tiles = cacheIt->second.tiles;
+            continue;
+        }
+
+        // Note: The search only reads nav data, so we need to build it here
+        //       on the sim thread.
+        job.searchExtent = getSearchExtent(key);
+        navGraph.ensureBuilt(job.searchExtent);
+        searchJobIndices.push_back(i);
+    }
+
+    // Search for the remaining paths.
+    auto search = [this](std::size_t index) {
+        PathJob& job{jobs[searchJobIndices[index]]};
+        job.wasFound = navGraph.findPath(job.key.start, job.key.goal,
+                                         job.searchExtent, job.path);
+    };
+    if (searchJobIndices.size() > 1) {
+        world.threadPool.parallelFor(searchJobIndices.size(), search);
+    }
+    else if (searchJobIndices.size() == 1) {
+        search(0);
+    }
+
+    // Cache any new paths and give each requester its result.
+    for (PathJob& job : jobs) {
+        if (job.wasFound) {
+            job.tiles = std::make_shared<const std::vector<TilePosition>>(
+                std::move(job.path));
+            cachePath(job.key, job.tiles);
+        }
+
+        PathResult::Status status{job.tiles ? PathResult::Status::Found
+                                            : PathResult::Status::NotFound};
+        world.registry.emplace_or_replace<PathResult>(
+            job.entity, job.key.start, job.key.goal, status, job.tiles);
+    }
+}
+
+std::size_t
+    PathfindingSystem::PathKeyHash::operator()(const PathKey& pathKey) const
+{
+    std::size_t seed{0};
+    hash_combine(seed, pathKey.start.x);
+    hash_combine(seed, pathKey.start.y);
+    hash_combine(seed, pathKey.start.z);
+    hash_combine(seed, pathKey.goal.x);
+    hash_combine(seed, pathKey.goal.y);
+    hash_combine(seed, pathKey.goal.z);
+    return seed;
+}
+
+void PathfindingSystem::processCollisionChanges()
+{
+    const std::vector<ChunkPosition>& changedChunks{
+        world.tileMap.getCollisionChangeHistory()};
+    if (changedChunks.empty()) {
+        return;
+    }
+
+    // Throw out the nav data around each changed chunk.
+    std::unordered_set<ChunkPosition> invalidatedChunks{};
+    for (const ChunkPosition& changedChunk : changedChunks) {
+        navGraph.invalidate(changedChunk);
+        for (int z{changedChunk.z - 1}; z <= (changedChunk.z + 1); ++z) {
+            for (int y{changedChunk.y - 1}; y <= (changedChunk.y + 1); ++y) {
+                for (int x{changedChunk.x - 1}; x <= (changedChunk.x + 1);
+                     ++x) {
+                    invalidatedChunks.emplace(x, y, z);
+                }
+            }
+        }
+    }
+
+    // Throw out any cached paths that pass through the invalidated chunks.
+    std::erase_if(pathCache, [&](const auto& pathPair) {
+        const std::vector<ChunkPosition>& pathChunks{pathPair.second.chunks};
+        return std::any_of(pathChunks.begin(), pathChunks.end(),
+                           [&](const ChunkPosition& chunkPosition) {
+                               return invalidatedChunks.contains(
+                                   chunkPosition);
+                           });
+    });
+
+    world.tileMap.clearCollisionChangeHistory();
+}
+
+ChunkExtent PathfindingSystem::getSearchExtent(const PathKey& key) const
+{
+    static constexpr int MARGIN{Config::PATHFINDING_SEARCH_MARGIN};
+    ChunkPosition startChunk{key.start};
+    ChunkPosition goalChunk{key.goal};
+    int minX{std::min(startChunk.x, goalChunk.x) - MARGIN};
+    int minY{std::min(startChunk.y, goalChunk.y) - MARGIN};
+    int maxX{std::max(startChunk.x, goalChunk.x) + MARGIN};
+    int maxY{std::max(startChunk.y, goalChunk.y) + MARGIN};
+
+    ChunkExtent searchExtent{minX,
+                             minY,
+                             startChunk.z,
+                             (maxX - minX + 1),
+                             (maxY - minY + 1),
+                             1};
+    searchExtent.intersectWith(world.tileMap.getChunkExtent());
+    return searchExtent;
+}
+
+void PathfindingSystem::cachePath(
+    const PathKey& key,
+    const std::shared_ptr<const std::vector<TilePosition>>& tiles)
+{
+    // If the cache is full, start it over.
+    if (pathCache.size() >= Config::PATHFINDING_CACHE_SIZE) {
+        pathCache.clear();
+    }
+
+    CachedPath& cachedPath{pathCache[key]};
+    cachedPath.tiles = tiles;
+
+    // Track the chunks that the path passes through.
+    cachedPath.chunks.clear();
+    cachedPath.chunks.emplace_back(key.start);
+    for (const TilePosition& tilePosition : *tiles) {
+        ChunkPosition chunkPosition{tilePosition};
+        if (chunkPosition != cachedPath.chunks.back()) {
+            cachedPath.chunks.push_back(chunkPosition);
+        }
+    }
+}
+
+} // End namespace Server
+} // End namespace AM
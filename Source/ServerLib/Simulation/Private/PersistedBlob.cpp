@@ -0,0 +1,68 @@
+#include "PersistedBlob.h"
+#include "ByteTools.h"
+#include "Config.h"
+#include "Log.h"
+#include <algorithm>
+
+namespace AM
+{
+namespace Server
+{
+void PersistedBlob::encode(const Uint8* data, std::size_t dataSize,
+                           BinaryBuffer& outputBuffer)
+{
+    if (Config::COMPRESS_PERSISTED_BLOBS) {
+        // Compress the data after room for the header.
+        outputBuffer.resize(HEADER_SIZE + ByteTools::compressBound(dataSize));
+        std::size_t compressedSize{ByteTools::compress(
+            data, dataSize, (outputBuffer.data() + HEADER_SIZE),
+            (outputBuffer.size() - HEADER_SIZE))};
+
+        // If compression helped, fill in the header and return.
+        if ((HEADER_SIZE + compressedSize) < dataSize) {
+            std::fill_n(outputBuffer.begin(), MAGIC_SIZE, MAGIC_BYTE);
+            outputBuffer[MAGIC_SIZE] = static_cast<Uint8>(Format::LZ4);
+            ByteTools::write32(static_cast<Uint32>(dataSize),
+                               (outputBuffer.data() + MAGIC_SIZE + 1));
+            outputBuffer.resize(HEADER_SIZE + compressedSize);
+            return;
+        }
+    }
+
+    // Store the data as-is.
+    outputBuffer.assign(data, (data + dataSize));
+}
+
+std::span<const Uint8> PersistedBlob::decode(const Uint8* blob,
+                                             std::size_t blobSize,
+                                             BinaryBuffer& decodeBuffer)
+{
+    // If there's no header, the blob is plain serialized data.
+    if ((blobSize < HEADER_SIZE)
+        || !(std::all_of(blob, (blob + MAGIC_SIZE),
+                         [](Uint8 byte) { return byte == MAGIC_BYTE; }))) {
+        return {blob, blobSize};
+    }
+
+    Format format{static_cast<Format>(blob[MAGIC_SIZE])};
+    if (format != Format::LZ4) {
+        LOG_FATAL("Unknown persisted blob format: %u",
+                  static_cast<unsigned int>(format));
+    }
+
+    // Decompress the data.
+    std::size_t dataSize{ByteTools::read32(blob + MAGIC_SIZE + 1)};
+    decodeBuffer.resize(dataSize);
+    std::size_t decompressedSize{ByteTools::decompress(
+        (blob + HEADER_SIZE), (blobSize - HEADER_SIZE), decodeBuffer.data(),
+        decodeBuffer.size())};
+    if (decompressedSize != dataSize) {
+        LOG_FATAL("Persisted blob size mismatch. Expected: %zu, got: %zu",
+                  dataSize, decompressedSize);
+    }
+
+    return decodeBuffer;
+}
+
+} // End namespace Server
+} // End namespace AM
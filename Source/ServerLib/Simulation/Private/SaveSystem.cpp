@@ -3,10 +3,15 @@
 #include "Config.h"
 #include "PersistedEntityData.h"
 #include "Database.h"
+#include "PersistedBlob.h"
+#include "Paths.h"
 #include "ClientSimData.h"
 #include "Serialize.h"
 #include "Log.h"
+#include "tracy/Tracy.hpp"
 #include <type_traits>
+#include <array>
+#include <chrono>
 
 namespace AM
 {
@@ -37,41 +42,142 @@ void addComponentsToVector(entt::registry& registry, entt::entity entity,
     });
 }
 
+/** A group and update observer for each persisted component type. Used to 
+    track which entities need to be saved. */
+std::array<entt::observer, boost::mp11::mp_size<PersistedComponentTypes>::value>
+    persistedObservers{};
+
 SaveSystem::SaveSystem(World& inWorld)
 : world{inWorld}
 , updatedItems{}
+, entitiesWithRemovedComponents{}
+, destroyedEntities{}
+, dirtyEntities{}
+, savesSinceFullSave{0}
 , saveTimer{}
+, simSnapshot{}
+, threadSnapshot{}
 , workBuffer{}
+, blobBuffer{}
+, warmSnapshot{}
+, warmSnapshotRequested{false}
+, saveThreadObj{}
+, exitRequested{false}
+, saveMutex{}
+, saveCondVar{}
+, saveInProgress{false}
 {
     // When an item is created or updated, add it to updatedItems.
     world.itemData.itemCreated.connect<&SaveSystem::itemUpdated>(this);
     world.itemData.itemUpdated.connect<&SaveSystem::itemUpdated>(this);
+
+    // Track changes to each persisted component type.
+    // Note: We're constructed after World loads the saved entities, so they 
+    //       don't start out dirty.
+    boost::mp11::mp_for_each<PersistedComponentTypes>([&](auto I) {
+        using ComponentType = decltype(I);
+        constexpr std::size_t typeIndex{
+            boost::mp11::mp_find<PersistedComponentTypes,
+                                 ComponentType>::value};
+
+        persistedObservers[typeIndex].connect(
+            world.registry, entt::collector.group<ComponentType>()
+                                .template update<ComponentType>());
+        world.registry.on_destroy<ComponentType>()
+            .template connect<&SaveSystem::persistedComponentRemoved>(this);
+    });
+
+    // When an entity is destroyed, track it so we can delete it from the 
+    // database.
+    world.registry.on_destroy<entt::entity>()
+        .connect<&SaveSystem::entityDestroyed>(this);
+
+    // Start the save thread.
+    saveThreadObj = std::thread(&SaveSystem::saveThread, this);
+}
+
+SaveSystem::~SaveSystem()
+{
+    // Stop listening to the registry, since it outlives us.
+    boost::mp11::mp_for_each<PersistedComponentTypes>([&](auto I) {
+        using ComponentType = decltype(I);
+        world.registry.on_destroy<ComponentType>().disconnect(this);
+    });
+    world.registry.on_destroy<entt::entity>().disconnect(this);
+    for (entt::observer& observer : persistedObservers) {
+        observer.disconnect();
+    }
+
+    // Let any in-flight save finish, then end the save thread.
+    {
+        std::unique_lock lock{saveMutex};
+        exitRequested = true;
+    }
+    saveCondVar.notify_one();
+    saveThreadObj.join();
 }
 
 void SaveSystem::saveIfNecessary()
 {
-    // If enough time has passed and a backup isn't still underway, save 
-    // everything to the database.
-    if ((saveTimer.getTime() >= Config::SAVE_PERIOD_S)
-        && !(world.database->backupIsInProgress())) {
-        LOG_INFO("Saving entities, items, and map...");
+    // If it isn't time to save yet, return early.
+    if ((saveTimer.getTime() < Config::SAVE_PERIOD_S)
+        && !warmSnapshotRequested) {
+        return;
+    }
 
-        // Save all of our data to the in-memory database.
-        world.database->startTransaction();
+    // If the last save is still being written or backed up, wait for it to 
+    // finish. We'll try again next tick.
+    if (saveInProgress || world.database->backupIsInProgress()) {
+        return;
+    }
 
-        saveNonClientEntities();
-        saveItems();
-        saveStoredValues();
-        // TODO: Track changed tiles and save to the database.
-        world.tileMap.save("TileMap.bin");
+    ZoneScoped;
+    LOG_INFO("Saving entities, items, and map...");
 
-        world.database->commitTransaction();
+    // Capture the data that needs to be saved.
+    // Note: Every so often, we capture all of the entities in case a change 
+    //       was made without notifying the registry.
+    // Note: Warm snapshots need everything, so they're always full saves.
+    simSnapshot.clear();
+    savesSinceFullSave++;
+    if (warmSnapshotRequested.exchange(false)) {
+        captureAllNonClientEntities(simSnapshot);
+        captureAllItems(simSnapshot);
+        simSnapshot.isWarmSnapshot = true;
+        savesSinceFullSave = 0;
+    }
+    else if ((Config::FULL_ENTITY_SAVE_INTERVAL != 0)
+             && (savesSinceFullSave >= Config::FULL_ENTITY_SAVE_INTERVAL)) {
+        captureAllNonClientEntities(simSnapshot);
+        captureItems(simSnapshot);
+        savesSinceFullSave = 0;
+    }
+    else {
+        captureDirtyNonClientEntities(simSnapshot);
+        captureItems(simSnapshot);
+    }
+    simSnapshot.destroyedEntities.swap(destroyedEntities);
+    destroyedEntities.clear();
+    simSnapshot.entityStoredValueIDMap = world.entityStoredValueIDMap;
+    simSnapshot.globalStoredValueMap = world.globalStoredValueMap;
 
-        // Backup the in-memory database to the file database.
-        world.database->backupToFile();
+    // TODO: Track changed tiles and save to the database.
+    world.tileMap.save("TileMap.bin");
 
-        saveTimer.reset();
+    // Hand the snapshot to the save thread.
+    {
+        std::unique_lock lock{saveMutex};
+        std::swap(simSnapshot, threadSnapshot);
+        saveInProgress = true;
     }
+    saveCondVar.notify_one();
+
+    saveTimer.reset();
+}
+
+void SaveSystem::requestWarmSnapshot()
+{
+    warmSnapshotRequested = true;
 }
 
 void SaveSystem::itemUpdated(ItemID itemID)
@@ -79,31 +185,73 @@ void SaveSystem::itemUpdated(ItemID itemID)
     updatedItems.emplace_back(itemID);
 }
 
-void SaveSystem::saveNonClientEntities()
+void SaveSystem::persistedComponentRemoved(entt::registry&,
+                                           entt::entity entity)
+{
+    entitiesWithRemovedComponents.emplace_back(entity);
+}
+
+void SaveSystem::entityDestroyed(entt::registry&, entt::entity entity)
+{
+    // Note: Client entities aren't in this database, but deleting a 
+    //       non-existent entry is harmless.
+    destroyedEntities.emplace_back(entity);
+}
+
+void SaveSystem::captureDirtyNonClientEntities(SaveSnapshot& snapshot)
+{
+    // Gather every entity that changed since the last save.
+    dirtyEntities.clear();
+    for (entt::observer& observer : persistedObservers) {
+        dirtyEntities.insert(dirtyEntities.end(), observer.begin(),
+                             observer.end());
+        observer.clear();
+    }
+    dirtyEntities.insert(dirtyEntities.end(),
+                         entitiesWithRemovedComponents.begin(),
+                         entitiesWithRemovedComponents.end());
+    entitiesWithRemovedComponents.clear();
+
+    // Remove duplicates from the vector.
+    std::sort(dirtyEntities.begin(), dirtyEntities.end());
+    dirtyEntities.erase(
+        std::unique(dirtyEntities.begin(), dirtyEntities.end()),
+        dirtyEntities.end());
+
+    // Capture each entity that still exists.
+    // Note: Destroyed entities are handled through destroyedEntities.
+    for (entt::entity entity : dirtyEntities) {
+        if (world.registry.valid(entity)
+            && !(world.registry.all_of<ClientSimData>(entity))) {
+            captureEntity(entity, snapshot);
+        }
+    }
+}
+
+void SaveSystem::captureAllNonClientEntities(SaveSnapshot& snapshot)
 {
-    // Note: If doing a full save ever starts taking too long, we can add 
-    //       an observer that tracks changes to non-client entities and only 
-    //       save those.
+    // We're capturing everything, so the tracked changes aren't needed.
+    for (entt::observer& observer : persistedObservers) {
+        observer.clear();
+    }
+    entitiesWithRemovedComponents.clear();
 
-    // Queue all of our entity save queries.
     auto view{
         world.registry.view<entt::entity>(entt::exclude_t<ClientSimData>{})};
     for (entt::entity entity : view) {
-        PersistedEntityData persistedEntityData{entity};
-        addComponentsToVector(world.registry, entity,
-                              persistedEntityData.components);
-
-        workBuffer.clear();
-        workBuffer.resize(Serialize::measureSize(persistedEntityData));
-        Serialize::toBuffer(workBuffer.data(), workBuffer.size(),
-                            persistedEntityData);
-
-        world.database->saveEntityData(entity, workBuffer.data(),
-                                       workBuffer.size());
+        captureEntity(entity, snapshot);
     }
 }
 
-void SaveSystem::saveItems()
+void SaveSystem::captureEntity(entt::entity entity, SaveSnapshot& snapshot)
+{
+    PersistedEntityData& persistedEntityData{
+        snapshot.entities.emplace_back(entity)};
+    addComponentsToVector(world.registry, entity,
+                          persistedEntityData.components);
+}
+
+void SaveSystem::captureItems(SaveSnapshot& snapshot)
 {
     // Remove duplicates from the vector.
     std::sort(updatedItems.begin(), updatedItems.end());
@@ -111,42 +259,142 @@ void SaveSystem::saveItems()
         std::unique(updatedItems.begin(), updatedItems.end()),
         updatedItems.end());
 
-    // Queue all of our item save queries.
+    // Copy each updated item.
     for (ItemID itemID : updatedItems) {
-        const Item* updatedItem{world.itemData.getItem(itemID)};
+        if (const Item* updatedItem{world.itemData.getItem(itemID)}) {
+            snapshot.items.push_back(*updatedItem);
+        }
+    }
 
-        workBuffer.clear();
-        workBuffer.resize(Serialize::measureSize(*updatedItem));
-        Serialize::toBuffer(workBuffer.data(), workBuffer.size(), *updatedItem);
+    updatedItems.clear();
+}
+
+void SaveSystem::captureAllItems(SaveSnapshot& snapshot)
+{
+    // We're capturing everything, so the tracked updates aren't needed.
+    updatedItems.clear();
 
-        world.database->saveItemData(updatedItem->numericID, workBuffer.data(),
-                                     workBuffer.size());
+    for (const auto& [itemID, item] : world.itemData.getAllItems()) {
+        snapshot.items.push_back(item);
     }
+}
 
-    updatedItems.clear();
+void SaveSystem::saveThread()
+{
+    while (true) {
+        // Wait until we're handed a snapshot, or we're told to exit.
+        {
+            std::unique_lock lock{saveMutex};
+            saveCondVar.wait(lock, [this] {
+                return (saveInProgress || exitRequested);
+            });
+            if (!saveInProgress && exitRequested) {
+                return;
+            }
+        }
+
+        writeSnapshot(threadSnapshot);
+
+        saveInProgress = false;
+    }
 }
 
-void SaveSystem::saveStoredValues()
+void SaveSystem::writeSnapshot(SaveSnapshot& snapshot)
 {
-    // Serialize the entity stored value ID map.
+    ZoneScoped;
+
+    // If this save won't write a warm snapshot, any existing snapshot is 
+    // about to fall out of date.
+    std::string warmSnapshotPath{Paths::BASE_PATH + WarmSnapshot::FILE_NAME};
+    bool isWarmSnapshot{snapshot.isWarmSnapshot};
+    if (!isWarmSnapshot) {
+        WarmSnapshot::remove(warmSnapshotPath);
+    }
+
+    // Save all of our data to the in-memory database.
+    Database& database{*(world.database)};
+    database.startTransaction();
+
+    // Queue the entity delete queries, then the save queries.
+    // Note: Deletes must go first. If an entity ID was destroyed and then 
+    //       re-used during this save period, it's in both lists, and its 
+    //       new data must win.
+    for (entt::entity entity : snapshot.destroyedEntities) {
+        database.deleteEntityData(entity);
+    }
+    for (PersistedEntityData& persistedEntityData : snapshot.entities) {
+        workBuffer.clear();
+        workBuffer.resize(Serialize::measureSize(persistedEntityData));
+        Serialize::toBuffer(workBuffer.data(), workBuffer.size(),
+                            persistedEntityData);
+        PersistedBlob::encode(workBuffer.data(), workBuffer.size(),
+                              blobBuffer);
+
+        database.saveEntityData(persistedEntityData.entity, blobBuffer.data(),
+                                blobBuffer.size());
+        if (isWarmSnapshot) {
+            warmSnapshot.addEntity(blobBuffer.data(), blobBuffer.size());
+        }
+    }
+
+    // Queue the item save queries.
+    for (Item& item : snapshot.items) {
+        workBuffer.clear();
+        workBuffer.resize(Serialize::measureSize(item));
+        Serialize::toBuffer(workBuffer.data(), workBuffer.size(), item);
+        PersistedBlob::encode(workBuffer.data(), workBuffer.size(),
+                              blobBuffer);
+
+        database.saveItemData(item.numericID, blobBuffer.data(),
+                              blobBuffer.size());
+        if (isWarmSnapshot) {
+            warmSnapshot.addItem(blobBuffer.data(), blobBuffer.size());
+        }
+    }
+
+    // Serialize the stored value maps and queue their save queries.
     workBuffer.clear();
-    workBuffer.resize(Serialize::measureSize(world.entityStoredValueIDMap));
+    workBuffer.resize(Serialize::measureSize(snapshot.entityStoredValueIDMap));
     Serialize::toBuffer(workBuffer.data(), workBuffer.size(),
-                        world.entityStoredValueIDMap);
-
-    // Queue the save query.
-    world.database->saveEntityStoredValueIDMap(workBuffer.data(),
+                        snapshot.entityStoredValueIDMap);
+    database.saveEntityStoredValueIDMap(workBuffer.data(), workBuffer.size());
+    if (isWarmSnapshot) {
+        warmSnapshot.setEntityStoredValueIDMap(workBuffer.data(),
                                                workBuffer.size());
+    }
 
-    // Serialize the global stored value map.
     workBuffer.clear();
-    workBuffer.resize(Serialize::measureSize(world.globalStoredValueMap));
+    workBuffer.resize(Serialize::measureSize(snapshot.globalStoredValueMap));
     Serialize::toBuffer(workBuffer.data(), workBuffer.size(),
-                        world.globalStoredValueMap);
-
-    // Queue the save query.
-    world.database->saveGlobalStoredValueMap(workBuffer.data(),
+                        snapshot.globalStoredValueMap);
+    database.saveGlobalStoredValueMap(workBuffer.data(), workBuffer.size());
+    if (isWarmSnapshot) {
+        warmSnapshot.setGlobalStoredValueMap(workBuffer.data(),
                                              workBuffer.size());
+    }
+
+    database.commitTransaction();
+
+    LOG_INFO("Saved %zu changed entities and %zu items.",
+             snapshot.entities.size(), snapshot.items.size());
+
+    // Backup the in-memory database to the file database.
+    database.backupToFile();
+
+    // If we're writing a warm snapshot, wait until the database file is up 
+    // to date, so the two always match.
+    if (isWarmSnapshot) {
+        while (database.backupIsInProgress()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        if (warmSnapshot.write(warmSnapshotPath)) {
+            LOG_INFO("Wrote warm snapshot with %zu entities and %zu items.",
+                     warmSnapshot.getEntityCount(),
+                     warmSnapshot.getItemCount());
+        }
+        warmSnapshot.clear();
+    }
 }
 
 } // namespace Server
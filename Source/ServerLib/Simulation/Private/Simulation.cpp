@@ -11,6 +11,7 @@
 #include "Interaction.h"
 #include "Inventory.h"
 #include "SystemMessage.h"
+#include "Config.h"
 #include "Log.h"
 #include "Timer.h"
 #include "tracy/Tracy.hpp"
@@ -34,6 +35,7 @@ Simulation::Simulation(Network& inNetwork, GraphicData& inGraphicData)
 , engineLuaBindings{*entityInitLua, *entityItemHandlerLua,       *itemInitLua,
                     *dialogueLua,   *dialogueChoiceConditionLua, world,
                     network}
+, scriptStatsTimer{}
 , extension{nullptr}
 , entityInteractionRequestQueue{inNetwork.getEventDispatcher()}
 , itemInteractionRequestQueue{inNetwork.getEventDispatcher()}
@@ -46,6 +48,7 @@ Simulation::Simulation(Network& inNetwork, GraphicData& inGraphicData)
 , inputSystem{*this, world, network}
 , movementSystem{world}
 , aiSystem{world}
+, pathfindingSystem{world}
 , itemSystem{*this, network, *entityItemHandlerLua}
 , inventorySystem{world, network}
 , dialogueSystem{*this, network, *dialogueLua, *dialogueChoiceConditionLua}
@@ -201,6 +204,20 @@ Uint32 Simulation::getCurrentTick()
     return currentTick;
 }
 
+void Simulation::requestWarmSnapshot()
+{
+    saveSystem.requestWarmSnapshot();
+}
+
+void Simulation::logLuaScriptStats()
+{
+    entityInitLua->scriptCache.logHotScripts();
+    entityItemHandlerLua->scriptCache.logHotScripts();
+    itemInitLua->scriptCache.logHotScripts();
+    dialogueLua->scriptCache.logHotScripts();
+    dialogueChoiceConditionLua->scriptCache.logHotScripts();
+}
+
 void Simulation::tick()
 {
     ZoneScoped;
@@ -220,6 +237,9 @@ void Simulation::tick()
     // Process requests to change components.
     componentChangeSystem.processChangeRequests();
 
+    // Move any chunks that were decoded in the background into the tile map.
+    world.tileMap.loadPrefetchedChunks();
+
     // Receive and process tile update requests.
     tileUpdateSystem.updateTiles();
 
@@ -243,6 +263,9 @@ void Simulation::tick()
     // Run all of our AI.
     aiSystem.processAITick();
 
+    // Find paths for any entities that requested them.
+    pathfindingSystem.processPathRequests();
+
     // Process any waiting item interaction messages.
     itemSystem.processItemInteractions();
 
@@ -288,6 +311,14 @@ void Simulation::tick()
     // If any category of data is due for saving, save it.
     saveSystem.saveIfNecessary();
 
+    // If it's time, log the most expensive Lua scripts.
+    if ((Config::LUA_SCRIPT_STATS_LOG_PERIOD_S > 0)
+        && (scriptStatsTimer.getTime()
+            >= Config::LUA_SCRIPT_STATS_LOG_PERIOD_S)) {
+        logLuaScriptStats();
+        scriptStatsTimer.reset();
+    }
+
     // Call the project's post-everything logic.
     if (extension != nullptr) {
         extension->afterAll();
@@ -0,0 +1,98 @@
+#include "ChunkSubscriptions.h"
+#include <algorithm>
+
+namespace AM
+{
+namespace Server
+{
+/** Returned when a chunk or client has no subscriptions. */
+static const std::vector<entt::entity> EMPTY_SUBSCRIBERS{};
+static const std::vector<ChunkPosition> EMPTY_CHUNKS{};
+
+void ChunkSubscriptions::subscribe(entt::entity clientEntity,
+                                   const ChunkPosition& chunkPosition)
+{
+    std::vector<ChunkPosition>& chunks{clientChunks[clientEntity]};
+    if (std::find(chunks.begin(), chunks.end(), chunkPosition)
+        != chunks.end()) {
+        // Already subscribed.
+        return;
+    }
+
+    chunks.push_back(chunkPosition);
+    chunkSubscribers[chunkPosition].push_back(clientEntity);
+}
+
+void ChunkSubscriptions::unsubscribeOutsideOf(entt::entity clientEntity,
+                                              const ChunkExtent& inRangeExtent)
+{
+    auto clientIt{clientChunks.find(clientEntity)};
+    if (clientIt == clientChunks.end()) {
+        return;
+    }
+
+    std::erase_if(clientIt->second, [&](const ChunkPosition& chunkPosition) {
+        if (!(inRangeExtent.containsPosition(chunkPosition))) {
+            removeSubscriber(clientEntity, chunkPosition);
+            return true;
+        }
+        return false;
+    });
+
+    if (clientIt->second.empty()) {
+        clientChunks.erase(clientIt);
+    }
+}
+
+void ChunkSubscriptions::unsubscribeAll(entt::entity clientEntity)
+{
+    auto clientIt{clientChunks.find(clientEntity)};
+    if (clientIt == clientChunks.end()) {
+        return;
+    }
+
+    for (const ChunkPosition& chunkPosition : clientIt->second) {
+        removeSubscriber(clientEntity, chunkPosition);
+    }
+    clientChunks.erase(clientIt);
+}
+
+const std::vector<entt::entity>&
+    ChunkSubscriptions::getSubscribers(const ChunkPosition& chunkPosition) const
+{
+    auto chunkIt{chunkSubscribers.find(chunkPosition)};
+    if (chunkIt == chunkSubscribers.end()) {
+        return EMPTY_SUBSCRIBERS;
+    }
+
+    return chunkIt->second;
+}
+
+const std::vector<ChunkPosition>&
+    ChunkSubscriptions::getSubscribedChunks(entt::entity clientEntity) const
+{
+    auto clientIt{clientChunks.find(clientEntity)};
+    if (clientIt == clientChunks.end()) {
+        return EMPTY_CHUNKS;
+    }
+
+    return clientIt->second;
+}
+
+void ChunkSubscriptions::removeSubscriber(entt::entity clientEntity,
+                                          const ChunkPosition& chunkPosition)
+{
+    auto chunkIt{chunkSubscribers.find(chunkPosition)};
+    if (chunkIt == chunkSubscribers.end()) {
+        return;
+    }
+
+    std::vector<entt::entity>& subscribers{chunkIt->second};
+    std::erase(subscribers, clientEntity);
+    if (subscribers.empty()) {
+        chunkSubscribers.erase(chunkIt);
+    }
+}
+
+} // End namespace Server
+} // End namespace AM
@@ -10,36 +10,95 @@
 #include "Tile.h"
 #include "ChunkSnapshot.h"
 #include "Morton.h"
+#include "ThreadPool.h"
+#include "Config.h"
 #include "SharedConfig.h"
 #include "Timer.h"
 #include "Log.h"
 #include "AMAssert.h"
+#include <filesystem>
+#include <random>
+#include <span>
 
 namespace AM
 {
 namespace Server
 {
-TileMap::TileMap(GraphicData& inGraphicData)
+TileMap::TileMap(GraphicData& inGraphicData, ThreadPool& inThreadPool)
 : TileMapBase{inGraphicData, true}
+, mapFile{}
+, journal{}
+, mapGeneration{0}
+, savedHistorySize{0}
+, saveBuffer{}
+, versionRunID{0}
+, chunkEditCounts{}
+, threadPool{inThreadPool}
+, prefetchedPositions{}
+, prefetchedSnapshots{}
 {
     // Prime a timer.
     Timer timer;
 
-    // Deserialize the file into a snapshot.
-    TileMapSnapshot mapSnapshot;
+    // Pick a random ID for this run's chunk versions.
+    std::random_device randomDevice{};
+    std::uniform_int_distribution<Uint32> distribution{1, SDL_MAX_UINT32};
+    versionRunID = distribution(randomDevice);
+
+    // Map the file and read its index. Chunks will be loaded as they're 
+    // accessed.
     std::string mapPath{Paths::BASE_PATH + "TileMap.bin"};
-    bool loadSuccessful{Deserialize::fromFile(mapPath, mapSnapshot)};
-    if (!loadSuccessful) {
-        LOG_FATAL("Failed to deserialize map at path: %s", mapPath.c_str());
+    auto openResult{mapFile.open(mapPath)};
+    if (openResult) {
+        const TileMapFile::Header& header{mapFile.getHeader()};
+        mapGeneration = header.generation;
+        chunkExtent = ChunkExtent::fromMapLengths(
+            header.xLengthChunks, header.yLengthChunks, header.zLengthChunks);
+        tileExtent = TileExtent{chunkExtent};
+
+        if (Config::PREFETCH_TILE_MAP) {
+            mapFile.startPrefetch();
+        }
+    }
+    else if (openResult.error() == TileMapFile::OpenError::LegacyFormat) {
+        // Version 1 maps aren't indexed, so we have to load the whole thing.
+        // Note: The map will be converted to the indexed format the next 
+        //       time it's saved.
+        TileMapSnapshot mapSnapshot;
+        bool loadSuccessful{Deserialize::fromFile(mapPath, mapSnapshot)};
+        if (!loadSuccessful) {
+            LOG_FATAL("Failed to deserialize map at path: %s",
+                      mapPath.c_str());
+        }
+
+        load(mapSnapshot);
+    }
+    else {
+        LOG_FATAL("Failed to open map at path: %s", mapPath.c_str());
     }
 
-    // Load the map snapshot.
-    load(mapSnapshot);
+    // Replay any edits that were made after the map was last saved.
+    // Note: Collision is rebuilt once at the end, and the replayed updates 
+    //       don't need to be sent or journaled again.
+    setAutoRebuildCollision(false);
+    std::size_t replayedCount{journal.open(
+        Paths::BASE_PATH + "TileMapJournal.bin", mapGeneration,
+        [this](const TileUpdateVariant& tileUpdate) {
+            replayTileUpdate(tileUpdate);
+        })};
+    setAutoRebuildCollision(true);
+    clearTileUpdateHistory();
+    if (replayedCount > 0) {
+        LOG_INFO("Replayed %zu tile updates from the journal.",
+                 replayedCount);
+    }
 
     // Print the time taken.
     double timeTaken{timer.getTime()};
-    LOG_INFO("Map loaded in %.6fs. Size: (%u, %u, %u)ch.", timeTaken,
-             chunkExtent.xLength, chunkExtent.yLength, chunkExtent.zLength);
+    LOG_INFO("Map loaded in %.6fs. Size: (%u, %u, %u)ch. "
+             "Deferred chunks: %zu",
+             timeTaken, chunkExtent.xLength, chunkExtent.yLength,
+             chunkExtent.zLength, mapFile.getUntakenChunkCount());
 }
 
 TileMap::~TileMap()
@@ -55,34 +114,157 @@ void TileMap::save(const std::string& fileName)
     // Prime a timer.
     Timer timer{};
 
-    /* Save this map's state into a snapshot. */
-    // Save the header data.
-    TileMapSnapshot mapSnapshot{};
-    mapSnapshot.version = MAP_FORMAT_VERSION;
-    mapSnapshot.xLengthChunks = static_cast<Uint16>(chunkExtent.xLength);
-    mapSnapshot.yLengthChunks = static_cast<Uint16>(chunkExtent.yLength);
-    mapSnapshot.zLengthChunks = static_cast<Uint16>(chunkExtent.zLength);
-
-    // Save our tiles into the snapshot as chunks.
-    static constexpr int CHUNK_WIDTH{
-        static_cast<int>(SharedConfig::CHUNK_WIDTH)};
+    // Serialize each of our loaded chunks into the save buffer.
+    std::vector<TileMapFile::ChunkBlob> chunkBlobs{};
+    std::vector<std::size_t> blobOffsets{};
+    chunkBlobs.reserve(chunks.size() + mapFile.getUntakenChunkCount());
+    blobOffsets.reserve(chunks.size());
+    saveBuffer.clear();
     for (auto& [chunkPosition, chunk] : chunks) {
-        ChunkSnapshot& chunkSnapshot{mapSnapshot.chunks[chunkPosition]};
+        ChunkSnapshot chunkSnapshot{};
         saveChunkToSnapshot(chunk, chunkSnapshot);
+
+        std::size_t blobOffset{saveBuffer.size()};
+        std::size_t blobSize{Serialize::measureSize(chunkSnapshot)};
+        saveBuffer.resize(blobOffset + blobSize);
+        Serialize::toBuffer(saveBuffer.data(), saveBuffer.size(),
+                            chunkSnapshot, blobOffset);
+
+        chunkBlobs.emplace_back(chunkPosition, nullptr, blobSize);
+        blobOffsets.emplace_back(blobOffset);
     }
 
-    // Serialize the map snapshot and write it to the file.
-    bool saveSuccessful{
-        Serialize::toFile((Paths::BASE_PATH + fileName), mapSnapshot)};
-    if (saveSuccessful) {
-        // Print the time taken.
-        double timeTaken{timer.getTime()};
-        LOG_INFO("Saved %u chunks in %.6fs.", chunkExtent.getCount(),
-                 timeTaken);
+    // Now that the buffer is done growing, point the blobs at their data.
+    for (std::size_t i{0}; i < blobOffsets.size(); ++i) {
+        chunkBlobs[i].data = (saveBuffer.data() + blobOffsets[i]);
     }
-    else {
+
+    // Chunks that haven't been loaded yet can be copied straight from the 
+    // map file.
+    mapFile.forEachUntakenChunk([&](const TileMapFile::ChunkBlob& blob) {
+        chunkBlobs.emplace_back(blob);
+    });
+
+    // If we're overwriting our mapped file, write to a temp file first so 
+    // we can keep reading from the mapping.
+    std::string filePath{Paths::BASE_PATH + fileName};
+    bool replacingMappedFile{mapFile.isOpen()
+                             && (filePath == mapFile.getFilePath())};
+    std::string writePath{replacingMappedFile ? (filePath + ".tmp")
+                                              : filePath};
+
+    // Write the map file.
+    // Note: Saves over TileMap.bin get a new generation, so that if we crash 
+    //       before the journal is cleared, the journal will be seen as stale.
+    bool savingMainMap{filePath == (Paths::BASE_PATH + "TileMap.bin")};
+    Uint32 generation{savingMainMap ? (mapGeneration + 1) : mapGeneration};
+    TileMapFile::Header header{MAP_FORMAT_VERSION,
+                               static_cast<Uint16>(chunkExtent.xLength),
+                               static_cast<Uint16>(chunkExtent.yLength),
+                               static_cast<Uint16>(chunkExtent.zLength),
+                               generation};
+    if (!(TileMapFile::write(writePath, header, chunkBlobs))) {
         LOG_FATAL("Failed to serialize and save the map.");
     }
+
+    // If we wrote to a temp file, replace our mapped file with it and map 
+    // the new file.
+    if (replacingMappedFile) {
+        // Note: The mapping must be closed before the file can be replaced.
+        mapFile.close();
+
+        std::error_code errorCode{};
+        std::filesystem::rename(writePath, filePath, errorCode);
+        if (errorCode) {
+            LOG_FATAL("Failed to replace map file: %s",
+                      errorCode.message().c_str());
+        }
+
+        if (!(mapFile.open(filePath))) {
+            LOG_FATAL("Failed to re-open map at path: %s", filePath.c_str());
+        }
+
+        // Discard the chunks that we already have loaded, so they don't get 
+        // loaded a second time.
+        for (auto& [chunkPosition, chunk] : chunks) {
+            mapFile.discardChunk(chunkPosition);
+        }
+
+        if (Config::PREFETCH_TILE_MAP) {
+            mapFile.startPrefetch();
+        }
+    }
+
+    // The main map file now holds every update so far, so the journal and 
+    // any un-journaled history are no longer needed.
+    if (savingMainMap) {
+        mapGeneration = generation;
+        journal.clear(mapGeneration);
+        savedHistorySize = getTileUpdateHistory().size();
+    }
+
+    // Print the time taken.
+    double timeTaken{timer.getTime()};
+    LOG_INFO("Saved %zu chunks in %.6fs.", chunkBlobs.size(), timeTaken);
+}
+
+void TileMap::flushTileUpdateHistory()
+{
+    const std::vector<TileUpdateVariant>& history{getTileUpdateHistory()};
+    if (savedHistorySize < history.size()) {
+        journal.append(std::span{history}.subspan(savedHistorySize));
+    }
+
+    clearTileUpdateHistory();
+    savedHistorySize = 0;
+}
+
+void TileMap::loadPrefetchedChunks()
+{
+    // Gather any chunks that the prefetch thread has finished decoding.
+    prefetchedPositions.clear();
+    std::size_t prefetchedCount{0};
+    while (prefetchedCount < Config::PREFETCHED_CHUNKS_PER_TICK) {
+        if (prefetchedSnapshots.size() == prefetchedCount) {
+            prefetchedSnapshots.emplace_back();
+        }
+
+        ChunkPosition chunkPosition{};
+        if (!(mapFile.takePrefetchedChunk(
+                chunkPosition, prefetchedSnapshots[prefetchedCount]))) {
+            break;
+        }
+
+        prefetchedPositions.emplace_back(chunkPosition);
+        prefetchedCount++;
+    }
+    if (prefetchedCount == 0) {
+        return;
+    }
+
+    // Build and add the chunks in parallel.
+    std::vector<const ChunkSnapshot*> snapshotPtrs(prefetchedCount);
+    for (std::size_t i{0}; i < prefetchedCount; ++i) {
+        snapshotPtrs[i] = &(prefetchedSnapshots[i]);
+    }
+    loadChunks(snapshotPtrs, prefetchedPositions, threadPool);
+}
+
+Chunk* TileMap::materializeChunk(const ChunkPosition& chunkPosition)
+{
+    // If the chunk is in the map file and hasn't been loaded yet, load it.
+    // Note: loadChunk() will look the chunk up again, but takeChunk() only 
+    //       returns a given chunk once, so it'll just create a fresh one.
+    ChunkSnapshot chunkSnapshot{};
+    if (!(mapFile.isOpen())
+        || !(mapFile.takeChunk(chunkPosition, chunkSnapshot))) {
+        return nullptr;
+    }
+
+    loadChunk(chunkSnapshot, chunkPosition);
+
+    auto chunkIt{chunks.find(chunkPosition)};
+    return (chunkIt != chunks.end()) ? &(chunkIt->second) : nullptr;
 }
 
 void TileMap::load(TileMapSnapshot& mapSnapshot)
@@ -94,12 +276,75 @@ void TileMap::load(TileMapSnapshot& mapSnapshot)
                                               mapSnapshot.zLengthChunks);
     tileExtent = TileExtent{chunkExtent};
 
-    // Load all of the snapshot's chunks into our map.
-    static constexpr int CHUNK_WIDTH{
-        static_cast<int>(SharedConfig::CHUNK_WIDTH)};
+    // Load all of the snapshot's chunks into our map, building them in 
+    // parallel.
+    std::vector<const ChunkSnapshot*> snapshotPtrs{};
+    std::vector<ChunkPosition> chunkPositions{};
+    snapshotPtrs.reserve(mapSnapshot.chunks.size());
+    chunkPositions.reserve(mapSnapshot.chunks.size());
     for (auto& [chunkPosition, chunkSnapshot] : mapSnapshot.chunks) {
-        loadChunk(chunkSnapshot,
-                  {chunkPosition.x, chunkPosition.y, chunkPosition.z});
+        snapshotPtrs.push_back(&chunkSnapshot);
+        chunkPositions.push_back(chunkPosition);
+    }
+
+    loadChunks(snapshotPtrs, chunkPositions, threadPool);
+}
+
+void TileMap::replayTileUpdate(const TileUpdateVariant& tileUpdate)
+{
+    if (const auto* addLayer{std::get_if<TileAddLayer>(&tileUpdate)}) {
+        if (addLayer->layerType == TileLayer::Type::Terrain) {
+            addTerrain(addLayer->tilePosition, addLayer->graphicSetID,
+                       static_cast<Terrain::Value>(addLayer->graphicValue));
+        }
+        else if (addLayer->layerType == TileLayer::Type::Floor) {
+            addFloor(
+                addLayer->tilePosition, addLayer->tileOffset,
+                addLayer->graphicSetID,
+                static_cast<Rotation::Direction>(addLayer->graphicValue));
+        }
+        else if (addLayer->layerType == TileLayer::Type::Wall) {
+            addWall(addLayer->tilePosition, addLayer->graphicSetID,
+                    static_cast<Wall::Type>(addLayer->graphicValue));
+        }
+        else if (addLayer->layerType == TileLayer::Type::Object) {
+            addObject(
+                addLayer->tilePosition, addLayer->tileOffset,
+                addLayer->graphicSetID,
+                static_cast<Rotation::Direction>(addLayer->graphicValue));
+        }
+    }
+    else if (const auto* remLayer{
+                 std::get_if<TileRemoveLayer>(&tileUpdate)}) {
+        if (remLayer->layerType == TileLayer::Type::Terrain) {
+            remTerrain(remLayer->tilePosition);
+        }
+        else if (remLayer->layerType == TileLayer::Type::Floor) {
+            remFloor(
+                remLayer->tilePosition, remLayer->tileOffset,
+                remLayer->graphicSetID,
+                static_cast<Rotation::Direction>(remLayer->graphicValue));
+        }
+        else if (remLayer->layerType == TileLayer::Type::Wall) {
+            remWall(remLayer->tilePosition,
+                    static_cast<Wall::Type>(remLayer->graphicValue));
+        }
+        else if (remLayer->layerType == TileLayer::Type::Object) {
+            remObject(
+                remLayer->tilePosition, remLayer->tileOffset,
+                remLayer->graphicSetID,
+                static_cast<Rotation::Direction>(remLayer->graphicValue));
+        }
+    }
+    else if (const auto* clearLayers{
+                 std::get_if<TileClearLayers>(&tileUpdate)}) {
+        clearTileLayers(clearLayers->tilePosition,
+                        clearLayers->layerTypesToClear);
+    }
+    else if (const auto* extentClearLayers{
+                 std::get_if<TileExtentClearLayers>(&tileUpdate)}) {
+        clearExtentLayers(extentClearLayers->tileExtent,
+                          extentClearLayers->layerTypesToClear);
     }
 }
 
@@ -134,5 +379,21 @@ void TileMap::saveChunkToSnapshot(const Chunk& chunk,
     }
 }
 
+Uint64 TileMap::getChunkVersion(const ChunkPosition& chunkPosition) const
+{
+    Uint64 version{static_cast<Uint64>(versionRunID) << 32};
+    auto countIt{chunkEditCounts.find(chunkPosition)};
+    if (countIt != chunkEditCounts.end()) {
+        version |= countIt->second;
+    }
+
+    return version;
+}
+
+void TileMap::incrementChunkVersion(const ChunkPosition& chunkPosition)
+{
+    chunkEditCounts[chunkPosition]++;
+}
+
 } // End namespace Server
 } // End namespace AM
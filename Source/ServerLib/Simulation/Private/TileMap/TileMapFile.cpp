@@ -0,0 +1,344 @@
+#include "TileMapFile.h"
+#include "Deserialize.h"
+#include "ByteTools.h"
+#include "Log.h"
+#include "AMAssert.h"
+#include <fstream>
+#include <array>
+#include <chrono>
+
+namespace AM
+{
+namespace Server
+{
+TileMapFile::TileMapFile()
+: mappedFile{}
+, filePath{}
+, header{}
+, slots{}
+, slotCount{0}
+, slotIndices{}
+, untakenCount{0}
+, nextPrefetchedSlot{0}
+, prefetchThreadObj{}
+, exitRequested{false}
+{
+}
+
+TileMapFile::~TileMapFile()
+{
+    stopPrefetch();
+}
+
+std::expected<void, TileMapFile::OpenError>
+    TileMapFile::open(const std::string& inFilePath)
+{
+    close();
+
+    if (!(mappedFile.open(inFilePath))) {
+        return std::unexpected{OpenError::FailedToMap};
+    }
+    const Uint8* data{mappedFile.data()};
+    std::size_t fileSize{mappedFile.size()};
+
+    // Note: Both formats start with a 2B version, so we can check it before
+    //       checking anything else.
+    if (fileSize < 2) {
+        close();
+        return std::unexpected{OpenError::InvalidData};
+    }
+    Uint16 version{ByteTools::read16(data)};
+    if (version < FIRST_INDEXED_VERSION) {
+        close();
+        return std::unexpected{OpenError::LegacyFormat};
+    }
+
+    // Parse the header.
+    std::size_t headerSize{(version >= FIRST_GENERATION_VERSION)
+                               ? HEADER_SIZE
+                               : V2_HEADER_SIZE};
+    if (fileSize < headerSize) {
+        close();
+        return std::unexpected{OpenError::InvalidData};
+    }
+    header.version = version;
+    header.xLengthChunks = ByteTools::read16(data + 2);
+    header.yLengthChunks = ByteTools::read16(data + 4);
+    header.zLengthChunks = ByteTools::read16(data + 6);
+    std::size_t chunkCount{ByteTools::read32(data + 8)};
+    header.generation = (version >= FIRST_GENERATION_VERSION)
+                            ? ByteTools::read32(data + 12)
+                            : 0;
+
+    std::size_t indexEnd{headerSize + (chunkCount * INDEX_ENTRY_SIZE)};
+    if (fileSize < indexEnd) {
+        close();
+        return std::unexpected{OpenError::InvalidData};
+    }
+
+    // Parse the index.
+    slots = std::make_unique<Slot[]>(chunkCount);
+    slotCount = chunkCount;
+    slotIndices.reserve(chunkCount);
+    for (std::size_t i{0}; i < chunkCount; ++i) {
+        const Uint8* entry{data + headerSize + (i * INDEX_ENTRY_SIZE)};
+        Slot& slot{slots[i]};
+        slot.position.x = static_cast<Sint32>(ByteTools::read32(entry));
+        slot.position.y = static_cast<Sint32>(ByteTools::read32(entry + 4));
+        slot.position.z = static_cast<Sint32>(ByteTools::read32(entry + 8));
+        slot.offset = ByteTools::read32(entry + 12);
+        slot.size = ByteTools::read32(entry + 16);
+
+        if ((slot.offset < indexEnd) || ((slot.offset + slot.size) > fileSize)) {
+            close();
+            return std::unexpected{OpenError::InvalidData};
+        }
+
+        slotIndices.emplace(slot.position, i);
+    }
+
+    filePath = inFilePath;
+    untakenCount = chunkCount;
+    nextPrefetchedSlot = 0;
+
+    return {};
+}
+
+void TileMapFile::close()
+{
+    stopPrefetch();
+
+    mappedFile.close();
+    filePath.clear();
+    header = {};
+    slots.reset();
+    slotCount = 0;
+    slotIndices.clear();
+    untakenCount = 0;
+    nextPrefetchedSlot = 0;
+}
+
+bool TileMapFile::isOpen() const
+{
+    return mappedFile.isOpen();
+}
+
+const std::string& TileMapFile::getFilePath() const
+{
+    return filePath;
+}
+
+const TileMapFile::Header& TileMapFile::getHeader() const
+{
+    return header;
+}
+
+bool TileMapFile::takeChunk(const ChunkPosition& chunkPosition,
+                            ChunkSnapshot& outSnapshot)
+{
+    auto slotIt{slotIndices.find(chunkPosition)};
+    if (slotIt == slotIndices.end()) {
+        return false;
+    }
+    Slot& slot{slots[slotIt->second]};
+
+    // If the prefetch thread hasn't touched this chunk, decode it ourselves.
+    SlotState state{SlotState::Pending};
+    if (slot.state.compare_exchange_strong(state, SlotState::Taken,
+                                           std::memory_order_acq_rel)) {
+        decodeSlot(slot, outSnapshot);
+        untakenCount--;
+        return true;
+    }
+
+    // If the prefetch thread is decoding this chunk, wait for it to finish.
+    // Note: This is a single chunk, so it won't take long.
+    while (state == SlotState::Decoding) {
+        std::this_thread::yield();
+        state = slot.state.load(std::memory_order_acquire);
+    }
+
+    if (state == SlotState::Decoded) {
+        outSnapshot = std::move(slot.prefetchedSnapshot);
+        slot.prefetchedSnapshot = {};
+        slot.state.store(SlotState::Taken, std::memory_order_release);
+        untakenCount--;
+        return true;
+    }
+
+    // Already taken.
+    return false;
+}
+
+void TileMapFile::discardChunk(const ChunkPosition& chunkPosition)
+{
+    auto slotIt{slotIndices.find(chunkPosition)};
+    if (slotIt == slotIndices.end()) {
+        return;
+    }
+    Slot& slot{slots[slotIt->second]};
+
+    // Mark the slot as taken. If the prefetch thread is decoding it, wait 
+    // for it to finish first.
+    SlotState state{slot.state.load(std::memory_order_acquire)};
+    while (true) {
+        if (state == SlotState::Taken) {
+            return;
+        }
+        else if (state == SlotState::Decoding) {
+            std::this_thread::yield();
+            state = slot.state.load(std::memory_order_acquire);
+        }
+        else if (slot.state.compare_exchange_weak(state, SlotState::Taken,
+                                                  std::memory_order_acq_rel)) {
+            break;
+        }
+    }
+
+    // If the prefetch thread already decoded it, free the decoded data.
+    if (state == SlotState::Decoded) {
+        slot.prefetchedSnapshot = {};
+    }
+    untakenCount--;
+}
+
+bool TileMapFile::takePrefetchedChunk(ChunkPosition& outPosition,
+                                      ChunkSnapshot& outSnapshot)
+{
+    std::size_t slotIndex{nextPrefetchedSlot.load()};
+    while (slotIndex < slotCount) {
+        Slot& slot{slots[slotIndex]};
+        SlotState state{slot.state.load(std::memory_order_acquire)};
+        if (state == SlotState::Taken) {
+            // Already taken through takeChunk(), skip it.
+            nextPrefetchedSlot = ++slotIndex;
+            continue;
+        }
+        else if (state == SlotState::Decoded) {
+            outPosition = slot.position;
+            outSnapshot = std::move(slot.prefetchedSnapshot);
+            slot.prefetchedSnapshot = {};
+            slot.state.store(SlotState::Taken, std::memory_order_release);
+            untakenCount--;
+            nextPrefetchedSlot = ++slotIndex;
+            return true;
+        }
+
+        // The next chunk isn't ready yet.
+        return false;
+    }
+
+    return false;
+}
+
+void TileMapFile::startPrefetch()
+{
+    if (prefetchThreadObj.joinable() || (untakenCount == 0)) {
+        return;
+    }
+
+    exitRequested = false;
+    prefetchThreadObj = std::thread(&TileMapFile::prefetchChunks, this);
+}
+
+void TileMapFile::stopPrefetch()
+{
+    if (prefetchThreadObj.joinable()) {
+        exitRequested = true;
+        prefetchThreadObj.join();
+    }
+}
+
+std::size_t TileMapFile::getUntakenChunkCount() const
+{
+    return untakenCount;
+}
+
+bool TileMapFile::write(const std::string& filePath, const Header& header,
+                        const std::vector<ChunkBlob>& chunkBlobs)
+{
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!(file.is_open())) {
+        LOG_ERROR("Failed to open file: %s", filePath.c_str());
+        return false;
+    }
+
+    // Write the header.
+    std::array<Uint8, HEADER_SIZE> headerBytes{};
+    ByteTools::write16(header.version, &(headerBytes[0]));
+    ByteTools::write16(header.xLengthChunks, &(headerBytes[2]));
+    ByteTools::write16(header.yLengthChunks, &(headerBytes[4]));
+    ByteTools::write16(header.zLengthChunks, &(headerBytes[6]));
+    ByteTools::write32(static_cast<Uint32>(chunkBlobs.size()),
+                       &(headerBytes[8]));
+    ByteTools::write32(header.generation, &(headerBytes[12]));
+    file.write(reinterpret_cast<const char*>(headerBytes.data()),
+               headerBytes.size());
+
+    // Write the index. Chunk data is laid out in the same order.
+    std::size_t dataOffset{HEADER_SIZE
+                           + (chunkBlobs.size() * INDEX_ENTRY_SIZE)};
+    std::array<Uint8, INDEX_ENTRY_SIZE> entryBytes{};
+    for (const ChunkBlob& blob : chunkBlobs) {
+        ByteTools::write32(static_cast<Uint32>(blob.position.x),
+                           &(entryBytes[0]));
+        ByteTools::write32(static_cast<Uint32>(blob.position.y),
+                           &(entryBytes[4]));
+        ByteTools::write32(static_cast<Uint32>(blob.position.z),
+                           &(entryBytes[8]));
+        ByteTools::write32(static_cast<Uint32>(dataOffset), &(entryBytes[12]));
+        ByteTools::write32(static_cast<Uint32>(blob.size), &(entryBytes[16]));
+        file.write(reinterpret_cast<const char*>(entryBytes.data()),
+                   entryBytes.size());
+
+        dataOffset += blob.size;
+    }
+
+    // Write the chunk data.
+    for (const ChunkBlob& blob : chunkBlobs) {
+        file.write(reinterpret_cast<const char*>(blob.data), blob.size);
+    }
+
+    if (!(file.good())) {
+        LOG_ERROR("Failed while writing file: %s", filePath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void TileMapFile::decodeSlot(const Slot& slot,
+                             ChunkSnapshot& outSnapshot) const
+{
+    if (!(Deserialize::fromBuffer(mappedFile.data(), slot.size, outSnapshot,
+                                  slot.offset))) {
+        LOG_FATAL("Failed to deserialize chunk (%d, %d, %d) in map file: %s",
+                  slot.position.x, slot.position.y, slot.position.z,
+                  filePath.c_str());
+    }
+}
+
+void TileMapFile::prefetchChunks()
+{
+    for (std::size_t i{0}; i < slotCount; ++i) {
+        // Don't get too far ahead of the chunks that have been taken.
+        while (!exitRequested && (i >= (nextPrefetchedSlot + PREFETCH_WINDOW))) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (exitRequested) {
+            break;
+        }
+
+        // If this chunk hasn't been touched, decode it.
+        Slot& slot{slots[i]};
+        SlotState state{SlotState::Pending};
+        if (slot.state.compare_exchange_strong(state, SlotState::Decoding,
+                                               std::memory_order_acq_rel)) {
+            decodeSlot(slot, slot.prefetchedSnapshot);
+            slot.state.store(SlotState::Decoded, std::memory_order_release);
+        }
+    }
+}
+
+} // End namespace Server
+} // End namespace AM
@@ -0,0 +1,264 @@
+#include "TileMapJournal.h"
+#include "Serialize.h"
+#include "Deserialize.h"
+#include "ByteTools.h"
+#include "Log.h"
+#include "tracy/Tracy.hpp"
+#include "bitsery/ext/std_variant.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace AM
+{
+namespace Server
+{
+/** A single journal record's payload. Wraps the variant so we can give it a
+    serialize function. */
+struct TileMapJournalRecord {
+    TileMapBase::TileUpdateVariant update{};
+};
+
+template<typename S>
+void serialize(S& serializer, TileMapJournalRecord& record)
+{
+    serializer.ext(record.update, bitsery::ext::StdVariant{});
+}
+
+TileMapJournal::TileMapJournal()
+: filePath{}
+, file{nullptr}
+, queuedRecords{}
+, writingRecords{}
+, writerThreadObj{}
+, exitRequested{false}
+, queueMutex{}
+, queueCondVar{}
+, fileMutex{}
+{
+}
+
+TileMapJournal::~TileMapJournal()
+{
+    // Let the writer thread write any waiting records, then end it.
+    if (writerThreadObj.joinable()) {
+        {
+            std::unique_lock lock{queueMutex};
+            exitRequested = true;
+        }
+        queueCondVar.notify_one();
+        writerThreadObj.join();
+    }
+
+    if (file != nullptr) {
+        std::fclose(file);
+    }
+}
+
+std::size_t TileMapJournal::open(
+    const std::string& inFilePath, Uint32 mapGeneration,
+    const std::function<void(const TileMapBase::TileUpdateVariant&)>&
+        replayFunction)
+{
+    filePath = inFilePath;
+
+    // Read the whole journal, if it exists.
+    BinaryBuffer fileBytes{};
+    {
+        std::ifstream inputFile(filePath, std::ios::binary);
+        if (inputFile.is_open()) {
+            fileBytes.assign(std::istreambuf_iterator<char>{inputFile},
+                             std::istreambuf_iterator<char>{});
+        }
+    }
+
+    // If the journal wasn't written against the current map file, its
+    // edits are either already in the map or don't apply to it. Start over.
+    if ((fileBytes.size() < FILE_HEADER_SIZE)
+        || (ByteTools::read32(fileBytes.data()) != mapGeneration)) {
+        if (!(fileBytes.empty())) {
+            LOG_INFO("Discarding tile map journal from a different map "
+                     "generation.");
+        }
+        reset(mapGeneration);
+        writerThreadObj = std::thread(&TileMapJournal::writerThread, this);
+        return 0;
+    }
+
+    // Replay each intact record.
+    std::size_t readIndex{FILE_HEADER_SIZE};
+    std::size_t recordCount{0};
+    TileMapJournalRecord record{};
+    while ((fileBytes.size() - readIndex) >= RECORD_HEADER_SIZE) {
+        const Uint8* recordData{fileBytes.data() + readIndex};
+        std::size_t payloadSize{ByteTools::read32(recordData)};
+        Uint32 checksum{ByteTools::read32(recordData + 4)};
+        if ((fileBytes.size() - readIndex - RECORD_HEADER_SIZE)
+            < payloadSize) {
+            break;
+        }
+
+        const Uint8* payload{recordData + RECORD_HEADER_SIZE};
+        if ((calcChecksum(payload, payloadSize) != checksum)
+            || !(Deserialize::fromBuffer(payload, payloadSize, record))) {
+            break;
+        }
+
+        replayFunction(record.update);
+        readIndex += (RECORD_HEADER_SIZE + payloadSize);
+        recordCount++;
+    }
+
+    // If there's a torn or corrupt tail, cut it off so new records don't get
+    // appended after it.
+    if (readIndex < fileBytes.size()) {
+        LOG_INFO("Discarding %zu bytes of incomplete tile map journal data.",
+                 (fileBytes.size() - readIndex));
+        std::error_code errorCode{};
+        std::filesystem::resize_file(filePath, readIndex, errorCode);
+        if (errorCode) {
+            LOG_FATAL("Failed to truncate tile map journal: %s",
+                      errorCode.message().c_str());
+        }
+    }
+
+    // Open the journal for appending and start the writer.
+    file = std::fopen(filePath.c_str(), "ab");
+    if (file == nullptr) {
+        LOG_FATAL("Failed to open tile map journal at path: %s",
+                  filePath.c_str());
+    }
+    writerThreadObj = std::thread(&TileMapJournal::writerThread, this);
+
+    return recordCount;
+}
+
+void TileMapJournal::append(
+    std::span<const TileMapBase::TileUpdateVariant> updates)
+{
+    if (updates.empty()) {
+        return;
+    }
+
+    {
+        std::unique_lock lock{queueMutex};
+        TileMapJournalRecord record{};
+        for (const TileMapBase::TileUpdateVariant& update : updates) {
+            record.update = update;
+
+            // Serialize the payload after room for the header, then fill in
+            // the header.
+            std::size_t recordIndex{queuedRecords.size()};
+            std::size_t payloadSize{Serialize::measureSize(record)};
+            queuedRecords.resize(recordIndex + RECORD_HEADER_SIZE
+                                 + payloadSize);
+            Serialize::toBuffer(queuedRecords.data(), queuedRecords.size(),
+                                record, (recordIndex + RECORD_HEADER_SIZE));
+
+            Uint8* recordData{queuedRecords.data() + recordIndex};
+            ByteTools::write32(static_cast<Uint32>(payloadSize), recordData);
+            ByteTools::write32(
+                calcChecksum((recordData + RECORD_HEADER_SIZE), payloadSize),
+                (recordData + 4));
+        }
+    }
+    queueCondVar.notify_one();
+}
+
+void TileMapJournal::clear(Uint32 mapGeneration)
+{
+    // Note: We take fileMutex first, so the writer thread can't be holding
+    //       any records that we're about to discard.
+    std::scoped_lock lock{fileMutex, queueMutex};
+    queuedRecords.clear();
+
+    reset(mapGeneration);
+}
+
+void TileMapJournal::reset(Uint32 mapGeneration)
+{
+    if (file == nullptr) {
+        file = std::fopen(filePath.c_str(), "wb");
+    }
+    else {
+        file = std::freopen(filePath.c_str(), "wb", file);
+    }
+    if (file == nullptr) {
+        LOG_FATAL("Failed to truncate tile map journal at path: %s",
+                  filePath.c_str());
+    }
+
+    BinaryBuffer headerBytes(FILE_HEADER_SIZE);
+    ByteTools::write32(mapGeneration, headerBytes.data());
+    writeAndSync(headerBytes);
+}
+
+void TileMapJournal::writerThread()
+{
+    while (true) {
+        // Wait until there are records to write, or we're told to exit.
+        {
+            std::unique_lock lock{queueMutex};
+            queueCondVar.wait(lock, [this] {
+                return (!(queuedRecords.empty()) || exitRequested);
+            });
+            if (queuedRecords.empty() && exitRequested) {
+                return;
+            }
+        }
+
+        // Take every waiting record and write them as one batch.
+        // Note: Any records that get queued while we're syncing will be
+        //       picked up in the next batch.
+        std::unique_lock fileLock{fileMutex};
+        {
+            std::unique_lock lock{queueMutex};
+            std::swap(queuedRecords, writingRecords);
+        }
+
+        writeAndSync(writingRecords);
+        writingRecords.clear();
+    }
+}
+
+void TileMapJournal::writeAndSync(const BinaryBuffer& bytes)
+{
+    ZoneScoped;
+
+    if (bytes.empty()) {
+        return;
+    }
+
+    if ((std::fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size())
+        || (std::fflush(file) != 0)) {
+        LOG_ERROR("Failed to write to tile map journal.");
+        return;
+    }
+
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
+
+Uint32 TileMapJournal::calcChecksum(const Uint8* data, std::size_t size)
+{
+    // FNV-1a. Only needs to catch torn writes, not tampering.
+    Uint32 hash{2166136261u};
+    for (std::size_t i{0}; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+} // End namespace Server
+} // End namespace AM
@@ -3,63 +3,79 @@
 #include "Network.h"
 #include "ISimulationExtension.h"
 #include "ClientSimData.h"
+#include "ChunkExtent.h"
 #include "ChunkPosition.h"
 #include "TilePosition.h"
 #include "AMAssert.h"
 #include "tracy/Tracy.hpp"
 #include <variant>
+#include <algorithm>
+#include <cstdlib>
 
 namespace AM
 {
 namespace Server
 {
-/** Returns the extent that's in range of a given tile update.
-    Note: This matches ChunkUpdateSystem's behavior, which includes all
-          directly surrounding chunks in the X/Y directions, and every chunk 
-          along the Z axis. */
-struct InRangeExtentGetter {
-    TileMap& tileMap;
-
+/** Returns the extent of chunks that a given tile update touches. */
+struct UpdatedChunkExtentGetter {
     ChunkExtent operator()(const TileExtentClearLayers& tileUpdate)
     {
-        const ChunkExtent& mapChunkExtent{tileMap.getChunkExtent()};
-        ChunkExtent chunkExtent{tileUpdate.tileExtent};
-        chunkExtent.x -= 1;
-        chunkExtent.y -= 1;
-        chunkExtent.z = mapChunkExtent.z;
-        chunkExtent.xLength += 2;
-        chunkExtent.yLength += 2;
-        chunkExtent.zLength = mapChunkExtent.zLength;
-        chunkExtent.intersectWith(mapChunkExtent);
-        return chunkExtent;
+        const TileExtent& tileExtent{tileUpdate.tileExtent};
+        ChunkPosition minChunk{
+            TilePosition{tileExtent.x, tileExtent.y, tileExtent.z}};
+        ChunkPosition maxChunk{TilePosition{
+            tileExtent.xMax(), tileExtent.yMax(), tileExtent.zMax()}};
+        return {minChunk.x,
+                minChunk.y,
+                minChunk.z,
+                (maxChunk.x - minChunk.x + 1),
+                (maxChunk.y - minChunk.y + 1),
+                (maxChunk.z - minChunk.z + 1)};
     }
 
     // TileAddLayer, TileRemoveLayer, TileClearLayers
     template<typename T>
     ChunkExtent operator()(const T& tileUpdate)
     {
-        const ChunkExtent& mapChunkExtent{tileMap.getChunkExtent()};
-        ChunkPosition centerChunk{tileUpdate.tilePosition};
-        ChunkExtent chunkExtent{(centerChunk.x - 1),
-                                (centerChunk.y - 1),
-                                mapChunkExtent.z,
-                                3,
-                                3,
-                                mapChunkExtent.zLength};
-        chunkExtent.intersectWith(tileMap.getChunkExtent());
-        return chunkExtent;
+        ChunkPosition chunkPosition{tileUpdate.tilePosition};
+        return {chunkPosition.x, chunkPosition.y, chunkPosition.z, 1, 1, 1};
     }
 };
 
-/** Sends the given tile update to the currently set client netID. */
-struct UpdateSender {
-    Network& network;
-    NetworkID netID{};
+/** Converts a tile update into a batch entry. */
+struct BatchEntryConverter {
+    TileUpdateBatch::UpdateVariant operator()(const TileAddLayer& tileUpdate)
+    {
+        return TileUpdateBatch::LayerRun{
+            TileUpdateBatch::LayerRun::Operation::Add,
+            tileUpdate.tilePosition,
+            TileUpdateBatch::LayerRun::Direction::East,
+            1,
+            tileUpdate.tileOffset,
+            tileUpdate.layerType,
+            tileUpdate.graphicSetID,
+            tileUpdate.graphicValue};
+    }
+
+    TileUpdateBatch::UpdateVariant
+        operator()(const TileRemoveLayer& tileUpdate)
+    {
+        return TileUpdateBatch::LayerRun{
+            TileUpdateBatch::LayerRun::Operation::Remove,
+            tileUpdate.tilePosition,
+            TileUpdateBatch::LayerRun::Direction::East,
+            1,
+            tileUpdate.tileOffset,
+            tileUpdate.layerType,
+            tileUpdate.graphicSetID,
+            tileUpdate.graphicValue};
+    }
 
+    // TileClearLayers, TileExtentClearLayers
     template<typename T>
-    void operator()(const T& tileUpdate)
+    TileUpdateBatch::UpdateVariant operator()(const T& tileUpdate)
     {
-        network.serializeAndSend<T>(netID, tileUpdate);
+        return tileUpdate;
     }
 };
 
@@ -67,6 +83,8 @@ TileUpdateSystem::TileUpdateSystem(World& inWorld, Network& inNetwork)
 : world{inWorld}
 , network{inNetwork}
 , extension{nullptr}
+, clientBatches{}
+, recipients{}
 , addLayerRequestQueue{network.getEventDispatcher()}
 , removeLayerRequestQueue{network.getEventDispatcher()}
 , clearLayersRequestQueue{network.getEventDispatcher()}
@@ -108,30 +126,63 @@ void TileUpdateSystem::updateTiles()
 
 void TileUpdateSystem::sendTileUpdates()
 {
-    auto clientView = world.registry.view<ClientSimData>();
+    ZoneScoped;
+
     const std::vector<TileMapBase::TileUpdateVariant>& tileUpdateHistory{
         world.tileMap.getTileUpdateHistory()};
+    if (tileUpdateHistory.empty()) {
+        return;
+    }
 
     // For every tile update that occurred since we last sent updates.
-    InRangeExtentGetter extentGetter{world.tileMap};
-    UpdateSender updateSender{network};
     for (const auto& updateVariant : tileUpdateHistory) {
-        // Find the entities that are in range of this update.
-        ChunkExtent inRangeExtent{std::visit(extentGetter, updateVariant)};
-        std::vector<entt::entity>& entitiesInRange{
-            world.entityLocator.getEntities(inRangeExtent)};
-
-        // Send the update to all of the in-range clients.
-        for (entt::entity entity : entitiesInRange) {
-            if (world.registry.all_of<ClientSimData>(entity)) {
-                ClientSimData& client{clientView.get<ClientSimData>(entity)};
-                updateSender.netID = client.netID;
-                std::visit(updateSender, updateVariant);
+        // Bump the updated chunks' versions and gather the clients that are 
+        // subscribed to them.
+        ChunkExtent updatedExtent{
+            std::visit(UpdatedChunkExtentGetter{}, updateVariant)};
+        recipients.clear();
+        for (int z{updatedExtent.z}; z <= updatedExtent.zMax(); ++z) {
+            for (int y{updatedExtent.y}; y <= updatedExtent.yMax(); ++y) {
+                for (int x{updatedExtent.x}; x <= updatedExtent.xMax(); ++x) {
+                    world.tileMap.incrementChunkVersion({x, y, z});
+
+                    const std::vector<entt::entity>& subscribers{
+                        world.chunkSubscriptions.getSubscribers({x, y, z})};
+                    recipients.insert(recipients.end(), subscribers.begin(),
+                                      subscribers.end());
+                }
             }
         }
+
+        // If the update spans multiple chunks, a client may be subscribed 
+        // to more than one of them. Make sure it only gets the update once.
+        if ((updatedExtent.xLength * updatedExtent.yLength
+             * updatedExtent.zLength)
+            > 1) {
+            std::sort(recipients.begin(), recipients.end());
+            recipients.erase(std::unique(recipients.begin(), recipients.end()),
+                             recipients.end());
+        }
+
+        // Add the update to each subscribed client's batch.
+        // Note: If a batch is full, we send it and start a new one. The 
+        //       client applies them in the order that they're received.
+        for (entt::entity entity : recipients) {
+            TileUpdateBatch& batch{clientBatches[entity]};
+            if (batch.updates.size() == TileUpdateBatch::MAX_UPDATES) {
+                sendBatch(entity, batch);
+            }
+            appendToBatch(batch, updateVariant);
+        }
+    }
+
+    // Send each client its last batch.
+    for (auto& [entity, batch] : clientBatches) {
+        sendBatch(entity, batch);
     }
 
-    world.tileMap.clearTileUpdateHistory();
+    clientBatches.clear();
+    world.tileMap.flushTileUpdateHistory();
 }
 
 void TileUpdateSystem::setExtension(ISimulationExtension* inExtension)
@@ -239,5 +290,79 @@ void TileUpdateSystem::clearExtentLayers(
                                     clearExtentLayersRequest.layerTypesToClear);
 }
 
+void TileUpdateSystem::appendToBatch(
+    TileUpdateBatch& batch, const TileMapBase::TileUpdateVariant& update)
+{
+    using LayerRun = TileUpdateBatch::LayerRun;
+    TileUpdateBatch::UpdateVariant entry{
+        std::visit(BatchEntryConverter{}, update)};
+
+    // If this entry and the last one aren't both layer runs, there's nothing 
+    // to merge.
+    LayerRun* newRun{std::get_if<LayerRun>(&entry)};
+    LayerRun* lastRun{batch.updates.empty()
+                          ? nullptr
+                          : std::get_if<LayerRun>(&(batch.updates.back()))};
+    if (!newRun || !lastRun) {
+        batch.updates.push_back(entry);
+        return;
+    }
+
+    // If the new run doesn't have the same layer as the last one, we can't 
+    // merge them.
+    if ((newRun->operation != lastRun->operation)
+        || (newRun->tileOffset != lastRun->tileOffset)
+        || (newRun->layerType != lastRun->layerType)
+        || (newRun->graphicSetID != lastRun->graphicSetID)
+        || (newRun->graphicValue != lastRun->graphicValue)
+        || (lastRun->length == SDL_MAX_UINT16)) {
+        batch.updates.push_back(entry);
+        return;
+    }
+
+    // If the last run is a single tile, the new tile can extend it in any 
+    // direction.
+    const TilePosition& newPosition{newRun->startPosition};
+    if (lastRun->length == 1) {
+        const TilePosition& lastPosition{lastRun->startPosition};
+        if ((newPosition.z == lastPosition.z)
+            && (newPosition.y == lastPosition.y)
+            && (std::abs(newPosition.x - lastPosition.x) == 1)) {
+            lastRun->direction = (newPosition.x > lastPosition.x)
+                                     ? LayerRun::Direction::East
+                                     : LayerRun::Direction::West;
+            lastRun->length++;
+            return;
+        }
+        else if ((newPosition.z == lastPosition.z)
+                 && (newPosition.x == lastPosition.x)
+                 && (std::abs(newPosition.y - lastPosition.y) == 1)) {
+            lastRun->direction = (newPosition.y > lastPosition.y)
+                                     ? LayerRun::Direction::South
+                                     : LayerRun::Direction::North;
+            lastRun->length++;
+            return;
+        }
+    }
+    // Otherwise, it must be the next tile in the run's direction.
+    else if (newPosition == lastRun->getPosition(lastRun->length)) {
+        lastRun->length++;
+        return;
+    }
+
+    batch.updates.push_back(entry);
+}
+
+void TileUpdateSystem::sendBatch(entt::entity clientEntity,
+                                 TileUpdateBatch& batch)
+{
+    // Note: Only client entities can be subscribed.
+    const ClientSimData& client{
+        world.registry.get<ClientSimData>(clientEntity)};
+    network.serializeAndSend(client.netID, batch);
+
+    batch.updates.clear();
+}
+
 } // End namespace Server
 } // End namespace AM
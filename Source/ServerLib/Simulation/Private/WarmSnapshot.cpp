@@ -0,0 +1,264 @@
+#include "WarmSnapshot.h"
+#include "Paths.h"
+#include "ByteTools.h"
+#include "Log.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <array>
+
+namespace AM
+{
+namespace Server
+{
+/** The magic bytes at the start of every snapshot. */
+static constexpr std::array<Uint8, 4> MAGIC{'A', 'M', 'W', 'S'};
+
+WarmSnapshot::WarmSnapshot()
+: mappedFile{}
+, blobData{}
+, entities{}
+, items{}
+, entityStoredValueIDMap{}
+, globalStoredValueMap{}
+{
+}
+
+void WarmSnapshot::clear()
+{
+    mappedFile.close();
+    blobData.clear();
+    entities.clear();
+    items.clear();
+    entityStoredValueIDMap = {};
+    globalStoredValueMap = {};
+}
+
+void WarmSnapshot::addEntity(const Uint8* blob, std::size_t blobSize)
+{
+    entities.emplace_back(addBlob(blob, blobSize));
+}
+
+void WarmSnapshot::addItem(const Uint8* blob, std::size_t blobSize)
+{
+    items.emplace_back(addBlob(blob, blobSize));
+}
+
+void WarmSnapshot::setEntityStoredValueIDMap(const Uint8* blob,
+                                             std::size_t blobSize)
+{
+    entityStoredValueIDMap = addBlob(blob, blobSize);
+}
+
+void WarmSnapshot::setGlobalStoredValueMap(const Uint8* blob,
+                                           std::size_t blobSize)
+{
+    globalStoredValueMap = addBlob(blob, blobSize);
+}
+
+bool WarmSnapshot::write(const std::string& filePath) const
+{
+    std::string tempPath{filePath + ".tmp"};
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!(file.is_open())) {
+            LOG_ERROR("Failed to open file: %s", tempPath.c_str());
+            return false;
+        }
+
+        // Write the header.
+        Uint64 resourceDataHash{hashResourceData()};
+        std::array<Uint8, HEADER_SIZE> headerBytes{};
+        std::copy(MAGIC.begin(), MAGIC.end(), headerBytes.begin());
+        ByteTools::write16(FORMAT_VERSION, &(headerBytes[4]));
+        ByteTools::write32(static_cast<Uint32>(resourceDataHash),
+                           &(headerBytes[8]));
+        ByteTools::write32(static_cast<Uint32>(resourceDataHash >> 32),
+                           &(headerBytes[12]));
+        ByteTools::write32(static_cast<Uint32>(entities.size()),
+                           &(headerBytes[16]));
+        ByteTools::write32(static_cast<Uint32>(items.size()),
+                           &(headerBytes[20]));
+        file.write(reinterpret_cast<const char*>(headerBytes.data()),
+                   headerBytes.size());
+
+        // Write the index. The blobs are laid out in blobData's order, so
+        // we only need to shift them past the header and index.
+        std::size_t dataStart{
+            HEADER_SIZE
+            + ((entities.size() + items.size() + 2) * INDEX_ENTRY_SIZE)};
+        std::array<Uint8, INDEX_ENTRY_SIZE> entryBytes{};
+        auto writeEntry = [&](const BlobLocation& location) {
+            ByteTools::write32(static_cast<Uint32>(dataStart + location.offset),
+                               &(entryBytes[0]));
+            ByteTools::write32(static_cast<Uint32>(location.size),
+                               &(entryBytes[4]));
+            file.write(reinterpret_cast<const char*>(entryBytes.data()),
+                       entryBytes.size());
+        };
+        for (const BlobLocation& location : entities) {
+            writeEntry(location);
+        }
+        for (const BlobLocation& location : items) {
+            writeEntry(location);
+        }
+        writeEntry(entityStoredValueIDMap);
+        writeEntry(globalStoredValueMap);
+
+        // Write the blob data.
+        file.write(reinterpret_cast<const char*>(blobData.data()),
+                   blobData.size());
+        if (!(file.good())) {
+            LOG_ERROR("Failed to write file: %s", tempPath.c_str());
+            return false;
+        }
+    }
+
+    std::error_code errorCode{};
+    std::filesystem::rename(tempPath, filePath, errorCode);
+    if (errorCode) {
+        LOG_ERROR("Failed to replace warm snapshot: %s",
+                  errorCode.message().c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool WarmSnapshot::open(const std::string& filePath)
+{
+    clear();
+
+    if (!(std::filesystem::exists(filePath))
+        || !(mappedFile.open(filePath))) {
+        return false;
+    }
+    const Uint8* data{mappedFile.data()};
+    std::size_t fileSize{mappedFile.size()};
+
+    // Validate the header.
+    if ((fileSize < HEADER_SIZE)
+        || !(std::equal(MAGIC.begin(), MAGIC.end(), data))) {
+        LOG_INFO("Ignoring invalid warm snapshot.");
+        clear();
+        return false;
+    }
+    if (ByteTools::read16(data + 4) != FORMAT_VERSION) {
+        LOG_INFO("Ignoring warm snapshot from a different format version.");
+        clear();
+        return false;
+    }
+    Uint64 resourceDataHash{
+        ByteTools::read32(data + 8)
+        | (static_cast<Uint64>(ByteTools::read32(data + 12)) << 32)};
+    if (resourceDataHash != hashResourceData()) {
+        LOG_INFO("Ignoring warm snapshot, since the resource data changed.");
+        clear();
+        return false;
+    }
+
+    // Parse the index.
+    std::size_t entityCount{ByteTools::read32(data + 16)};
+    std::size_t itemCount{ByteTools::read32(data + 20)};
+    std::size_t entryCount{entityCount + itemCount + 2};
+    if (fileSize < (HEADER_SIZE + (entryCount * INDEX_ENTRY_SIZE))) {
+        LOG_INFO("Ignoring invalid warm snapshot.");
+        clear();
+        return false;
+    }
+
+    std::vector<BlobLocation> locations(entryCount);
+    for (std::size_t i{0}; i < entryCount; ++i) {
+        const Uint8* entry{data + HEADER_SIZE + (i * INDEX_ENTRY_SIZE)};
+        BlobLocation& location{locations[i]};
+        location.offset = ByteTools::read32(entry);
+        location.size = ByteTools::read32(entry + 4);
+        if ((location.offset + location.size) > fileSize) {
+            LOG_INFO("Ignoring invalid warm snapshot.");
+            clear();
+            return false;
+        }
+    }
+
+    entities.assign(locations.begin(), (locations.begin() + entityCount));
+    items.assign((locations.begin() + entityCount),
+                 (locations.begin() + entityCount + itemCount));
+    entityStoredValueIDMap = locations[entityCount + itemCount];
+    globalStoredValueMap = locations[entityCount + itemCount + 1];
+
+    return true;
+}
+
+void WarmSnapshot::remove(const std::string& filePath)
+{
+    std::error_code errorCode{};
+    std::filesystem::remove(filePath, errorCode);
+}
+
+std::size_t WarmSnapshot::getEntityCount() const
+{
+    return entities.size();
+}
+
+std::span<const Uint8> WarmSnapshot::getEntity(std::size_t index) const
+{
+    return getBlob(entities[index]);
+}
+
+std::size_t WarmSnapshot::getItemCount() const
+{
+    return items.size();
+}
+
+std::span<const Uint8> WarmSnapshot::getItem(std::size_t index) const
+{
+    return getBlob(items[index]);
+}
+
+std::span<const Uint8> WarmSnapshot::getEntityStoredValueIDMap() const
+{
+    return getBlob(entityStoredValueIDMap);
+}
+
+std::span<const Uint8> WarmSnapshot::getGlobalStoredValueMap() const
+{
+    return getBlob(globalStoredValueMap);
+}
+
+Uint64 WarmSnapshot::hashResourceData()
+{
+    std::ifstream file(Paths::BASE_PATH + "ResourceData.json",
+                       std::ios::binary);
+    BinaryBuffer bytes(std::istreambuf_iterator<char>{file},
+                       std::istreambuf_iterator<char>{});
+
+    // FNV-1a. Only needs to catch edits, not collisions on purpose.
+    Uint64 hash{14695981039346656037ull};
+    for (Uint8 byte : bytes) {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+WarmSnapshot::BlobLocation WarmSnapshot::addBlob(const Uint8* blob,
+                                                 std::size_t blobSize)
+{
+    BlobLocation location{blobData.size(), blobSize};
+    blobData.insert(blobData.end(), blob, (blob + blobSize));
+    return location;
+}
+
+const Uint8* WarmSnapshot::getBlobData() const
+{
+    return mappedFile.isOpen() ? mappedFile.data() : blobData.data();
+}
+
+std::span<const Uint8> WarmSnapshot::getBlob(const BlobLocation& location) const
+{
+    return {(getBlobData() + location.offset), location.size};
+}
+
+} // End namespace Server
+} // End namespace AM
@@ -2,6 +2,7 @@
 #include "EntityInitLua.h"
 #include "ItemInitLua.h"
 #include "Database.h"
+#include "Paths.h"
 #include "ClientSimData.h"
 #include "ReplicatedComponentList.h"
 #include "ReplicatedComponent.h"
@@ -11,23 +12,60 @@
 #include "Collision.h"
 #include "EntityInitScript.h"
 #include "PersistedEntityData.h"
+#include "PersistedBlob.h"
+#include "WarmSnapshot.h"
 #include "Deserialize.h"
 #include "Transforms.h"
 #include "SharedConfig.h"
 #include "Config.h"
 #include "VariantTools.h"
 #include "StringTools.h"
+#include "ThreadPool.h"
+#include "BinaryBuffer.h"
+#include "Timer.h"
 #include "Log.h"
 #include "AMAssert.h"
 #include "sol/sol.hpp"
 #include "boost/mp11/algorithm.hpp"
 #include <type_traits>
+#include <algorithm>
+#include <span>
 
 namespace AM
 {
 namespace Server
 {
 
+/** The number of blobs that each load worker deserializes at a time. */
+static constexpr std::size_t LOAD_BATCH_SIZE{256};
+
+/**
+ * Decodes and deserializes count blobs into outputObjects, in parallel 
+ * batches of LOAD_BATCH_SIZE.
+ *
+ * @param getBlob  A function of form std::span<const Uint8>(std::size_t) 
+ *                 that returns the blob at the given index.
+ */
+template<typename T, typename Func>
+void deserializeBlobs(ThreadPool& loadPool, std::size_t count, Func getBlob,
+                      std::vector<T>& outputObjects)
+{
+    outputObjects.resize(count);
+    std::size_t batchCount{(count + LOAD_BATCH_SIZE - 1) / LOAD_BATCH_SIZE};
+    loadPool.parallelFor(batchCount, [&](std::size_t batchIndex) {
+        std::size_t begin{batchIndex * LOAD_BATCH_SIZE};
+        std::size_t end{std::min(begin + LOAD_BATCH_SIZE, count)};
+        BinaryBuffer decodeBuffer{};
+        for (std::size_t i{begin}; i < end; ++i) {
+            std::span<const Uint8> blob{getBlob(i)};
+            std::span<const Uint8> data{PersistedBlob::decode(
+                blob.data(), blob.size(), decodeBuffer)};
+            Deserialize::fromBuffer(data.data(), data.size(),
+                                    outputObjects[i]);
+        }
+    });
+}
+
 template<typename T>
 void onComponentConstructed(entt::registry& registry, entt::entity entity)
 {
@@ -59,17 +97,23 @@ World::World(GraphicData& inGraphicData, EntityInitLua& inEntityInitLua,
              ItemInitLua& inItemInitLua)
 : registry{}
 , itemData{}
-, tileMap{inGraphicData}
+, threadPool{}
+, tileMap{inGraphicData, threadPool}
 , entityLocator{registry}
+, chunkSubscriptions{}
 , entityStoredValueIDMap{}
 , globalStoredValueMap{}
-, database{std::make_unique<Database>()}
+, database{std::make_unique<Database>(
+      (Config::USE_WAL_DATABASE ? Database::StorageMode::WriteAheadLog
+                                : Database::StorageMode::InMemory),
+      (Paths::BASE_PATH + "/Database.db3"))}
 , netIDMap{}
 , graphicData{inGraphicData}
 , entityInitLua{inEntityInitLua}
 , itemInitLua{inItemInitLua}
-, nextStoredValueID{NULL_ENTITY_STORED_VALUE_ID + 1}
+, entityStoredValueStringIDs{std::string_view{}}
 , workStringID{}
+, sharedDialogues{}
 , randomDevice{}
 , generator{randomDevice()}
 , xDistribution{Config::SPAWN_POINT_RANDOM_MIN_X,
@@ -99,14 +143,24 @@ World::World(GraphicData& inGraphicData, EntityInitLua& inEntityInitLua,
     registry.on_destroy<entt::entity>().connect<&World::onEntityDestroyed>(
         this);
 
+    // Gather our saved data. If there's a valid warm snapshot, we can map 
+    // it instead of reading the database.
+    WarmSnapshot savedData{};
+    if (savedData.open(Paths::BASE_PATH + WarmSnapshot::FILE_NAME)) {
+        LOG_INFO("Loading saved data from the warm snapshot.");
+    }
+    else {
+        fetchSavedData(savedData);
+    }
+
     // Load our saved non-client entities.
-    loadNonClientEntities();
+    loadNonClientEntities(savedData, threadPool);
 
     // Load our saved item definitions.
-    loadItems();
+    loadItems(savedData, threadPool);
 
     // Load our saved stored value data.
-    loadStoredValues();
+    loadStoredValues(savedData);
 }
 
 World::~World() = default;
@@ -191,13 +245,14 @@ std::string World::runEntityInitScript(entt::entity entity,
 {
     // Run the given script on the given entity.
     entityInitLua.selfEntity = entity;
-    auto result{entityInitLua.luaState.script(initScript.script,
-                                              &sol::script_pass_on_error)};
+    auto result{entityInitLua.scriptCache.run(initScript.script,
+                                              {"Entity init", "", entity})};
 
     // If the init script ran successfully, save it.
     std::string returnString{""};
     if (result.valid()) {
         registry.emplace<EntityInitScript>(entity, initScript);
+        shareDialogue(entity);
     }
     else {
         // Error while running the init script. Keep the entity alive (so the
@@ -214,8 +269,9 @@ std::string World::runItemInitScript(Item& item,
 {
     // Run the given script on the given item.
     itemInitLua.selfItem = &item;
-    auto result{itemInitLua.luaState.script(initScript.script,
-                                            &sol::script_pass_on_error)};
+    auto result{
+        itemInitLua.scriptCache.run(initScript.script,
+                                    {"Item init", item.stringID, entt::null})};
 
     // If the init script ran successfully, save it.
     std::string returnString{""};
@@ -231,6 +287,34 @@ std::string World::runItemInitScript(Item& item,
     return returnString;
 }
 
+void World::shareDialogue(entt::entity entity)
+{
+    auto* dialogue{registry.try_get<Dialogue>(entity)};
+    auto* initScript{registry.try_get<EntityInitScript>(entity)};
+    if (!dialogue || !(dialogue->definition) || !initScript) {
+        return;
+    }
+
+    // If this script doesn't have a live definition, use this entity's.
+    auto sharedIt{sharedDialogues.find(initScript->script)};
+    if (sharedIt == sharedDialogues.end()) {
+        sharedDialogues.emplace(initScript->script, dialogue->definition);
+        return;
+    }
+    std::shared_ptr<Dialogue::Definition> sharedDefinition{
+        sharedIt->second.lock()};
+    if (!sharedDefinition) {
+        sharedIt->second = dialogue->definition;
+        return;
+    }
+
+    // If this entity's definition matches the shared one, switch to it.
+    if ((sharedDefinition != dialogue->definition)
+        && (*sharedDefinition == *(dialogue->definition))) {
+        dialogue->definition = sharedDefinition;
+    }
+}
+
 EntityStoredValueID World::getEntityStoredValueID(std::string_view stringID)
 {
     // Derive string ID in case the user accidentally passed a display name.
@@ -243,19 +327,44 @@ EntityStoredValueID World::getEntityStoredValueID(std::string_view stringID)
     }
     else {
         // Check if we've ran out of IDs.
-        if (nextStoredValueID == SDL_MAX_UINT16) {
+        if (entityStoredValueStringIDs.size() == SDL_MAX_UINT16) {
             return NULL_ENTITY_STORED_VALUE_ID;
         }
 
         // Flag doesn't exist, add it to the map.
-        EntityStoredValueID newFlagID{static_cast<Uint16>(nextStoredValueID)};
-        entityStoredValueIDMap.emplace(workStringID, newFlagID);
-        nextStoredValueID++;
+        EntityStoredValueID newFlagID{
+            static_cast<Uint16>(entityStoredValueStringIDs.size())};
+        auto newIDIt{
+            entityStoredValueIDMap.emplace(workStringID, newFlagID).first};
+        entityStoredValueStringIDs.emplace_back(newIDIt->first);
 
         return newFlagID;
     }
 }
 
+EntityStoredValueID World::findEntityStoredValueID(std::string_view stringID)
+{
+    // Derive string ID in case the user accidentally passed a display name.
+    StringTools::deriveStringID(stringID, workStringID);
+
+    auto storedValueIDIt{entityStoredValueIDMap.find(workStringID)};
+    if (storedValueIDIt != entityStoredValueIDMap.end()) {
+        return storedValueIDIt->second;
+    }
+
+    return NULL_ENTITY_STORED_VALUE_ID;
+}
+
+std::string_view
+    World::getEntityStoredValueStringID(EntityStoredValueID numericID) const
+{
+    if (numericID < entityStoredValueStringIDs.size()) {
+        return entityStoredValueStringIDs[numericID];
+    }
+
+    return {};
+}
+
 void World::storeGlobalValue(std::string_view stringID, Uint32 newValue)
 {
     // Derive string ID in case the user accidentally passed a display name.
@@ -338,21 +447,55 @@ void World::onEntityDestroyed(entt::entity entity)
     // Remove it from the locator.
     entityLocator.removeEntity(entity);
 
-    // If the entity is in the database, delete it (does nothing if it isn't).
-    database->deleteEntityData(entity);
+    // If it's a client entity, remove its chunk subscriptions (does nothing 
+    // if it isn't).
+    chunkSubscriptions.unsubscribeAll(entity);
+
+    // Note: SaveSystem deletes the entity from the database during the next 
+    //       save.
+}
+
+void World::fetchSavedData(WarmSnapshot& savedData)
+{
+    // Copy all of our saved blobs out of the database.
+    // Note: The database only has one connection, so this is serial.
+    Timer timer{};
+    database->iterateEntities([&](entt::entity, const Uint8* entityDataBuffer,
+                                  std::size_t dataSize) {
+        savedData.addEntity(entityDataBuffer, dataSize);
+    });
+    database->iterateItems(
+        [&](ItemID, const Uint8* itemDataBuffer, std::size_t dataSize) {
+            savedData.addItem(itemDataBuffer, dataSize);
+        });
+    database->getEntityStoredValueIDMap(
+        [&](const Uint8* dataBuffer, std::size_t dataSize) {
+            savedData.setEntityStoredValueIDMap(dataBuffer, dataSize);
+        });
+    database->getGlobalStoredValueMap(
+        [&](const Uint8* dataBuffer, std::size_t dataSize) {
+            savedData.setGlobalStoredValueMap(dataBuffer, dataSize);
+        });
+
+    LOG_INFO("Fetched saved data from the database in %.6fs.",
+             timer.getTime());
 }
 
-void World::loadNonClientEntities()
+void World::loadNonClientEntities(const WarmSnapshot& savedData,
+                                  ThreadPool& loadPool)
 {
-    auto loadEntity
-        = [&](entt::entity entity, const Uint8* entityDataBuffer,
-              std::size_t dataSize) {
-        // Deserialize the entity's data.
-        PersistedEntityData persistedEntityData{};
-        Deserialize::fromBuffer(entityDataBuffer, dataSize,
-                                persistedEntityData);
-
-        // Add the entity to the registry.
+    // Deserialize the entities' data in parallel.
+    Timer timer{};
+    std::vector<PersistedEntityData> persistedEntities{};
+    deserializeBlobs(
+        loadPool, savedData.getEntityCount(),
+        [&](std::size_t index) { return savedData.getEntity(index); },
+        persistedEntities);
+    double deserializeTime{timer.getTime()};
+
+    // Add the entities to the registry, in order.
+    timer.reset();
+    for (const PersistedEntityData& persistedEntityData : persistedEntities) {
         entt::entity newEntity{registry.create(persistedEntityData.entity)};
         if (newEntity != persistedEntityData.entity) {
             LOG_FATAL("Created entity ID doesn't match saved entity ID. "
@@ -383,46 +526,64 @@ void World::loadNonClientEntities()
                 }),
                 componentVariant);
         }
-    };
 
-    database->iterateEntities(std::move(loadEntity));
+        // Drop this entity's copy of its dialogue if another entity already 
+        // has a matching one.
+        shareDialogue(newEntity);
+    }
+    double insertTime{timer.getTime()};
+
+    LOG_INFO("Loaded %zu entities. Deserialize: %.6fs, insert: %.6fs",
+             persistedEntities.size(), deserializeTime, insertTime);
 }
 
-void World::loadItems()
+void World::loadItems(const WarmSnapshot& savedData, ThreadPool& loadPool)
 {
-    auto loadItem = [&](ItemID itemID, const Uint8* itemDataBuffer,
-                        std::size_t dataSize) {
-        // Deserialize the item's data.
-        Item item{};
-        Deserialize::fromBuffer(itemDataBuffer, dataSize, item);
-
-        // Add the item to ItemData.
+    // Deserialize the items' data in parallel.
+    Timer timer{};
+    std::vector<Item> items{};
+    deserializeBlobs(
+        loadPool, savedData.getItemCount(),
+        [&](std::size_t index) { return savedData.getItem(index); }, items);
+    double deserializeTime{timer.getTime()};
+
+    // Add the items to ItemData, in order.
+    timer.reset();
+    for (const Item& item : items) {
         itemData.createItem(item);
-    };
+    }
+    double insertTime{timer.getTime()};
 
-    database->iterateItems(std::move(loadItem));
+    LOG_INFO("Loaded %zu items. Deserialize: %.6fs, insert: %.6fs",
+             items.size(), deserializeTime, insertTime);
 }
 
-void World::loadStoredValues()
+void World::loadStoredValues(const WarmSnapshot& savedData)
 {
     // Load the entity stored value IDs.
-    auto loadEntityMap = [&](const Uint8* dataBuffer, std::size_t dataSize) {
-        if (dataSize > 0) {
-            Deserialize::fromBuffer(dataBuffer, dataSize,
-                                    entityStoredValueIDMap);
-        }
-    };
-
-    database->getEntityStoredValueIDMap(std::move(loadEntityMap));
+    std::span<const Uint8> entityMapData{
+        savedData.getEntityStoredValueIDMap()};
+    if (entityMapData.size() > 0) {
+        Deserialize::fromBuffer(entityMapData.data(), entityMapData.size(),
+                                entityStoredValueIDMap);
+    }
 
-    // Load the global stored values.
-    auto loadGlobalMap = [&](const Uint8* dataBuffer, std::size_t dataSize) {
-        if (dataSize > 0) {
-            Deserialize::fromBuffer(dataBuffer, dataSize, globalStoredValueMap);
+    // Build the numeric ID -> string ID table.
+    entityStoredValueStringIDs.assign((entityStoredValueIDMap.size() + 1),
+                                      std::string_view{});
+    for (const auto& [stringID, numericID] : entityStoredValueIDMap) {
+        if (numericID >= entityStoredValueStringIDs.size()) {
+            entityStoredValueStringIDs.resize(numericID + 1);
         }
-    };
+        entityStoredValueStringIDs[numericID] = stringID;
+    }
 
-    database->getGlobalStoredValueMap(std::move(loadGlobalMap));
+    // Load the global stored values.
+    std::span<const Uint8> globalMapData{savedData.getGlobalStoredValueMap()};
+    if (globalMapData.size() > 0) {
+        Deserialize::fromBuffer(globalMapData.data(), globalMapData.size(),
+                                globalStoredValueMap);
+    }
 }
 
 } // namespace Server
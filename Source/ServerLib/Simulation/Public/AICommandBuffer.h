@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Input.h"
+#include "entt/entity/registry.hpp"
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace AM
+{
+namespace Server
+{
+class World;
+
+/**
+ * Records world changes that AI wants to make, so they can be applied later.
+ *
+ * Used by ParallelAILogic: AI that tick on worker threads can only read the
+ * world, so they push their changes into one of these instead. AISystem
+ * applies the buffers on the sim thread once every worker is done.
+ *
+ * Commands are applied in the order that they were added.
+ */
+class AICommandBuffer
+{
+public:
+    /**
+     * Sets the given entity's inputs.
+     * If the inputs are unchanged when applied, the Input component isn't
+     * touched (so we don't send a redundant movement update).
+     */
+    void setInputs(entt::entity entity, const Input::StateArr& inputStates);
+
+    /**
+     * Adds or replaces the given entity's component of type T.
+     * If the entity has been destroyed by the time this is applied, it's
+     * skipped.
+     */
+    template<typename T>
+    void replace(entt::entity entity, T component)
+    {
+        commands.emplace_back([entity, component{std::move(component)}](
+                                  World& world) mutable {
+            applyReplace(world, entity, std::move(component));
+        });
+    }
+
+    /**
+     * Adds an arbitrary change, e.g. sending a message or destroying an
+     * entity.
+     */
+    void defer(std::function<void(World&)> command);
+
+    /**
+     * Applies all of the recorded commands in order, then clears them.
+     */
+    void apply(World& world);
+
+    bool empty() const;
+
+private:
+    /**
+     * Applies a replace() command.
+     */
+    template<typename T>
+    static void applyReplace(World& world, entt::entity entity, T&& component)
+    {
+        entt::registry& registry{getRegistry(world)};
+        if (registry.valid(entity)) {
+            registry.emplace_or_replace<T>(entity, std::forward<T>(component));
+        }
+    }
+
+    /**
+     * Returns world.registry. Defined in the .cpp, so this header doesn't 
+     * need to include World.h.
+     */
+    static entt::registry& getRegistry(World& world);
+
+    /** The recorded commands, in the order that they were added. */
+    std::vector<std::function<void(World&)>> commands;
+};
+
+} // namespace Server
+} // namespace AM
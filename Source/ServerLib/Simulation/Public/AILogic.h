@@ -1,6 +1,8 @@
 #pragma once
 
+#include "Config.h"
 #include "entt/fwd.hpp"
+#include <SDL_stdinc.h>
 
 namespace AM
 {
@@ -10,6 +12,12 @@ class World;
 
 /**
  * Interface class for entity AI logic.
+ *
+ * AI doesn't necessarily tick every sim tick. AISystem ticks each AI at the 
+ * interval that it asks for, depending on whether a client is nearby, and 
+ * spreads the work over multiple sim ticks when there's more than 
+ * Config::AI_TICK_BUDGET to do. If your logic depends on elapsed time, 
+ * track it yourself instead of assuming a fixed timestep.
  */
 class AILogic
 {
@@ -25,6 +33,32 @@ public:
      * @param entity The entity that this AI is controlling.
      */
     virtual void tick(World& world, entt::entity entity) = 0;
+
+    /**
+     * Returns the number of sim ticks that should pass between this AI's 
+     * ticks, while a client is within AOI range of it.
+     */
+    virtual Uint32 getNearTickInterval() const
+    {
+        return 1;
+    }
+
+    /**
+     * Returns the number of sim ticks that should pass between this AI's 
+     * ticks, while no client is within AOI range of it.
+     *
+     * If 0, this AI will sleep until a client comes near.
+     */
+    virtual Uint32 getFarTickInterval() const
+    {
+        return Config::AI_FAR_TICK_INTERVAL;
+    }
+
+private:
+    friend class AISystem;
+
+    /** The AISystem tick number that this AI is next due on. */
+    Uint32 nextTickNumber{0};
 };
 
 } // namespace Server
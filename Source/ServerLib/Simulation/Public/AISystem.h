@@ -1,5 +1,10 @@
 #pragma once
 
+#include "AICommandBuffer.h"
+#include "entt/fwd.hpp"
+#include <SDL_stdinc.h>
+#include <vector>
+
 namespace AM
 {
 namespace Server
@@ -9,6 +14,18 @@ class World;
 
 /**
  * Handles AI processing.
+ *
+ * Each AI is ticked at the interval that it requests through AILogic, 
+ * which depends on whether a client is nearby. Far-away AI can run less 
+ * often, or sleep until a client approaches.
+ *
+ * At most Config::AI_TICK_BUDGET AI are ticked per sim tick. Any AI that 
+ * are due beyond the budget are ticked on the following sim ticks, picking 
+ * up where we left off so no AI gets starved.
+ *
+ * AI types that derive from ParallelAILogic are ticked in batches on a 
+ * thread pool, and their changes are applied afterwards. See 
+ * ParallelAILogic.h.
  */
 class AISystem
 {
@@ -16,13 +33,61 @@ public:
     AISystem(World& inWorld);
 
     /**
-     * Calls tick() on all AI components.
+     * Calls tick() on all AI components that are due.
      */
     void processAITick();
 
 private:
+    /**
+     * Ticks any due AI of the given type, starting after the last one that 
+     * we ticked.
+     *
+     * @param typeIndex The index of AIType within ProjectAITypes.
+     * @param[in,out] budget The number of AI that we may still tick this sim 
+     *                       tick.
+     */
+    template<typename AIType>
+    void processAIType(std::size_t typeIndex, std::size_t& budget);
+
+    /**
+     * Loads the chunks that the AI in parallelEntities may read, ticks them 
+     * on the thread pool, then applies their commands.
+     */
+    template<typename AIType>
+    void tickParallel();
+
+    /**
+     * Returns true if the given entity is within AOI range of any client.
+     * Entities with no Position are always considered near.
+     *
+     * Note: This uses the entity's AOIObservers, so it reflects the AOI 
+     *       lists from the end of the last sim tick.
+     */
+    bool isNearClient(entt::entity entity) const;
+
     /** Used to get AI components to process. */
     World& world;
+
+    /** The number of times that processAITick() has been called. */
+    Uint32 tickNumber;
+
+    /** The index of the AI type to start with on the next sim tick. Rotated 
+        so that no type starves the others of budget. */
+    std::size_t nextTypeIndex;
+
+    /** Per-AI type, the storage index to resume from on the next sim tick. */
+    std::vector<std::size_t> resumeIndices;
+
+    /** The entities of the AI type that's being processed. Copied out of 
+        the type's storage, since tick() may add or remove AI. */
+    std::vector<entt::entity> processEntities;
+
+    /** The due AI of the ParallelAILogic type that's being processed. */
+    std::vector<entt::entity> parallelEntities;
+
+    /** One command buffer per batch of parallel AI. Kept around so their 
+        storage gets reused. */
+    std::vector<AICommandBuffer> commandBuffers;
 };
 
 } // End namespace Server
@@ -4,6 +4,8 @@
 #include "QueuedEvents.h"
 #include "ChunkDataRequest.h"
 #include "ChunkPosition.h"
+#include "ChunkExtent.h"
+#include <deque>
 
 namespace AM
 {
@@ -23,6 +25,10 @@ class Network;
  * A client may require chunks to be sent when it logs in, moves into a new
  * chunk, or teleports.
  *
+ * Also maintains each client's chunk subscriptions (see ChunkSubscriptions).
+ * Clients are subscribed to the chunks that they request, and unsubscribed 
+ * from chunks that they move out of range of.
+ *
  * Note: We have no validation to see if client entities are in range of the
  *       requested chunks. Maybe add that once we get a permissions system.
  */
@@ -34,23 +40,50 @@ public:
     /**
      * Processes chunk update requests, sending chunk data if the request is
      * valid.
+     * At most Config::CHUNKS_SENT_PER_TICK chunks are sent per call.
      */
     void sendChunks();
 
+    /**
+     * Returns the extent of chunks that are in range of the given chunk.
+     * Note: This matches the client's ChunkUpdateSystem, which includes all 
+     *       directly surrounding chunks in the X/Y directions, and every 
+     *       chunk along the Z axis.
+     */
+    ChunkExtent getInRangeExtent(const ChunkPosition& chunkPosition) const;
+
 private:
     /**
-     * Send a chunk update, containing the chunks from the given request.
+     * Unsubscribes any clients that moved into a new chunk from the chunks 
+     * that they're no longer in range of.
      */
-    void sendChunkUpdate(const ChunkDataRequest& chunkDataRequest);
+    void updateSubscriptions();
+
+    /**
+     * Sends a chunk update containing the given request's chunks, starting 
+     * at nextRequestedChunkIndex. Stops after maxChunks chunks have been 
+     * added, and advances nextRequestedChunkIndex past the processed chunks.
+     * Subscribes the requesting client to each of the processed chunks.
+     *
+     * @return The number of chunk snapshots that were sent.
+     */
+    std::size_t sendChunkUpdate(const ChunkDataRequest& chunkDataRequest,
+                                std::size_t maxChunks);
 
     /**
      * Adds the given chunk to the given ChunkUpdate message.
      *
-     * @param chunkPosition  The position of the chunk to add.
+     * If the chunk's version matches the client's known version, only adds 
+     * it to the message's unchanged list. If the client has a stale version 
+     * of a chunk that's now empty, sends an empty snapshot so the client 
+     * knows to clear it.
+     *
+     * @param requestedChunk  The chunk to add.
      * @param chunkUpdate  The message struct to add the chunk to.
      */
-    void addChunkToMessage(const ChunkPosition& chunkPosition,
-                           ChunkUpdate& chunkUpdate);
+    void addChunkToMessage(
+        const ChunkDataRequest::RequestedChunk& requestedChunk,
+        ChunkUpdate& chunkUpdate);
 
     /** Used for fetching entity, component, and map data. */
     World& world;
@@ -58,6 +91,15 @@ private:
     Network& network;
 
     EventQueue<ChunkDataRequest> chunkDataRequestQueue;
+
+    /** Requests that we haven't finished sending yet. We only send 
+        Config::CHUNKS_SENT_PER_TICK chunks per tick, so large bursts of 
+        requests get spread across multiple ticks. */
+    std::deque<ChunkDataRequest> pendingRequests;
+
+    /** The index within the front request's requestedChunks of the next 
+        chunk to send. */
+    std::size_t nextRequestedChunkIndex;
 };
 
 } // End namespace Server
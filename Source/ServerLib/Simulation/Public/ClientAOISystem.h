@@ -15,7 +15,8 @@ struct ClientSimData;
 
 /**
  * Maintains each client entity's list of peers that are within their area of
- * interest.
+ * interest, along with each entity's AOIObservers (the reverse of those
+ * lists).
  *
  * When a peer enters a client entity's AOI, this system will update the lists
  * appropriately and send an EntityInit message to the client.
@@ -40,6 +41,8 @@ public:
     ClientAOISystem(Simulation& inSimulation, World& inWorld,
                     Network& inNetwork);
 
+    ~ClientAOISystem();
+
     /**
      * Updates the peersInAOI list in any client entities that have recently
      * moved.
@@ -50,17 +53,25 @@ public:
     void updateAOILists();
 
 private:
+    /**
+     * Removes the given client entity from the AOIObservers of every entity
+     * in its AOI.
+     */
+    void onClientDestroyed(entt::registry& registry, entt::entity entity);
+
     /**
      * Sends an EntityDelete message to the given client for each entity that
      * left its AOI.
      */
-    void processEntitiesThatLeft(ClientSimData& client);
+    void processEntitiesThatLeft(entt::entity clientEntity,
+                                 ClientSimData& client);
 
     /**
      * Sends an EntityInit message to the given client for each entity that
      * entered its AOI.
      */
-    void processEntitiesThatEntered(ClientSimData& client);
+    void processEntitiesThatEntered(entt::entity clientEntity,
+                                    ClientSimData& client);
 
     /** Used to get the current tick number. */
     Simulation& simulation;
@@ -4,7 +4,8 @@
 #include "ComponentUpdate.h"
 #include "entt/fwd.hpp"
 #include "entt/entity/registry.hpp"
-#include <unordered_map>
+#include <SDL_stdinc.h>
+#include <vector>
 
 namespace AM
 {
@@ -21,6 +22,11 @@ class GraphicData;
  *
  * When an observed component is updated, sends an update message to all nearby
  * clients.
+ *
+ * Each entity gets a bitmask of its observed components that have changed
+ * since the last send, and is added to a flat dirty list the first time one
+ * changes. Updates are only built for entities that have AOIObservers, and
+ * are sent straight to those clients.
  */
 class ComponentSyncSystem
 {
@@ -28,12 +34,27 @@ public:
     ComponentSyncSystem(Simulation& inSimulation, World& inWorld,
                         Network& inNetwork, GraphicData& inGraphicData);
 
+    ~ComponentSyncSystem();
+
     /**
      * Sends updates for any observed components that were modified.
      */
     void sendUpdates();
 
 private:
+    /**
+     * Marks the observed component at the given index in
+     * ObservedComponentTypes as dirty for the given entity.
+     */
+    template<std::size_t TypeIndex>
+    void onComponentChanged(entt::registry& registry, entt::entity entity);
+
+    /**
+     * Clears the given entity's dirty mask, so that a new entity that reuses
+     * its index gets added to dirtyEntities.
+     */
+    void onEntityDestroyed(entt::registry& registry, entt::entity entity);
+
     /** Used to get the current tick number. */
     Simulation& simulation;
     /** Used for fetching component data. */
@@ -46,12 +67,18 @@ private:
     // Note: Check the top of the cpp file for file-local types and variables.
     //       We keep some templated code there to reduce compile times.
 
-    // Note: To optimize, we could store indices into a vector<ComponentUpdate>.
-    //       Then we could re-use the vectors instead of re-allocating.
-    /** Maps entityID -> a ComponentUpdate message containing that entity's
-       data. We iterate the observers to detect changes, so this map lets us
-        iteratively build the update messages component-by-component. */
-    std::unordered_map<entt::entity, ComponentUpdate> componentUpdateMap;
+    /** Indexed by entity index (entt::to_entity()). Each entity's mask of
+        observed components that have changed, with bit N matching index N in
+        ObservedComponentTypes. */
+    std::vector<Uint64> dirtyMasks;
+
+    /** The entities with a non-zero dirty mask. May hold entities that were
+        destroyed after changing. */
+    std::vector<entt::entity> dirtyEntities;
+
+    /** The message that we build each update in. Kept around so its storage
+        gets reused. */
+    ComponentUpdate componentUpdate;
 };
 
 } // namespace Server
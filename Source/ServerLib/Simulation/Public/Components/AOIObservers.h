@@ -0,0 +1,26 @@
+#pragma once
+
+#include "entt/fwd.hpp"
+#include <vector>
+
+namespace AM
+{
+namespace Server
+{
+/**
+ * The client entities that have this entity in their AOI.
+ *
+ * This is the reverse of ClientSimData::entitiesInAOI, maintained by
+ * ClientAOISystem. Lets systems that send updates about an entity go
+ * straight to the clients that care about it.
+ *
+ * Note: The vector is kept (even if empty) while the entity is alive, so
+ *       that entities moving in and out of AOIs don't cause allocations.
+ */
+struct AOIObservers {
+    /** The observing client entities, in no particular order. */
+    std::vector<entt::entity> clientEntities{};
+};
+
+} // namespace Server
+} // namespace AM
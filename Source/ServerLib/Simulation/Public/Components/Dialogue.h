@@ -1,6 +1,7 @@
 #pragma once
 
 #include "bitsery/ext/std_map.h"
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -16,6 +17,10 @@ namespace Server
  * When a client requests to begin a dialogue with an entity, the server sends 
  * them the first topic in that entity's topics vector. The client can then 
  * request that a choice be selected, which may result in a new topic being sent.
+ *
+ * The topics themselves live in a Definition. Entities that were made with 
+ * the same init script share a single definition (see World::
+ * shareDialogue()), so hundreds of identical NPCs only hold one copy.
  */
 struct Dialogue {
     /** Used as a "we should never hit this" cap on the container lengths. */
@@ -42,6 +47,8 @@ struct Dialogue {
 
         /** The script to run if this choice is successfully selected. */
         std::string actionScript{};
+
+        bool operator==(const Choice&) const = default;
     };
 
     /**
@@ -58,19 +65,34 @@ struct Dialogue {
             Choices are added to this vector based on their order in the choice
             script. */
         std::vector<Choice> choices{};
+
+        bool operator==(const Topic&) const = default;
     };
 
-    /** A map of topic names -> their index in the topics vector. */
-    std::unordered_map<std::string, Uint8> topicIndices{};
-
-    /** The available dialogue topics.
-        Topics are added to this vector based on their order in the entity's 
-        init script. The first topic will be the one sent in response to the 
-        Talk interaction. The rest are only reachable using setNextTopic().
-        Note: There should always be at least 1 topic present, since we only 
-              construct the Dialogue component when we have a topic to add, and 
-              you can't remove topics. */
-    std::vector<Topic> topics{};
+    /**
+     * A dialogue tree's topics, as built by an init script.
+     */
+    struct Definition {
+        /** A map of topic names -> their index in the topics vector. */
+        std::unordered_map<std::string, Uint8> topicIndices{};
+
+        /** The available dialogue topics.
+            Topics are added to this vector based on their order in the 
+            entity's init script. The first topic will be the one sent in 
+            response to the Talk interaction. The rest are only reachable 
+            using setNextTopic().
+            Note: There should always be at least 1 topic present, since we 
+                  only construct the Dialogue component when we have a topic 
+                  to add, and you can't remove topics. */
+        std::vector<Topic> topics{};
+
+        bool operator==(const Definition&) const = default;
+    };
+
+    /** This entity's topics.
+        May be shared with other entities, so it must not be modified once 
+        the entity's init script has finished running. */
+    std::shared_ptr<Definition> definition{};
 };
 
 template<typename S>
@@ -92,15 +114,26 @@ void serialize(S& serializer, Dialogue::Topic& topic)
 }
 
 template<typename S>
-void serialize(S& serializer, Dialogue& dialogue)
+void serialize(S& serializer, Dialogue::Definition& definition)
 {
-    serializer.ext(dialogue.topicIndices,
+    serializer.ext(definition.topicIndices,
                    bitsery::ext::StdMap{Dialogue::MAX_TOPICS},
                    [](S& serializer, std::string& name, Uint8& index) {
                        serializer.text1b(name, Dialogue::MAX_TOPIC_NAME_LENGTH);
                        serializer.value1b(index);
                    });
-    serializer.container(dialogue.topics, Dialogue::MAX_TOPICS);
+    serializer.container(definition.topics, Dialogue::MAX_TOPICS);
+}
+
+template<typename S>
+void serialize(S& serializer, Dialogue& dialogue)
+{
+    // Note: Each deserialized component gets its own definition. World 
+    //       merges matching ones after loading.
+    if (!(dialogue.definition)) {
+        dialogue.definition = std::make_shared<Dialogue::Definition>();
+    }
+    serializer.object(*(dialogue.definition));
 }
 
 } // namespace Server
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "TilePosition.h"
+
+namespace AM
+{
+namespace Server
+{
+/**
+ * Asks PathfindingSystem for a path from this entity's current tile to the 
+ * given goal.
+ *
+ * PathfindingSystem removes this component when it takes the request, and 
+ * adds a PathResult once the path is found (usually during the same tick). 
+ * Replacing this component before then replaces the request.
+ */
+struct PathRequest {
+    TilePosition goal{};
+};
+
+} // namespace Server
+} // namespace AM
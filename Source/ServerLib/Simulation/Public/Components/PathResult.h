@@ -0,0 +1,39 @@
+#pragma once
+
+#include "TilePosition.h"
+#include <SDL_stdinc.h>
+#include <memory>
+#include <vector>
+
+namespace AM
+{
+namespace Server
+{
+/**
+ * The result of this entity's most recent PathRequest.
+ *
+ * To follow the path, steer towards the center of each tile in turn.
+ */
+struct PathResult {
+    enum class Status : Uint8 {
+        /** tiles holds a path to the goal. */
+        Found,
+        /** There's no path to the goal, or it's too far away. */
+        NotFound
+    };
+
+    /** The requested start tile. */
+    TilePosition start{};
+
+    /** The requested goal tile. */
+    TilePosition goal{};
+
+    Status status{Status::NotFound};
+
+    /** If found, the path's tiles, not including start but including goal.
+        Shared with PathfindingSystem's cache, so it's read-only. */
+    std::shared_ptr<const std::vector<TilePosition>> tiles{};
+};
+
+} // namespace Server
+} // namespace AM
@@ -1,15 +1,14 @@
 #pragma once
 
 #include "EntityStoredValueID.h"
-#include "bitsery/ext/std_map.h"
-#include <unordered_map>
-#include <string_view>
+#include <vector>
+#include <utility>
+#include <algorithm>
 
 namespace AM
 {
 namespace Server
 {
-class World;
 
 /**
  * A per-entity key-value store.
@@ -25,12 +24,16 @@ struct StoredValues {
         component can hold. */
     static constexpr std::size_t MAX_STORED_VALUES{SDL_MAX_UINT16};
 
+    /** A numeric ID -> value pair. */
+    using ValuePair = std::pair<EntityStoredValueID, Uint32>;
+
     /**
-     * Holds the entity's stored values.
+     * Holds the entity's stored values, sorted by numeric ID.
      *
-     * Maps numeric ID -> value.
+     * Entities typically only hold a handful of values, so a sorted vector 
+     * is both smaller and faster to search than a hash map.
      */
-    std::unordered_map<EntityStoredValueID, Uint32> valueMap{};
+    std::vector<ValuePair> values{};
 
     /**
      * Adds a new value, or overwrites an existing value.
@@ -40,12 +43,11 @@ struct StoredValues {
      * Note: Stored values are often cast to different types, but their 
      *       underlying type is always Uint32.
      *
-     * @param stringID The string ID of the value to add or overwrite.
+     * @param numericID The numeric ID of the value to add or overwrite. Must 
+     *                  not be null.
      * @param newValue The new value to use.
-     * @return True if the value was successfully set, else false (value with 
-     *         the given ID doesn't exist and value limit is reached).
      */
-    bool storeValue(std::string_view stringID, Uint32 newValue, World& world);
+    void storeValue(EntityStoredValueID numericID, Uint32 newValue);
 
     /**
      * Gets a stored value.
@@ -53,23 +55,30 @@ struct StoredValues {
      * Note: Stored values are often cast to different types, but their 
      *       underlying type is always Uint32.
      * 
-     * @param stringID The string ID of the value to get.
+     * @param numericID The numeric ID of the value to get.
      * @return The requested value. If not found, returns 0 (the default value 
      *         that the value would have if it existed).
      */
-    Uint32 getStoredValue(std::string_view stringID, World& world);
+    Uint32 getStoredValue(EntityStoredValueID numericID) const;
 };
 
 template<typename S>
 void serialize(S& serializer, StoredValues& storedValues)
 {
-    serializer.ext(
-        storedValues.valueMap,
-        bitsery::ext::StdMap{StoredValues::MAX_STORED_VALUES},
-        [](S& serializer, EntityStoredValueID& numericID, Uint32& value) {
-            serializer.value2b(numericID);
-            serializer.value4b(value);
+    // Note: This matches the layout that bitsery's StdMap used, so values 
+    //       that were saved as a map still load.
+    serializer.container(
+        storedValues.values, StoredValues::MAX_STORED_VALUES,
+        [](S& serializer, StoredValues::ValuePair& valuePair) {
+            serializer.value2b(valuePair.first);
+            serializer.value4b(valuePair.second);
         });
+
+    // Values that were saved as a map may be out of order.
+    if (!(std::is_sorted(storedValues.values.begin(),
+                         storedValues.values.end()))) {
+        std::sort(storedValues.values.begin(), storedValues.values.end());
+    }
 }
 
 } // namespace Server
@@ -6,6 +6,7 @@
 #include <SDL_stdinc.h>
 #include <optional>
 #include <memory>
+#include <string>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -21,18 +22,37 @@ class World;
  * Interface for interacting with the database.
  * 
  * We use the database to persist item definitions, non-client entity data, 
- * and tile map data as blobs.
+ * and tile map data as blobs. Entity and item blobs may be compressed (see 
+ * PersistedBlob.h), but this class doesn't look inside them.
  *
- * To avoid blocking the main loop, we first copy all of our data into an 
- * in-memory database. Then, we use a separate thread to backup the in-memory 
- * database to a file. See SaveSystem.h for more info.
+ * There are two storage modes (see StorageMode):
+ *   InMemory: We write into an in-memory database, then use a separate 
+ *             thread to backup the whole thing to a file. Each backup's cost 
+ *             grows with the size of the world.
+ *   WriteAheadLog: We write directly into the file database, in WAL mode. 
+ *                  Each save only writes the pages that changed, and a 
+ *                  separate thread periodically checkpoints the log into 
+ *                  the database file.
+ * In both modes, writes are expected to come from a single thread (see 
+ * SaveSystem.h).
  *
  * Note: Client entity data is persisted in the account database, not here.
  */
 class Database
 {
 public:
-    Database();
+    enum class StorageMode {
+        /** Write into an in-memory database, and back it up to the file. */
+        InMemory,
+        /** Write directly into the file, using a write-ahead log. */
+        WriteAheadLog
+    };
+
+    /**
+     * @param inStorageMode  How to store the database.
+     * @param filePath  The path to the database file.
+     */
+    Database(StorageMode inStorageMode, const std::string& filePath);
 
     ~Database();
 
@@ -49,12 +69,19 @@ public:
     void commitTransaction();
 
     /**
-     * Backs up our in-memory database to the file database.
+     * Makes sure the committed data ends up in the file database.
+     *
+     * In InMemory mode, backs up the in-memory database to the file database.
+     * In WriteAheadLog mode, the data is already in the file, but every 
+     * Config::DATABASE_CHECKPOINT_INTERVAL calls, this checkpoints the log 
+     * into the main database file.
+     * Either way, the work is done on a separate thread.
      */
     void backupToFile();
 
     /**
-     * @return true if a backup is currently being performed, else false.
+     * @return true if a backup or checkpoint is currently being performed, 
+     *         else false.
      */
     bool backupIsInProgress();
 
@@ -206,21 +233,37 @@ protected:
      */
     void initTables();
 
+    /**
+     * Sets the pragmas that WriteAheadLog mode needs on the given connection.
+     */
+    void initWriteAheadLog(SQLite::Database& connection);
+
     /**
      * Thread function.
      * Waits for backupToFile() to flag that a backup should begin.
      * 
-     * Backs up the in-memory database to the file database.
+     * Backs up the in-memory database to the file database (or checkpoints 
+     * the log, in WriteAheadLog mode).
      */
     void performBackup();
 
-    /** In-memory database. Used to gather our data so we can safely work 
-        with it in another thread. */
+    /** How we're storing the database. */
+    StorageMode storageMode;
+
+    /** The database that we write to.
+        In InMemory mode, this is an in-memory database. Used to gather our 
+        data so we can safely work with it in another thread.
+        In WriteAheadLog mode, this is a connection to the file database. */
     SQLite::Database database;
 
-    /** File database. Used to persist our data to a file. */
+    /** A connection to the file database. Used to load our data, and to 
+        persist it (either through backups or checkpoints). */
     SQLite::Database backupDatabase;
 
+    /** The number of times backupToFile() has been called since the last 
+        checkpoint. Only used in WriteAheadLog mode. */
+    unsigned int backupsSinceCheckpoint;
+
     /** If valid, this is the current ongoing transaction. */
     std::optional<SQLite::Transaction> currentTransaction;
 
@@ -58,8 +58,9 @@ private:
      * @return If the script contained a valid setNextTopic(), returns the next 
      *         topic. Else, returns nullptr.
      */
-    const Dialogue::Topic* runTopic(const Dialogue& dialogue,
+    const Dialogue::Topic* runTopic(const Dialogue::Definition& dialogue,
                                     const Dialogue::Topic& topic,
+                                    entt::entity targetEntity,
                                     NetworkID clientID);
 
     /**
@@ -74,20 +75,22 @@ private:
      * @return If the script contained a valid setNextTopic(), returns the next
      *         topic. Else, returns nullptr.
      */
-    const Dialogue::Topic* runChoice(const Dialogue& dialogue,
+    const Dialogue::Topic* runChoice(const Dialogue::Definition& dialogue,
                                      const Dialogue::Choice& choice,
                                      std::string_view choiceTopicName,
-                                     Uint8 choiceIndex, NetworkID clientID);
+                                     Uint8 choiceIndex,
+                                     entt::entity targetEntity,
+                                     NetworkID clientID);
 
     /**
      * Validates that the given request has valid data and that the choice's 
      * condition is satisfied by the client entity.
      *
      * @param clientEntity The entity associated with the request's netID.
-     * @return If valid, returns the the target entity's Dialogue component. 
+     * @return If valid, returns the the target entity's dialogue definition. 
      *         Else, returns nullptr and sends an appropriate error message.
      */
-    const Dialogue*
+    const Dialogue::Definition*
         validateChoiceRequest(const DialogueChoiceRequest& choiceRequest,
                               entt::entity clientEntity);
 
@@ -105,10 +105,11 @@ private:
      * @param clientID The client that initiated this interaction.
      * @param clientEntity The client's entity.
      * @param targetEntity The entity that the item is being used on.
+     * @param itemID The item that's being used.
      */
     void runEntityItemHandlerScript(
         NetworkID clientID, entt::entity clientEntity,
-        entt::entity targetEntity,
+        entt::entity targetEntity, ItemID itemID,
         const EntityItemHandlerScript& itemHandlerScript);
 
     /** Used for getting Examine interaction requests. */
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "LuaScriptCache.h"
 #include "sol/sol.hpp"
 #include "entt/fwd.hpp"
 
@@ -25,6 +26,9 @@ struct DialogueChoiceConditionLua {
           "GLOBAL": A constant used to identify the global value store. */
     sol::state luaState{};
 
+    /** Caches compiled condition scripts (including the "r=" prefix). */
+    LuaScriptCache scriptCache{luaState, "choice condition"};
+
     /** The network ID of the client that is controlling the dialogue. */
     NetworkID clientID{0};
 };
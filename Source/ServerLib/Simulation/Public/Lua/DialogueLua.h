@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DialogueEvent.h"
+#include "LuaScriptCache.h"
 #include "sol/sol.hpp"
 #include "entt/fwd.hpp"
 
@@ -24,6 +25,9 @@ struct DialogueLua {
           "GLOBAL": A constant used to identify the global value store. */
     sol::state luaState{};
 
+    /** Caches compiled topic and choice action scripts. */
+    LuaScriptCache scriptCache{luaState, "dialogue"};
+
     /** The network ID of the client that is controlling the dialogue. */
     NetworkID clientID{0};
 
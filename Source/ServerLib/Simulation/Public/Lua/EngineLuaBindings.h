@@ -2,6 +2,7 @@
 
 #include "ItemID.h"
 #include "Dialogue.h"
+#include "StoredValueKey.h"
 #include "entt/fwd.hpp"
 #include <SDL_stdinc.h>
 #include <string_view>
@@ -182,6 +183,13 @@ private:
     std::size_t getItemCount(entt::entity entityToCount,
                              std::string_view itemID, NetworkID clientID);
 
+    /**
+     * Returns the handle for the given entity stored value string ID, 
+     * creating one if it doesn't exist yet.
+     * See StoredValueKey for more info.
+     */
+    EntityStoredValueID getStoredValueHandle(std::string_view stringID);
+
     /**
      * Adds a new value, or overwrites an existing value.
      *
@@ -193,25 +201,21 @@ private:
      *
      * @param entity The entity to store the value to. If == entt::null, the 
      *               the value will be stored to the global store instead.
-     * @param stringID The string ID of the value to add or overwrite.
+     * @param key The string ID or handle of the value to add or overwrite.
      * @param newValue The new value to use.
      */
-    void storeUint(entt::entity entity, std::string_view stringID,
-                   Uint32 newValue);
-    void storeBool(entt::entity entity, std::string_view stringID,
-                   bool newValue);
-    void storeInt(entt::entity entity, std::string_view stringID, int newValue);
-    void storeFloat(entt::entity entity, std::string_view stringID,
-                    float newValue);
+    void storeUint(entt::entity entity, StoredValueKey key, Uint32 newValue);
+    void storeBool(entt::entity entity, StoredValueKey key, bool newValue);
+    void storeInt(entt::entity entity, StoredValueKey key, int newValue);
+    void storeFloat(entt::entity entity, StoredValueKey key, float newValue);
     /** @param newValue A time in seconds, since 0 UTC (Jan 1, 1970). */
-    void storeTime(entt::entity entity, std::string_view stringID,
-                   Uint32 newValue);
-    void storeBitSet(entt::entity entity, std::string_view stringID,
+    void storeTime(entt::entity entity, StoredValueKey key, Uint32 newValue);
+    void storeBitSet(entt::entity entity, StoredValueKey key,
                      Uint32 newValue);
     /** @param bitToSet The bit to set, within the 32-bit stored value. Must be
                         within the range [0, 31]. */
-    void storeBit(entt::entity entity, std::string_view stringID,
-                  Uint8 bitToSet, bool newValue);
+    void storeBit(entt::entity entity, StoredValueKey key, Uint8 bitToSet,
+                  bool newValue);
 
     /**
      * Gets a stored value.
@@ -222,20 +226,20 @@ private:
      *
      * @param entity The entity to get the value from. If == entt::null, the 
      *               the value will be retrieved from the global store instead.
-     * @param stringID The string ID of the value to get.
+     * @param key The string ID or handle of the value to get.
      * @return The requested value. If not found, returns 0 (the default value 
      *         that the flag would have if it existed).
      */
-    Uint32 getStoredUint(entt::entity entity, std::string_view stringID);
-    bool getStoredBool(entt::entity entity, std::string_view stringID);
-    int getStoredInt(entt::entity entity, std::string_view stringID);
-    float getStoredFloat(entt::entity entity, std::string_view stringID);
+    Uint32 getStoredUint(entt::entity entity, StoredValueKey key);
+    bool getStoredBool(entt::entity entity, StoredValueKey key);
+    int getStoredInt(entt::entity entity, StoredValueKey key);
+    float getStoredFloat(entt::entity entity, StoredValueKey key);
     /** @return A time in seconds, since 0 UTC (Jan 1, 1970). */
-    Uint32 getStoredTime(entt::entity entity, std::string_view stringID);
-    Uint32 getStoredBitSet(entt::entity entity, std::string_view stringID);
+    Uint32 getStoredTime(entt::entity entity, StoredValueKey key);
+    Uint32 getStoredBitSet(entt::entity entity, StoredValueKey key);
     /** @param bitToGet The bit to get, within the 32-bit stored value. Must be
                         within the range [0, 31]. */
-    bool getStoredBit(entt::entity entity, std::string_view stringID,
+    bool getStoredBit(entt::entity entity, StoredValueKey key,
                       Uint8 bitToGet);
 
     /**
@@ -264,6 +268,29 @@ private:
      */
     void sendSystemMessage(std::string_view message, NetworkID clientID);
 
+    /**
+     * Returns the entity stored value numeric ID that the given key refers 
+     * to.
+     * @throws std::runtime_error if the key is invalid or the value limit is 
+     *         reached.
+     */
+    EntityStoredValueID getEntityStoredValueID(const StoredValueKey& key);
+
+    /**
+     * Returns the entity stored value numeric ID that the given key refers 
+     * to, without adding it if it doesn't exist yet. Used when reading 
+     * values, so reads of unset values don't use up IDs.
+     * @return If the key's string ID hasn't been added, returns null.
+     * @throws std::runtime_error if the key is an invalid handle.
+     */
+    EntityStoredValueID findEntityStoredValueID(const StoredValueKey& key);
+
+    /**
+     * Returns the global stored value string ID that the given key refers to.
+     * @throws std::runtime_error if the key is an invalid handle.
+     */
+    std::string_view getGlobalStoredValueID(const StoredValueKey& key);
+
     EntityInitLua& entityInitLua;
     EntityItemHandlerLua& entityItemHandlerLua;
     ItemInitLua& itemInitLua;
@@ -278,7 +305,7 @@ private:
     std::unique_ptr<sol::state> dialogueChoiceLua;
 
     /** If we're in the middle of running a dialogue choice script, this holds 
-        the topic from the entity's Dialogue::topics that we're currently 
+        the topic from the entity's dialogue definition that we're currently 
         adding to. */
     Dialogue::Topic* currentDialogueTopic;
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "LuaScriptCache.h"
 #include "sol/sol.hpp"
 #include "entt/fwd.hpp"
 
@@ -17,6 +18,10 @@ struct EntityInitLua {
     /** Lua environment for entity init script processing. */
     sol::state luaState{};
 
+    /** Caches compiled init scripts, so entities that share a script only 
+        compile it once. */
+    LuaScriptCache scriptCache{luaState, "entity init"};
+
     /** The entity that the init script is being ran on. */
     entt::entity selfEntity{};
 };
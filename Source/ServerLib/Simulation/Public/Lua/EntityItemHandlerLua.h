@@ -1,6 +1,7 @@
 #pragma once
 
 #include "NetworkDefs.h"
+#include "LuaScriptCache.h"
 #include "sol/sol.hpp"
 #include "entt/fwd.hpp"
 
@@ -23,6 +24,9 @@ struct EntityItemHandlerLua {
           "GLOBAL": A constant used to identify the global value store. */
     sol::state luaState{};
 
+    /** Caches compiled item handler scripts. */
+    LuaScriptCache scriptCache{luaState, "item handler"};
+
     /** The network ID of the client that used the item. */
     NetworkID clientID{0};
 };
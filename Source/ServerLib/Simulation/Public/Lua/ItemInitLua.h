@@ -1,5 +1,6 @@
 #pragma once
 
+#include "LuaScriptCache.h"
 #include "sol/sol.hpp"
 #include "entt/fwd.hpp"
 
@@ -20,6 +21,9 @@ struct ItemInitLua {
     /** Lua environment for item init script processing. */
     sol::state luaState{};
 
+    /** Caches compiled init scripts. */
+    LuaScriptCache scriptCache{luaState, "item init"};
+
     /** The item that the init script is being ran on.
         Will always be non-nullptr. */
     Item* selfItem{};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "HashTools.h"
+#include "Timer.h"
+#include "sol/sol.hpp"
+#include "entt/entity/entity.hpp"
+#include <SDL_stdinc.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace AM
+{
+namespace Server
+{
+/**
+ * Caches compiled Lua scripts, so that scripts which run often (dialogue 
+ * topics, item handlers, etc) only pay to be parsed and compiled once.
+ *
+ * Scripts are keyed by their full source text, so an edited script is 
+ * simply a new entry. If the cache grows past Config::LUA_SCRIPT_CACHE_SIZE, 
+ * it's cleared and scripts are compiled again as they're used.
+ *
+ * Each cache belongs to a single sol::state, since compiled functions can't 
+ * be shared between states.
+ *
+ * Also keeps per-script cost stats, and aborts any script that runs for more
+ * than Config::LUA_SCRIPT_INSTRUCTION_BUDGET instructions. Scripts run on the
+ * sim thread, so a runaway one would otherwise stall the whole tick.
+ */
+class LuaScriptCache
+{
+public:
+    /**
+     * Identifies where a script came from, for stats purposes.
+     * Stats are aggregated per unique (type, name, entity).
+     */
+    struct ScriptSource {
+        /** What kind of script this is, e.g. "Topic". */
+        std::string_view type{};
+
+        /** The name of the script's owner, e.g. a topic name or item string
+            ID. May be empty. */
+        std::string_view name{};
+
+        /** The entity that the script is running on. May be null. */
+        entt::entity entity{entt::null};
+    };
+
+    /**
+     * The cost of all of a script's runs since the stats were last cleared.
+     */
+    struct ScriptStats {
+        Uint32 callCount{0};
+
+        /** How many runs failed, including budget aborts. */
+        Uint32 errorCount{0};
+
+        double totalTimeS{0};
+
+        double maxTimeS{0};
+    };
+
+    /**
+     * @param inEnvironmentName The name of the owning Lua environment. Used
+     *                          when logging stats.
+     */
+    LuaScriptCache(sol::state& inLuaState, std::string_view inEnvironmentName);
+
+    /**
+     * Runs the given script, compiling it first if it isn't in the cache.
+     *
+     * Like sol::state::script() with sol::script_pass_on_error: if the script 
+     * fails to compile or run, the returned result will be invalid and hold 
+     * the error. A script that goes over the instruction budget fails with
+     * an error saying so.
+     */
+    sol::protected_function_result run(std::string_view script,
+                                       const ScriptSource& source);
+
+    /**
+     * Returns the stats of every script that has ran since the stats were
+     * last cleared, keyed by a label built from its ScriptSource.
+     */
+    const std::unordered_map<std::string, ScriptStats, string_hash,
+                             std::equal_to<>>&
+        getScriptStats() const;
+
+    /**
+     * Logs the Config::LUA_SCRIPT_STATS_LOG_COUNT scripts with the highest
+     * total time, then clears the stats.
+     */
+    void logHotScripts();
+
+    void clearScriptStats();
+
+private:
+    /**
+     * Lua count hook. Aborts the running script.
+     */
+    static void onInstructionBudgetExceeded(lua_State* state, lua_Debug*);
+
+    /**
+     * Adds the given run to source's stats.
+     */
+    void recordRun(const ScriptSource& source, double timeS, bool failed);
+
+    /** The state that our scripts are compiled in and ran on. */
+    sol::state& luaState;
+
+    /** The name of the owning Lua environment. */
+    std::string_view environmentName;
+
+    /** The compiled scripts, keyed by their source text. */
+    std::unordered_map<std::string, sol::protected_function, string_hash,
+                       std::equal_to<>>
+        compiledScripts;
+
+    /** Each script's stats, keyed by a label built from its ScriptSource. */
+    std::unordered_map<std::string, ScriptStats, string_hash,
+                       std::equal_to<>>
+        scriptStats;
+
+    /** Times each run. */
+    Timer runTimer;
+
+    /** Scratch string for building stats labels. */
+    std::string workLabel;
+};
+
+} // namespace Server
+} // namespace AM
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "EntityStoredValueID.h"
+#include <string_view>
+
+namespace AM
+{
+namespace Server
+{
+/**
+ * Identifies a stored value in the store*() and getStored*() Lua bindings.
+ *
+ * Scripts can pass either a string ID, or a handle from 
+ * getStoredValueHandle(). A handle is the value's interned numeric ID, so 
+ * using one skips the string ID lookup. Handles never change while the 
+ * server is running, so a script that touches the same value many times 
+ * should get its handle once and reuse it.
+ *
+ * Note: Lua values are converted to this type by the sol2 customization 
+ *       points in EngineLuaBindings.cpp.
+ */
+struct StoredValueKey {
+    /** The value's string ID. If empty, handle is used instead. */
+    std::string_view stringID{};
+
+    /** The value's handle. Only used if stringID is empty. */
+    EntityStoredValueID handle{NULL_ENTITY_STORED_VALUE_ID};
+};
+
+} // namespace Server
+} // namespace AM
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "AILogic.h"
+#include "AICommandBuffer.h"
+
+namespace AM
+{
+namespace Server
+{
+/**
+ * Base class for AI logic that can be ticked on worker threads.
+ *
+ * AISystem gathers the due AI of each ParallelAILogic type and ticks them
+ * in batches across a thread pool. While ticking, an AI may only read the
+ * world and modify its own members. Any world changes must be pushed into
+ * the given command buffer, which AISystem applies on the sim thread after
+ * every batch is done.
+ *
+ * Buffers are applied in the same order that the AI would've been ticked
+ * serially, so results don't depend on thread timing. The trade-off is that
+ * AI in the same pass don't see each other's changes.
+ *
+ * Note: Only use const World access (e.g. registry views and get()).
+ *       EntityLocator's reference-returning queries share a result vector,
+ *       so use the overloads that take an output vector instead.
+ * Note: The tile map's const getters never load chunks, so chunks that
+ *       haven't been loaded read as empty. Before each pass, AISystem loads
+ *       the chunks within getTileReadRange() of each AI's position.
+ */
+class ParallelAILogic : public AILogic
+{
+public:
+    /**
+     * Processes one iteration of AI logic, possibly on a worker thread.
+     *
+     * @param entity The entity that this AI is controlling.
+     * @param commands The buffer to push world changes into.
+     */
+    virtual void tickParallel(const World& world, entt::entity entity,
+                              AICommandBuffer& commands)
+        = 0;
+
+    /**
+     * Returns how far from its position, in tiles along each axis, this AI
+     * may read the tile map during tickParallel(). Reads are also allowed 1
+     * tile above and below, to match tile collision checks.
+     *
+     * If 0, this AI doesn't read tiles and no chunks are loaded for it.
+     */
+    virtual int getTileReadRange() const
+    {
+        return 0;
+    }
+
+    /**
+     * Runs tickParallel() and immediately applies its commands.
+     * AISystem doesn't call this, but it lets parallel AI be driven serially
+     * (e.g. in tests).
+     */
+    void tick(World& world, entt::entity entity) final
+    {
+        AICommandBuffer commands{};
+        tickParallel(world, entity, commands);
+        commands.apply(world);
+    }
+};
+
+} // namespace Server
+} // namespace AM
@@ -0,0 +1,186 @@
+#pragma once
+
+#include "ChunkPosition.h"
+#include "ChunkExtent.h"
+#include "TilePosition.h"
+#include "BoundingBox.h"
+#include "SharedConfig.h"
+#include <SDL_stdinc.h>
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+namespace AM
+{
+class TileMapBase;
+
+namespace Server
+{
+/**
+ * A hierarchical navigation graph over the tile map, used for pathfinding.
+ *
+ * Each chunk gets a NavChunk, which holds the tiles that an agent (a box of
+ * Config::PATHFINDING_AGENT_WIDTH/HEIGHT, standing at the tile's center) can
+ * move between, based on the tiles' collision volumes. Along each chunk
+ * edge, each run of tiles that can be crossed gets one or two "portals",
+ * and the cost between each pair of the chunk's portals is precomputed.
+ * findPath() runs A* over the portals, then refines each leg with a search
+ * inside a single chunk (i.e. HPA*).
+ *
+ * Paths are planar: they stay on the start's Z level. Tiles are connected
+ * in 8 directions, but diagonal moves can't cut corners. Raised terrain
+ * counts as an obstacle, and entities aren't considered.
+ *
+ * NavChunks are built on demand by ensureBuilt() and thrown out by
+ * invalidate() when nearby collision changes. findPath() only reads, so it
+ * can be called from multiple threads at once, as long as nothing is
+ * building or invalidating.
+ */
+class NavGraph
+{
+public:
+    NavGraph(TileMapBase& inTileMap);
+
+    /**
+     * Builds a NavChunk for each chunk in the given extent that doesn't
+     * already have one.
+     *
+     * Note: This loads any chunks that the nav data depends on, so only call
+     *       it from the sim thread.
+     */
+    void ensureBuilt(const ChunkExtent& extent);
+
+    /**
+     * Throws out the NavChunks that depend on the given chunk's collision
+     * (its own, and its neighbors'). They'll be rebuilt when next needed.
+     */
+    void invalidate(const ChunkPosition& chunkPosition);
+
+    /**
+     * Throws out all NavChunks.
+     */
+    void clear();
+
+    /**
+     * Finds a path from start to goal that only passes through chunks within
+     * the given extent.
+     *
+     * Every chunk in searchExtent must have been passed to ensureBuilt().
+     *
+     * @param[out] outPath  Filled with the path's tiles, not including start
+     *                      but including goal.
+     * @return true if a path was found, else false.
+     */
+    bool findPath(const TilePosition& start, const TilePosition& goal,
+                  const ChunkExtent& searchExtent,
+                  std::vector<TilePosition>& outPath) const;
+
+private:
+    static constexpr int CHUNK_WIDTH{
+        static_cast<int>(SharedConfig::CHUNK_WIDTH)};
+    static constexpr int CHUNK_TILE_COUNT{CHUNK_WIDTH * CHUNK_WIDTH};
+
+    /** Runs of crossable edge tiles longer than this get a portal at each
+        end, instead of one in the middle. */
+    static constexpr int PORTAL_SPLIT_LENGTH{6};
+
+    /** The directions that an agent can move out of a tile in. */
+    enum Direction : Uint8 {
+        PosX = 1 << 0,
+        NegX = 1 << 1,
+        PosY = 1 << 2,
+        NegY = 1 << 3
+    };
+
+    /** A tile on a chunk's edge, that agents can cross into a neighboring
+        chunk through. */
+    struct Portal {
+        /** The portal's tile index within its chunk. */
+        Uint16 tileIndex{0};
+
+        /** The Direction bits that this portal crosses into neighbors
+            through. A corner tile may cross in two directions. */
+        Uint8 crossings{0};
+    };
+
+    struct NavChunk {
+        /** Per tile, the Direction bits that an agent can move in. Includes
+            moves into neighboring chunks.
+            Tiles are indexed by (y * CHUNK_WIDTH + x), relative to the
+            chunk's origin. */
+        std::array<Uint8, CHUNK_TILE_COUNT> moves{};
+
+        std::vector<Portal> portals{};
+
+        /** Per tile, the index of its portal in portals, or -1. */
+        std::array<Sint16, CHUNK_TILE_COUNT> portalIndices{};
+
+        /** The cost of moving between each pair of portals within this
+            chunk, indexed by (from * portals.size() + to). Infinite if
+            there's no way through. */
+        std::vector<float> portalCosts{};
+    };
+
+    /** The results of a search within a single chunk. */
+    struct ChunkSearch {
+        /** Per tile, the cost to reach it. Infinite if unreachable. */
+        std::array<float, CHUNK_TILE_COUNT> costs{};
+
+        /** Per tile, the tile that it was reached from. */
+        std::array<Uint16, CHUNK_TILE_COUNT> parents{};
+    };
+
+    /**
+     * Builds the given chunk's nav data from the tile map.
+     */
+    void buildNavChunk(const ChunkPosition& chunkPosition,
+                       NavChunk& navChunk);
+
+    /**
+     * Adds portals for each run of tiles along one of the given chunk's
+     * edges that can be crossed in the given direction.
+     *
+     * @param firstTile  The index of the edge's first tile.
+     * @param tileStride  The index offset between each of the edge's tiles.
+     */
+    static void addEdgePortals(NavChunk& navChunk, Direction direction,
+                               int firstTile, int tileStride);
+
+    /**
+     * Returns the bounds that an agent standing at the given tile occupies.
+     */
+    static BoundingBox getAgentBounds(const TilePosition& tilePosition);
+
+    /**
+     * Returns true if an agent can move between the two given adjacent
+     * tiles.
+     */
+    bool canCross(const TilePosition& from, const TilePosition& to) const;
+
+    /**
+     * Runs Dijkstra within the given chunk, starting at startTile.
+     * If goalTile isn't -1, stops once it's reached.
+     */
+    static void searchChunk(const NavChunk& navChunk, int startTile,
+                            int goalTile, ChunkSearch& outSearch);
+
+    /**
+     * Appends the tiles along the path from startTile to goalTile within the
+     * given chunk, not including startTile.
+     *
+     * @return false if there's no path.
+     */
+    static bool appendChunkPath(const NavChunk& navChunk,
+                                const TilePosition& chunkOrigin,
+                                int startTile, int goalTile,
+                                std::vector<TilePosition>& outPath);
+
+    /** Used to find tile collision. */
+    TileMapBase& tileMap;
+
+    /** The nav data of each chunk that's been built. */
+    std::unordered_map<ChunkPosition, NavChunk> navChunks;
+};
+
+} // End namespace Server
+} // End namespace AM
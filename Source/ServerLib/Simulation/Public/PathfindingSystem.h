@@ -0,0 +1,113 @@
+#pragma once
+
+#include "NavGraph.h"
+#include "TilePosition.h"
+#include "ChunkPosition.h"
+#include "ChunkExtent.h"
+#include "entt/entity/entity.hpp"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace AM
+{
+namespace Server
+{
+class World;
+
+/**
+ * Finds paths for entities that have a PathRequest, and gives them a
+ * PathResult.
+ *
+ * Each tick, up to Config::PATHFINDING_REQUESTS_PER_TICK requests are
+ * taken. Requests that hit the path cache are answered right away. The rest
+ * have their search area's nav data built, then are searched in parallel on
+ * a thread pool.
+ *
+ * Nav data and cached paths are thrown out when the tile map reports that a
+ * chunk's collision changed, so paths don't lead through new walls. Paths
+ * that got shorter (e.g. because a wall was removed elsewhere) aren't
+ * noticed until they fall out of the cache.
+ */
+class PathfindingSystem
+{
+public:
+    PathfindingSystem(World& inWorld);
+
+    /**
+     * Processes waiting path requests.
+     */
+    void processPathRequests();
+
+private:
+    struct PathKey {
+        TilePosition start{};
+        TilePosition goal{};
+
+        bool operator==(const PathKey& other) const = default;
+    };
+
+    struct PathKeyHash {
+        std::size_t operator()(const PathKey& pathKey) const;
+    };
+
+    struct CachedPath {
+        std::shared_ptr<const std::vector<TilePosition>> tiles{};
+
+        /** The chunks that the path passes through. */
+        std::vector<ChunkPosition> chunks{};
+    };
+
+    /** A request that we're processing this tick. */
+    struct PathJob {
+        entt::entity entity{entt::null};
+
+        PathKey key{};
+
+        /** The extent to search through, if the path wasn't cached. */
+        ChunkExtent searchExtent{};
+
+        /** The search's result. */
+        bool wasFound{false};
+        std::vector<TilePosition> path{};
+
+        /** The path to give the requester. Null if none was found. */
+        std::shared_ptr<const std::vector<TilePosition>> tiles{};
+    };
+
+    /**
+     * Throws out the nav data and cached paths that are affected by the tile
+     * map's collision changes.
+     */
+    void processCollisionChanges();
+
+    /**
+     * Returns the extent that a path for the given key may search through.
+     */
+    ChunkExtent getSearchExtent(const PathKey& key) const;
+
+    /**
+     * Adds the given path to the cache.
+     */
+    void cachePath(
+        const PathKey& key,
+        const std::shared_ptr<const std::vector<TilePosition>>& tiles);
+
+    /** Used to get requests and the tile map. */
+    World& world;
+
+    /** The tile map's nav data. */
+    NavGraph navGraph;
+
+    /** Recently found paths. */
+    std::unordered_map<PathKey, CachedPath, PathKeyHash> pathCache;
+
+    /** This tick's requests. Kept around so their storage gets reused. */
+    std::vector<PathJob> jobs;
+
+    /** The indices within jobs of the jobs that need to be searched. */
+    std::vector<std::size_t> searchJobIndices;
+};
+
+} // End namespace Server
+} // End namespace AM
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "BinaryBuffer.h"
+#include <SDL_stdinc.h>
+#include <span>
+
+namespace AM
+{
+namespace Server
+{
+
+/**
+ * Encodes and decodes the serialized data blobs that we store in the 
+ * database (entities and items).
+ *
+ * If Config::COMPRESS_PERSISTED_BLOBS is true, blobs are LZ4-compressed 
+ * and prefixed with a small header:
+ *   Uint8[4] magic (0xFF), Uint8 format, Uint32 uncompressed size
+ *
+ * Blobs without the header are plain serialized data, so rows that were 
+ * written before compression was enabled can still be read.
+ * Note: The magic can't start a plain blob. For entities, it reads as 
+ *       entt::null. For items, it would be an impossibly long name.
+ */
+class PersistedBlob
+{
+public:
+    /** The size, in bytes, of a compressed blob's header. */
+    static constexpr std::size_t HEADER_SIZE{9};
+
+    /**
+     * Writes the given serialized data into outputBuffer, compressing it if 
+     * Config::COMPRESS_PERSISTED_BLOBS is true.
+     *
+     * If compression wouldn't make the blob smaller, writes the data as-is.
+     */
+    static void encode(const Uint8* data, std::size_t dataSize,
+                       BinaryBuffer& outputBuffer);
+
+    /**
+     * Returns the serialized data that the given blob holds.
+     *
+     * If the blob is compressed, it's decompressed into decodeBuffer and the 
+     * returned span points into it. Otherwise, the returned span points to 
+     * the given blob.
+     */
+    static std::span<const Uint8> decode(const Uint8* blob,
+                                         std::size_t blobSize,
+                                         BinaryBuffer& decodeBuffer);
+
+private:
+    /** The formats that a blob with a header may be in. */
+    enum class Format : Uint8 {
+        LZ4 = 1
+    };
+
+    /** The value of each magic byte. */
+    static constexpr Uint8 MAGIC_BYTE{0xFF};
+
+    /** The number of magic bytes at the start of the header. */
+    static constexpr std::size_t MAGIC_SIZE{4};
+};
+
+} // End namespace Server
+} // End namespace AM
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "PersistedEntityData.h"
+#include "Item.h"
+#include "EntityStoredValueIDMap.h"
+#include "GlobalStoredValueMap.h"
+#include "entt/entity/entity.hpp"
+#include <vector>
+
+namespace AM
+{
+namespace Server
+{
+
+/**
+ * A copy of all of the data that a single save needs to write to the
+ * database.
+ *
+ * SaveSystem captures these on the simulation thread, then hands them to its
+ * save thread to be serialized and committed.
+ */
+struct SaveSnapshot {
+    /** The entities that changed since the last save. */
+    std::vector<PersistedEntityData> entities{};
+
+    /** The entities that were destroyed since the last save. */
+    std::vector<entt::entity> destroyedEntities{};
+
+    /** The items that were created or updated since the last save. */
+    std::vector<Item> items{};
+
+    /** Copies of World::entityStoredValueIDMap and
+        World::globalStoredValueMap. */
+    EntityStoredValueIDMap entityStoredValueIDMap{};
+    GlobalStoredValueMap globalStoredValueMap{};
+
+    /** If true, this snapshot holds all of the world's entities and items, 
+        and should also be written to a warm snapshot. */
+    bool isWarmSnapshot{false};
+
+    /**
+     * Clears all of this snapshot's data, keeping the allocations.
+     */
+    void clear()
+    {
+        entities.clear();
+        destroyedEntities.clear();
+        items.clear();
+        entityStoredValueIDMap.clear();
+        globalStoredValueMap.clear();
+        isWarmSnapshot = false;
+    }
+};
+
+} // End namespace Server
+} // End namespace AM
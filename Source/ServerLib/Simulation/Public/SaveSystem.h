@@ -3,7 +3,14 @@
 #include "ItemID.h"
 #include "Timer.h"
 #include "BinaryBuffer.h"
+#include "SaveSnapshot.h"
+#include "WarmSnapshot.h"
+#include "entt/fwd.hpp"
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 namespace AM
 {
@@ -17,6 +24,25 @@ class World;
  *   Tile map data is saved to TileMap.bin.
  *   Non-client entity data is saved to the database.
  *   Item data is saved to the database.
+ *
+ * Entity saves are incremental: we observe each persisted component type and
+ * only save the entities that had a component added, updated, or removed
+ * since the last save.
+ * Note: Observers only see changes made through emplace/patch/replace. Code
+ *       that modifies a persisted component in place must call
+ *       registry.patch() afterwards, or the change won't be saved until the
+ *       next full save (see Config::FULL_ENTITY_SAVE_INTERVAL).
+ *
+ * To keep saves from hitching the simulation, the sim thread only copies the
+ * changed data into a SaveSnapshot. A separate save thread then serializes
+ * the snapshot, commits it to the in-memory database, and kicks off the
+ * backup to the file database. If the previous save is still in flight when
+ * the next one is due, the next one waits.
+ *
+ * A warm snapshot (see WarmSnapshot.h) can be requested before a restart. 
+ * The next tick does a full save, and the same data is written to 
+ * WorldSnapshot.bin once the database file is up to date. Any later save 
+ * deletes the snapshot, since it would no longer match the database.
  */
 class SaveSystem
 {
@@ -24,12 +50,26 @@ public:
     SaveSystem(World& inWorld);
 
     /**
-     * If data is due for saving, saves it.
+     * Waits for any in-flight save to finish.
+     */
+    ~SaveSystem();
+
+    /**
+     * If data is due for saving, captures a snapshot of it and hands it to
+     * the save thread.
      *
      * Configure through Config::SAVE_PERIOD.
      */
     void saveIfNecessary();
 
+    /**
+     * Requests that the next tick does a full save and writes a warm 
+     * snapshot.
+     *
+     * Thread-safe.
+     */
+    void requestWarmSnapshot();
+
 private:
     /**
      * Adds the given item to updatedItems.
@@ -37,20 +77,54 @@ private:
     void itemUpdated(ItemID itemID);
 
     /**
-     * Saves non-client entities to the in-memory database.
+     * Adds the given entity to entitiesWithRemovedComponents.
+     */
+    void persistedComponentRemoved(entt::registry& registry,
+                                   entt::entity entity);
+
+    /**
+     * Adds the given entity to destroyedEntities.
+     */
+    void entityDestroyed(entt::registry& registry, entt::entity entity);
+
+    /**
+     * Copies any non-client entities that changed since the last save into
+     * the snapshot.
+     */
+    void captureDirtyNonClientEntities(SaveSnapshot& snapshot);
+
+    /**
+     * Copies all non-client entities into the snapshot.
+     */
+    void captureAllNonClientEntities(SaveSnapshot& snapshot);
+
+    /**
+     * Copies the given entity's persisted components into the snapshot.
      */
-    void saveNonClientEntities();
+    void captureEntity(entt::entity entity, SaveSnapshot& snapshot);
 
     /**
-     * Saves items to the in-memory database.
+     * Copies any items that were updated since the last save into the
+     * snapshot.
      */
-    void saveItems();
+    void captureItems(SaveSnapshot& snapshot);
 
     /**
-     * Saves World::storedValueIDMap and World::globalStoredValueMap to the 
-     * in-memory database.
+     * Copies all items into the snapshot.
      */
-    void saveStoredValues();
+    void captureAllItems(SaveSnapshot& snapshot);
+
+    /**
+     * Thread function.
+     * Waits for saveIfNecessary() to hand over a snapshot, then writes it.
+     */
+    void saveThread();
+
+    /**
+     * Serializes the given snapshot's data and commits it to the in-memory
+     * database, then starts a backup to the file database.
+     */
+    void writeSnapshot(SaveSnapshot& snapshot);
 
     World& world;
 
@@ -58,11 +132,54 @@ private:
         Used to know which items need to be saved. */
     std::vector<ItemID> updatedItems;
 
+    /** Holds a history of entities that had a persisted component removed.
+        Observers can't track removals, so we track them here. */
+    std::vector<entt::entity> entitiesWithRemovedComponents;
+
+    /** Holds a history of entities that have been destroyed.
+        Used to know which entities need to be deleted from the database. */
+    std::vector<entt::entity> destroyedEntities;
+
+    /** Used to dedupe the changed entities while capturing. */
+    std::vector<entt::entity> dirtyEntities;
+
+    /** The number of saves since the last full entity save. */
+    unsigned int savesSinceFullSave;
+
     /** Used to track how much time has passed since the last save. */
     Timer saveTimer;
 
-    /** A scratch buffer used while serializing data. */
+    /** The snapshot that the sim thread captures into. Swapped with
+        threadSnapshot when handing it to the save thread. */
+    SaveSnapshot simSnapshot;
+
+    /** The snapshot that the save thread is writing. Only touched by the
+        save thread while saveInProgress is true. */
+    SaveSnapshot threadSnapshot;
+
+    /** A scratch buffer used by the save thread while serializing data. */
     BinaryBuffer workBuffer;
+
+    /** A scratch buffer used by the save thread to hold encoded blobs. */
+    BinaryBuffer blobBuffer;
+
+    /** Used by the save thread to build warm snapshots. */
+    WarmSnapshot warmSnapshot;
+
+    /** True if requestWarmSnapshot() was called and we haven't captured the 
+        snapshot yet. */
+    std::atomic<bool> warmSnapshotRequested;
+
+    /** Calls saveThread(). */
+    std::thread saveThreadObj;
+    /** Turn true to signal that the save thread should end. */
+    bool exitRequested;
+
+    /** Used for signaling the save thread. */
+    std::mutex saveMutex;
+    std::condition_variable saveCondVar;
+    /** True from when a snapshot is handed over until it's committed. */
+    std::atomic<bool> saveInProgress;
 };
 
 } // namespace Server
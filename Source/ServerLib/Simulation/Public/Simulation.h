@@ -13,6 +13,7 @@
 #include "InputSystem.h"
 #include "MovementSystem.h"
 #include "AISystem.h"
+#include "PathfindingSystem.h"
 #include "ItemSystem.h"
 #include "InventorySystem.h"
 #include "DialogueSystem.h"
@@ -23,6 +24,7 @@
 #include "ScriptDataSystem.h"
 #include "SaveSystem.h"
 #include "QueuedEvents.h"
+#include "Timer.h"
 #include <SDL_stdinc.h>
 #include <atomic>
 #include <queue>
@@ -128,6 +130,22 @@ public:
      */
     Uint32 getCurrentTick();
 
+    /**
+     * Requests a full save that also writes a warm snapshot, so the next 
+     * startup can skip reading the database. Meant to be called right 
+     * before a planned restart.
+     *
+     * Thread-safe. See SaveSystem::requestWarmSnapshot().
+     */
+    void requestWarmSnapshot();
+
+    /**
+     * Logs the most expensive scripts in each Lua environment, then clears
+     * their stats.
+     * Also called every Config::LUA_SCRIPT_STATS_LOG_PERIOD_S by tick().
+     */
+    void logLuaScriptStats();
+
     /**
      * Updates accumulatedTime. If greater than the tick timestep, processes
      * the next sim iteration.
@@ -175,6 +193,9 @@ private:
     /** The engine's Lua bindings. */
     EngineLuaBindings engineLuaBindings;
 
+    /** Used to time when we should log the Lua script stats. */
+    Timer scriptStatsTimer;
+
     /** If non-nullptr, contains the project's simulation extension functions.
         Allows the project to provide simulation code and have it be called at
         the appropriate time. */
@@ -203,6 +224,7 @@ private:
     InputSystem inputSystem;
     MovementSystem movementSystem;
     AISystem aiSystem;
+    PathfindingSystem pathfindingSystem;
     ItemSystem itemSystem;
     InventorySystem inventorySystem;
     DialogueSystem dialogueSystem;
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ChunkPosition.h"
+#include "ChunkExtent.h"
+#include "entt/entity/entity.hpp"
+#include <unordered_map>
+#include <vector>
+
+namespace AM
+{
+namespace Server
+{
+/**
+ * Tracks which chunks each client is subscribed to (i.e. has loaded and 
+ * should receive updates for), along with the reverse mapping.
+ *
+ * Clients are subscribed to a chunk when they request its data, and are 
+ * unsubscribed when they move out of range of it or disconnect.
+ */
+class ChunkSubscriptions
+{
+public:
+    /**
+     * Subscribes the given client entity to the given chunk.
+     * Does nothing if it's already subscribed.
+     */
+    void subscribe(entt::entity clientEntity,
+                   const ChunkPosition& chunkPosition);
+
+    /**
+     * Unsubscribes the given client entity from every chunk that isn't 
+     * within the given extent.
+     */
+    void unsubscribeOutsideOf(entt::entity clientEntity,
+                              const ChunkExtent& inRangeExtent);
+
+    /**
+     * Unsubscribes the given client entity from every chunk.
+     */
+    void unsubscribeAll(entt::entity clientEntity);
+
+    /**
+     * Returns the client entities that are subscribed to the given chunk.
+     */
+    const std::vector<entt::entity>&
+        getSubscribers(const ChunkPosition& chunkPosition) const;
+
+    /**
+     * Returns the chunks that the given client entity is subscribed to.
+     */
+    const std::vector<ChunkPosition>&
+        getSubscribedChunks(entt::entity clientEntity) const;
+
+private:
+    /**
+     * Removes the given client entity from the given chunk's subscriber list.
+     */
+    void removeSubscriber(entt::entity clientEntity,
+                          const ChunkPosition& chunkPosition);
+
+    /** Client entity -> the chunks that it's subscribed to. */
+    std::unordered_map<entt::entity, std::vector<ChunkPosition>>
+        clientChunks;
+
+    /** Chunk -> the client entities that are subscribed to it. */
+    std::unordered_map<ChunkPosition, std::vector<entt::entity>>
+        chunkSubscribers;
+};
+
+} // namespace Server
+} // namespace AM
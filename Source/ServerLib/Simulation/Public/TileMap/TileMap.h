@@ -1,10 +1,16 @@
 #pragma once
 
 #include "TileMapBase.h"
+#include "TileMapFile.h"
+#include "TileMapJournal.h"
 #include "GraphicData.h"
+#include "BinaryBuffer.h"
+#include <SDL_stdinc.h>
+#include <unordered_map>
 
 namespace AM
 {
+class ThreadPool;
 struct TileMapSnapshot;
 class Tile;
 struct TileSnapshot;
@@ -19,6 +25,24 @@ namespace Server
  *
  * Persisted tile map data is loaded from TileMap.bin.
  *
+ * TileMap.bin is memory-mapped and chunk-indexed, so startup only needs to 
+ * read the index. Chunks are loaded the first time they're edited or passed 
+ * to ensureChunkLoaded(). The const getters never load chunks, so unloaded 
+ * chunks look empty to them. If Config::PREFETCH_TILE_MAP is true, a 
+ * background thread also decodes chunks ahead of time, and 
+ * loadPrefetchedChunks() moves them into the map.
+ *
+ * Each chunk has a version, which changes whenever the chunk is edited. 
+ * Clients cache chunks by version, so they can skip re-downloading chunks 
+ * that haven't changed. Versions aren't persisted: the upper 32 bits are a 
+ * random ID that's picked at startup, so a version from a previous run will 
+ * never match.
+ *
+ * Edits made between saves are appended to TileMapJournal.bin (see 
+ * flushTileUpdateHistory()). At startup, the journal is replayed on top of 
+ * TileMap.bin, so a crash only loses the last few ticks of edits instead of 
+ * everything since the last save.
+ *
  * Note: This class expects a TileMap.bin file to be present in the same
  *       directory as the application executable.
  */
@@ -29,8 +53,10 @@ public:
      * Attempts to parse TileMap.bin and construct the tile map.
      *
      * Errors if TileMap.bin doesn't exist or it fails to parse.
+     *
+     * @param inThreadPool  Used to build chunks in parallel while loading.
      */
-    TileMap(GraphicData& inGraphicData);
+    TileMap(GraphicData& inGraphicData, ThreadPool& inThreadPool);
 
     /**
      * Attempts to save the current tile map state to TileMap.bin.
@@ -41,20 +67,96 @@ public:
      * Saves the map to a file with the given name, placed in the same
      * directory as the program binary.
      *
+     * If saving to TileMap.bin, also clears the journal.
+     *
      * @param fileName  The file name to save to, with no path prepended.
      */
     void save(const std::string& fileName);
 
+    /**
+     * Appends any tile updates that haven't been saved yet to the journal, 
+     * then clears the tile update history.
+     *
+     * Should be called once per tick, after the updates have been sent to 
+     * clients.
+     */
+    void flushTileUpdateHistory();
+
+    /**
+     * Loads up to Config::PREFETCHED_CHUNKS_PER_TICK chunks that have been 
+     * decoded by the prefetch thread.
+     * The chunks are built in parallel on threadPool.
+     */
+    void loadPrefetchedChunks();
+
+    /**
+     * Returns the current version of the given chunk.
+     * Never returns 0.
+     */
+    Uint64 getChunkVersion(const ChunkPosition& chunkPosition) const;
+
+    /**
+     * Bumps the version of the given chunk. Should be called whenever the 
+     * chunk is edited.
+     */
+    void incrementChunkVersion(const ChunkPosition& chunkPosition);
+
 private:
     /**
-     * Loads the given snapshot's data into this map.
+     * If the given chunk hasn't been loaded from the map file yet, loads it.
+     */
+    Chunk* materializeChunk(const ChunkPosition& chunkPosition) override;
+
+    /**
+     * Loads the given snapshot's data into this map, building the chunks in 
+     * parallel.
+     * Note: Only used for version 1 (non-indexed) maps.
      */
     void load(TileMapSnapshot& mapSnapshot);
 
+    /**
+     * Applies the given journaled tile update to this map.
+     */
+    void replayTileUpdate(const TileUpdateVariant& tileUpdate);
+
     /**
      * Copies the given chunk's data into the given snapshot.
      */
     void saveChunkToSnapshot(const Chunk& chunk, ChunkSnapshot& chunkSnapshot);
+
+    /** The memory-mapped map file. Holds any chunks that haven't been loaded 
+        yet. */
+    TileMapFile mapFile;
+
+    /** Holds the tile updates that were made since the last save. */
+    TileMapJournal journal;
+
+    /** The generation of the last TileMap.bin that was loaded or saved. 
+        The journal is stamped with it, so a stale journal isn't replayed. */
+    Uint32 mapGeneration;
+
+    /** How many of the entries at the front of the tile update history were 
+        already captured by a save, and shouldn't be journaled. */
+    std::size_t savedHistorySize;
+
+    /** Used while saving, to hold our serialized chunks. */
+    BinaryBuffer saveBuffer;
+
+    /** The upper 32 bits of every chunk version. Randomly chosen at startup, 
+        and never 0. */
+    Uint32 versionRunID;
+
+    /** The number of times each edited chunk has been edited during this 
+        run. Forms the lower 32 bits of the chunk's version. */
+    std::unordered_map<ChunkPosition, Uint32> chunkEditCounts;
+
+    /** Used to build chunks in parallel while loading. */
+    ThreadPool& threadPool;
+
+    /** Used by loadPrefetchedChunks() to hold the chunks that it's loading. 
+        Kept around so the snapshots' allocations can be re-used. */
+    std::vector<ChunkPosition> prefetchedPositions;
+    std::vector<ChunkSnapshot> prefetchedSnapshots;
 };
 
 } // End namespace Server
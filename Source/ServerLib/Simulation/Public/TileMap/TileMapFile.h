@@ -0,0 +1,272 @@
+#pragma once
+
+#include "ChunkPosition.h"
+#include "ChunkSnapshot.h"
+#include "MappedFile.h"
+#include <SDL_stdinc.h>
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <expected>
+
+namespace AM
+{
+namespace Server
+{
+
+/**
+ * A memory-mapped, chunk-indexed tile map file (TileMap.bin).
+ *
+ * File layout (all values are little endian):
+ *   Header: Uint16 version, Uint16 x/y/z lengths (in chunks),
+ *           Uint32 chunkCount, Uint32 generation
+ *   Index:  chunkCount * {Sint32 x, y, z, Uint32 offset, Uint32 size}
+ *   Data:   Each chunk's serialized ChunkSnapshot, at its indexed offset.
+ *
+ * Opening the file only parses the header and index, so it takes the same
+ * amount of time regardless of how large the map is. Chunks are decoded on
+ * demand through takeChunk(). If startPrefetch() is called, a background
+ * thread will also decode chunks ahead of time, in index order.
+ *
+ * Each chunk can only be taken once. After that, the tile map owns it and
+ * this file will act as if the chunk doesn't exist.
+ *
+ * Note: Version 1 maps (a single serialized TileMapSnapshot) aren't indexed.
+ *       open() will return LegacyFormat for them, and they must be loaded
+ *       the old way.
+ * Note: Version 2 headers don't have a generation. It's read as 0.
+ */
+class TileMapFile
+{
+public:
+    /** The version of the first chunk-indexed format. Anything before this
+        is a serialized TileMapSnapshot. */
+    static constexpr Uint16 FIRST_INDEXED_VERSION{2};
+
+    /** The first version that has a generation in its header. */
+    static constexpr Uint16 FIRST_GENERATION_VERSION{3};
+
+    /** The size, in bytes, of the file header. */
+    static constexpr std::size_t HEADER_SIZE{16};
+
+    /** The size, in bytes, of a version 2 file header. */
+    static constexpr std::size_t V2_HEADER_SIZE{12};
+
+    /** The size, in bytes, of each index entry. */
+    static constexpr std::size_t INDEX_ENTRY_SIZE{20};
+
+    /** How many chunks the prefetch thread is allowed to decode ahead of
+        the chunks that have been taken through takePrefetchedChunk().
+        Bounds the amount of memory held by decoded-but-untaken chunks. */
+    static constexpr std::size_t PREFETCH_WINDOW{256};
+
+    struct Header {
+        /** The version of the map format. */
+        Uint16 version{0};
+
+        /** The length, in chunks, of the map's X axis. */
+        Uint16 xLengthChunks{0};
+
+        /** The length, in chunks, of the map's Y axis. */
+        Uint16 yLengthChunks{0};
+
+        /** The length, in chunks, of the map's Z axis. */
+        Uint16 zLengthChunks{0};
+
+        /** Incremented each time the map is saved over TileMap.bin. Used
+            to tell if TileMapJournal.bin was written against this file. */
+        Uint32 generation{0};
+    };
+
+    /** A serialized chunk, to be written by write(). */
+    struct ChunkBlob {
+        ChunkPosition position{};
+        const Uint8* data{nullptr};
+        std::size_t size{0};
+    };
+
+    enum class OpenError {
+        /** The file couldn't be opened or mapped. */
+        FailedToMap,
+        /** The file is a version 1 (non-indexed) map. */
+        LegacyFormat,
+        /** The header or index is malformed. */
+        InvalidData
+    };
+
+    TileMapFile();
+
+    /**
+     * Stops the prefetch thread, if it's running.
+     */
+    ~TileMapFile();
+
+    /**
+     * Maps the given file and parses its header and index.
+     * Closes any previously opened file.
+     */
+    std::expected<void, OpenError> open(const std::string& filePath);
+
+    /**
+     * Stops the prefetch thread and unmaps the file.
+     */
+    void close();
+
+    /**
+     * Returns true if a file is currently open.
+     */
+    bool isOpen() const;
+
+    /**
+     * Returns the path of the currently open file.
+     */
+    const std::string& getFilePath() const;
+
+    /**
+     * Returns the currently open file's header.
+     */
+    const Header& getHeader() const;
+
+    /**
+     * If the given chunk is in the file and hasn't been taken yet, decodes
+     * it into outSnapshot and marks it as taken.
+     *
+     * @return true if a chunk was taken, else false.
+     */
+    bool takeChunk(const ChunkPosition& chunkPosition,
+                   ChunkSnapshot& outSnapshot);
+
+    /**
+     * Marks the given chunk as taken, without decoding it.
+     */
+    void discardChunk(const ChunkPosition& chunkPosition);
+
+    /**
+     * If the prefetch thread has decoded the next chunk in index order,
+     * moves it into the given outputs and marks it as taken.
+     *
+     * @return true if a chunk was taken, else false.
+     */
+    bool takePrefetchedChunk(ChunkPosition& outPosition,
+                             ChunkSnapshot& outSnapshot);
+
+    /**
+     * Starts a thread that decodes every untaken chunk, in index order.
+     */
+    void startPrefetch();
+
+    /**
+     * Stops the prefetch thread, if it's running.
+     * Any chunks that it already decoded can still be taken.
+     */
+    void stopPrefetch();
+
+    /**
+     * Returns the number of chunks that haven't been taken yet.
+     */
+    std::size_t getUntakenChunkCount() const;
+
+    /**
+     * Calls the given callback on every chunk that hasn't been taken yet.
+     * Used while saving, so untouched chunks can be copied straight from the
+     * mapping without being decoded.
+     *
+     * @param callback A callback of form void(const ChunkBlob&).
+     */
+    template<typename Func>
+    void forEachUntakenChunk(Func callback) const
+    {
+        for (std::size_t i{0}; i < slotCount; ++i) {
+            const Slot& slot{slots[i]};
+            if (slot.state.load(std::memory_order_acquire)
+                != SlotState::Taken) {
+                callback(ChunkBlob{slot.position,
+                                   (mappedFile.data() + slot.offset),
+                                   slot.size});
+            }
+        }
+    }
+
+    /**
+     * Writes a chunk-indexed map file containing the given chunks.
+     *
+     * Note: This always writes the current header layout, so header.version
+     *       should be the current MAP_FORMAT_VERSION.
+     *
+     * @return true if the file was successfully written, else false.
+     */
+    static bool write(const std::string& filePath, const Header& header,
+                      const std::vector<ChunkBlob>& chunkBlobs);
+
+private:
+    enum class SlotState : Uint8 {
+        /** Hasn't been touched. */
+        Pending,
+        /** The prefetch thread is decoding it. */
+        Decoding,
+        /** The prefetch thread has decoded it into prefetchedSnapshot. */
+        Decoded,
+        /** The tile map owns it. */
+        Taken
+    };
+
+    struct Slot {
+        ChunkPosition position{};
+
+        /** The offset, from the start of the file, of the chunk's data. */
+        std::size_t offset{0};
+
+        /** The size of the chunk's data. */
+        std::size_t size{0};
+
+        std::atomic<SlotState> state{SlotState::Pending};
+
+        /** If state == Decoded, holds the decoded chunk. */
+        ChunkSnapshot prefetchedSnapshot{};
+    };
+
+    /**
+     * Decodes the given slot's chunk data into the given snapshot.
+     */
+    void decodeSlot(const Slot& slot, ChunkSnapshot& outSnapshot) const;
+
+    /**
+     * Thread function. Decodes every pending slot, in index order.
+     */
+    void prefetchChunks();
+
+    /** The mapped file. */
+    MappedFile mappedFile;
+
+    /** The path of the mapped file. */
+    std::string filePath;
+
+    /** The mapped file's header. */
+    Header header;
+
+    /** One slot per indexed chunk, in index order.
+        Note: Held in a unique_ptr since Slot isn't movable. */
+    std::unique_ptr<Slot[]> slots;
+    std::size_t slotCount;
+
+    /** Maps chunk positions to indices in slots. */
+    std::unordered_map<ChunkPosition, std::size_t> slotIndices;
+
+    /** The number of slots that haven't been taken. */
+    std::size_t untakenCount;
+
+    /** The next slot that takePrefetchedChunk() will look at.
+        Atomic so the prefetch thread can stay within PREFETCH_WINDOW. */
+    std::atomic<std::size_t> nextPrefetchedSlot;
+
+    /** Calls prefetchChunks(). */
+    std::thread prefetchThreadObj;
+    /** Turn true to signal that the prefetch thread should end. */
+    std::atomic<bool> exitRequested;
+};
+
+} // End namespace Server
+} // End namespace AM
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "TileMapBase.h"
+#include "BinaryBuffer.h"
+#include <SDL_stdinc.h>
+#include <cstdio>
+#include <string>
+#include <span>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace AM
+{
+namespace Server
+{
+
+/**
+ * An append-only log of the tile updates that were made since the tile map
+ * was last saved (TileMapJournal.bin).
+ *
+ * Saving the whole map is expensive, so it only happens every
+ * Config::SAVE_PERIOD_S. Between saves, each tick's tile updates are
+ * appended to this journal. If the server crashes, replaying the journal on
+ * top of TileMap.bin restores any edits that were made after the last save.
+ * After each full map save, the journal is cleared.
+ *
+ * The journal is stamped with the generation of the TileMap.bin that it
+ * builds on. If the server crashes after a save replaces TileMap.bin but
+ * before the journal is cleared, the journal's edits are already in the new
+ * map. Its generation won't match, so it's discarded instead of replayed.
+ *
+ * File layout (all values are little endian):
+ *   Header: Uint32 mapGeneration
+ *   Records: {Uint32 payloadSize, Uint32 checksum, payload}...
+ *   Each payload is a serialized TileMapBase::TileUpdateVariant.
+ *
+ * Appends are written by a background thread. Each time it wakes up, it
+ * writes every record that's waiting and syncs the file once, so a burst
+ * of edits only costs a single sync.
+ *
+ * Note: Records store graphic set numeric IDs. These are stable as long as
+ *       the resource data doesn't change, which is all we need since the
+ *       journal only spans the time between two saves.
+ */
+class TileMapJournal
+{
+public:
+    TileMapJournal();
+
+    /**
+     * Writes any waiting records, then closes the file.
+     */
+    ~TileMapJournal();
+
+    /**
+     * Reads the journal at the given path, passing each intact record to
+     * replayFunction in the order that they were appended. Then, opens the
+     * journal for appending and starts the writer thread.
+     *
+     * If the file ends in a partially-written or corrupt record (e.g. from a
+     * crash mid-write), it and everything after it are discarded.
+     *
+     * If the file doesn't exist, or was written against a different map
+     * generation, it's reset without replaying anything.
+     *
+     * @param mapGeneration  The generation of the loaded TileMap.bin.
+     * @return The number of records that were replayed.
+     */
+    std::size_t open(const std::string& inFilePath, Uint32 mapGeneration,
+                     const std::function<void(
+                         const TileMapBase::TileUpdateVariant&)>&
+                         replayFunction);
+
+    /**
+     * Queues the given updates to be written to the journal.
+     */
+    void append(std::span<const TileMapBase::TileUpdateVariant> updates);
+
+    /**
+     * Discards any queued records and truncates the journal, then stamps it
+     * with the given map generation.
+     * Should be called after the map is fully saved, since the save contains
+     * all of the journal's updates.
+     *
+     * @param mapGeneration  The generation of the newly saved TileMap.bin.
+     */
+    void clear(Uint32 mapGeneration);
+
+private:
+    /** The size, in bytes, of the file header. */
+    static constexpr std::size_t FILE_HEADER_SIZE{4};
+
+    /** The size, in bytes, of each record's header. */
+    static constexpr std::size_t RECORD_HEADER_SIZE{8};
+
+    /**
+     * Opens the file for writing, truncating it, then writes and syncs a
+     * header with the given map generation.
+     * Must be called while holding fileMutex, or before the writer thread
+     * is started.
+     */
+    void reset(Uint32 mapGeneration);
+
+    /**
+     * Thread function.
+     * Waits for records to be queued, then writes and syncs them.
+     */
+    void writerThread();
+
+    /**
+     * Writes the given bytes to the file and syncs it to disk.
+     */
+    void writeAndSync(const BinaryBuffer& bytes);
+
+    /**
+     * Returns a checksum of the given bytes.
+     */
+    static Uint32 calcChecksum(const Uint8* data, std::size_t size);
+
+    /** The path to the journal file. */
+    std::string filePath;
+
+    /** The open journal file. Only touched while holding fileMutex. */
+    std::FILE* file;
+
+    /** Serialized records that are waiting to be written. */
+    BinaryBuffer queuedRecords;
+
+    /** The records that the writer thread is currently writing. Swapped
+        with queuedRecords. */
+    BinaryBuffer writingRecords;
+
+    /** Calls writerThread(). */
+    std::thread writerThreadObj;
+    /** Turn true to signal that the writer thread should end. */
+    bool exitRequested;
+
+    /** Guards queuedRecords and exitRequested. */
+    std::mutex queueMutex;
+    std::condition_variable queueCondVar;
+
+    /** Guards file. Held by the writer thread while it writes, so clear()
+        can't truncate the file mid-write. */
+    std::mutex fileMutex;
+};
+
+} // End namespace Server
+} // End namespace AM
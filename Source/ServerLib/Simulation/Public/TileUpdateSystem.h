@@ -4,7 +4,12 @@
 #include "TileRemoveLayer.h"
 #include "TileClearLayers.h"
 #include "TileExtentClearLayers.h"
+#include "TileUpdateBatch.h"
+#include "TileMapBase.h"
 #include "QueuedEvents.h"
+#include "entt/entity/entity.hpp"
+#include <unordered_map>
+#include <vector>
 
 namespace AM
 {
@@ -18,7 +23,7 @@ class ISimulationExtension;
  * Processes tile update requests sent by clients. If a request is valid,
  * updates the map.
  * Also, detects changes to the tile map and sends the new map state to all
- * nearby clients.
+ * clients that are subscribed to the affected chunks.
  */
 class TileUpdateSystem
 {
@@ -31,7 +36,10 @@ public:
     void updateTiles();
 
     /**
-     * Sends any dirty tile state to all nearby clients.
+     * Sends any dirty tile state to all subscribed clients.
+     * Each client usually receives (at most) a single TileUpdateBatch per 
+     * call. If a client's updates don't fit in one batch, they're split 
+     * across multiple batches, sent in order.
      */
     void sendTileUpdates();
 
@@ -59,6 +67,18 @@ private:
     void clearExtentLayers(
         const TileExtentClearLayers& clearExtentLayersRequest);
 
+    /**
+     * Adds the given update to the end of the given batch. If it continues 
+     * the batch's last layer run, extends the run instead.
+     */
+    static void appendToBatch(TileUpdateBatch& batch,
+                              const TileMapBase::TileUpdateVariant& update);
+
+    /**
+     * Sends the given batch to the given client entity, then clears it.
+     */
+    void sendBatch(entt::entity clientEntity, TileUpdateBatch& batch);
+
     /** Used to access the entity registry, locator, and the tile map. */
     World& world;
     /** Used to send tile update requests and receive tile updates. */
@@ -68,6 +88,14 @@ private:
         Used for checking if tile updates are valid. */
     ISimulationExtension* extension;
 
+    /** The batch of updates that we're building for each in-range client 
+        entity. Used by sendTileUpdates(). */
+    std::unordered_map<entt::entity, TileUpdateBatch> clientBatches;
+
+    /** The client entities that should receive the update that's currently 
+        being processed. Used by sendTileUpdates(). */
+    std::vector<entt::entity> recipients;
+
     EventQueue<TileAddLayer> addLayerRequestQueue;
     EventQueue<TileRemoveLayer> removeLayerRequestQueue;
     EventQueue<TileClearLayers> clearLayersRequestQueue;
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "BinaryBuffer.h"
+#include "MappedFile.h"
+#include <SDL_stdinc.h>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace AM
+{
+namespace Server
+{
+
+/**
+ * A single-file image of the world's database-backed state (non-client
+ * entities, items, and stored values), used for fast warm restarts
+ * (WorldSnapshot.bin).
+ *
+ * File layout (all values are little endian):
+ *   Header: Uint8[4] magic ("AMWS"), Uint16 version, Uint16 padding,
+ *           Uint32[2] resource data hash (low, high), Uint32 entityCount,
+ *           Uint32 itemCount
+ *   Index:  (entityCount + itemCount + 2) * {Uint32 offset, Uint32 size}
+ *           (entities, then items, then the entity stored value ID map,
+ *           then the global stored value map)
+ *   Data:   Each blob, at its indexed offset.
+ * Entity and item blobs are encoded through PersistedBlob, the same as in
+ * the database.
+ *
+ * The file is memory-mapped when loading, so blobs are deserialized
+ * straight out of the mapping.
+ *
+ * A snapshot is only valid while it matches both the database and
+ * ResourceData.json. SaveSystem writes it alongside a full save, and
+ * deletes it before any later save. The resource data hash is checked in
+ * open().
+ *
+ * Note: The tile map isn't included, since TileMap.bin is already an
+ *       indexed image that's mapped and loaded on demand.
+ *
+ * This class is also used as a plain container while loading from the
+ * database, so both load paths can share the same decode step.
+ */
+class WarmSnapshot
+{
+public:
+    /** The snapshot's file name, with no path prepended. */
+    static constexpr const char* FILE_NAME{"WorldSnapshot.bin"};
+
+    /** The version of the snapshot format. */
+    static constexpr Uint16 FORMAT_VERSION{1};
+
+    WarmSnapshot();
+
+    //-------------------------------------------------------------------------
+    // Building
+    //-------------------------------------------------------------------------
+    /**
+     * Clears all of this snapshot's blobs, and closes any mapped file.
+     */
+    void clear();
+
+    /**
+     * Copies the given blob into this snapshot.
+     */
+    void addEntity(const Uint8* blob, std::size_t blobSize);
+    void addItem(const Uint8* blob, std::size_t blobSize);
+    void setEntityStoredValueIDMap(const Uint8* blob, std::size_t blobSize);
+    void setGlobalStoredValueMap(const Uint8* blob, std::size_t blobSize);
+
+    /**
+     * Writes this snapshot to the given path.
+     * Writes to a temp file first, so a crash mid-write won't leave a
+     * partial snapshot in place.
+     *
+     * @return true if the write succeeded, else false.
+     */
+    bool write(const std::string& filePath) const;
+
+    //-------------------------------------------------------------------------
+    // Loading
+    //-------------------------------------------------------------------------
+    /**
+     * Maps the snapshot at the given path and reads its index.
+     *
+     * @return false if the file doesn't exist, is invalid, or was made with
+     *         different resource data. Else, true.
+     */
+    bool open(const std::string& filePath);
+
+    /**
+     * Deletes the snapshot at the given path, if one exists.
+     */
+    static void remove(const std::string& filePath);
+
+    //-------------------------------------------------------------------------
+    // Access
+    //-------------------------------------------------------------------------
+    std::size_t getEntityCount() const;
+    std::span<const Uint8> getEntity(std::size_t index) const;
+    std::size_t getItemCount() const;
+    std::span<const Uint8> getItem(std::size_t index) const;
+    std::span<const Uint8> getEntityStoredValueIDMap() const;
+    std::span<const Uint8> getGlobalStoredValueMap() const;
+
+private:
+    /** The size, in bytes, of the file header. */
+    static constexpr std::size_t HEADER_SIZE{24};
+
+    /** The size, in bytes, of each index entry. */
+    static constexpr std::size_t INDEX_ENTRY_SIZE{8};
+
+    /** Where a blob lives, relative to getBlobData(). */
+    struct BlobLocation {
+        std::size_t offset{0};
+        std::size_t size{0};
+    };
+
+    /**
+     * Returns a hash of ResourceData.json's contents.
+     */
+    static Uint64 hashResourceData();
+
+    /**
+     * Copies the given blob into blobData and returns its location.
+     */
+    BlobLocation addBlob(const Uint8* blob, std::size_t blobSize);
+
+    /**
+     * Returns the bytes that our blob locations are relative to. If a file
+     * is mapped, this is the mapping. Otherwise, it's blobData.
+     */
+    const Uint8* getBlobData() const;
+
+    /**
+     * Returns the blob at the given location.
+     */
+    std::span<const Uint8> getBlob(const BlobLocation& location) const;
+
+    /** The mapped snapshot file, if we're loading. */
+    MappedFile mappedFile;
+
+    /** Holds the blobs that were added, if we're building. */
+    BinaryBuffer blobData;
+
+    std::vector<BlobLocation> entities;
+    std::vector<BlobLocation> items;
+    BlobLocation entityStoredValueIDMap;
+    BlobLocation globalStoredValueMap;
+};
+
+} // End namespace Server
+} // End namespace AM
@@ -1,16 +1,23 @@
 #pragma once
 
 #include "ItemData.h"
+#include "ThreadPool.h"
 #include "TileMap.h"
+#include "ChunkSubscriptions.h"
 #include "NetworkDefs.h"
 #include "EntityLocator.h"
 #include "EntityStoredValueID.h"
 #include "EntityStoredValueIDMap.h"
 #include "GlobalStoredValueMap.h"
 #include "SpawnStrategy.h"
+#include "Dialogue.h"
+#include "HashTools.h"
 #include "entt/entity/registry.hpp"
 #include <unordered_map>
+#include <memory>
 #include <random>
+#include <vector>
+#include <string_view>
 
 namespace AM
 {
@@ -23,6 +30,7 @@ namespace Server
 {
 class GraphicData;
 class Database;
+class WarmSnapshot;
 struct EntityInitLua;
 struct ItemInitLua;
 
@@ -58,6 +66,11 @@ public:
     /** Item data templates. */
     ItemData itemData;
 
+    /** Used to split work (e.g. loading chunks, ticking parallel AI) across 
+        cores. Shared so that only one set of worker threads is started.
+        Note: Only use this from the sim thread. See ThreadPool.h. */
+    ThreadPool threadPool;
+
     /** The tile map that makes up the world. */
     TileMap tileMap;
 
@@ -65,6 +78,10 @@ public:
         position. */
     EntityLocator entityLocator;
 
+    /** Tracks which chunks each client has loaded, so we know who to send 
+        tile updates to. */
+    ChunkSubscriptions chunkSubscriptions;
+
     /** Maps entity stored value string IDs -> their associated numeric ID. */
     EntityStoredValueIDMap entityStoredValueIDMap;
 
@@ -128,6 +145,17 @@ public:
      */
     std::string runItemInitScript(Item& item, const ItemInitScript& initScript);
 
+    /**
+     * If the given entity has a Dialogue and its init script matches one 
+     * that we've already seen, points its Dialogue at the matching shared 
+     * definition. Otherwise, its definition becomes the shared one for its 
+     * init script.
+     *
+     * Definitions are compared before sharing, so init scripts don't need to 
+     * be deterministic.
+     */
+    void shareDialogue(entt::entity entity);
+
     /**
      * Returns the numeric ID for the given entity stored value string ID.
      * If stringID is not present in the map, adds it and generates the next 
@@ -138,6 +166,23 @@ public:
      */
     EntityStoredValueID getEntityStoredValueID(std::string_view stringID);
 
+    /**
+     * Returns the numeric ID for the given entity stored value string ID.
+     * Unlike getEntityStoredValueID(), never adds stringID to the map.
+     *
+     * @return If a flag with the given ID doesn't exist, returns null. 
+     *         Otherwise, returns the numeric ID.
+     */
+    EntityStoredValueID findEntityStoredValueID(std::string_view stringID);
+
+    /**
+     * Returns the string ID for the given entity stored value numeric ID.
+     *
+     * @return If numericID hasn't been assigned, returns an empty string.
+     */
+    std::string_view
+        getEntityStoredValueStringID(EntityStoredValueID numericID) const;
+
     /**
      * Adds a new value, or overwrites an existing value.
      *
@@ -181,19 +226,32 @@ private:
     void onEntityDestroyed(entt::entity entity);
 
     /**
-     * Loads our saved non-client entities and adds them to the registry.
+     * Copies all of our saved data out of the database and into savedData.
+     * Used when there's no valid warm snapshot.
+     */
+    void fetchSavedData(WarmSnapshot& savedData);
+
+    /**
+     * Loads the saved non-client entities and adds them to the registry.
+     *
+     * The entities are deserialized in parallel on the given pool, then 
+     * added to the registry in order.
      */
-    void loadNonClientEntities();
+    void loadNonClientEntities(const WarmSnapshot& savedData,
+                               ThreadPool& loadPool);
 
     /**
-     * Loads our saved items and adds them to itemData.
+     * Loads the saved items and adds them to itemData.
+     *
+     * The items are deserialized in parallel on the given pool, then added 
+     * to itemData in order.
      */
-    void loadItems();
+    void loadItems(const WarmSnapshot& savedData, ThreadPool& loadPool);
 
     /**
-     * Loads our saved entity stored value IDs and global stored values.
+     * Loads the saved entity stored value IDs and global stored values.
      */
-    void loadStoredValues();
+    void loadStoredValues(const WarmSnapshot& savedData);
 
     /** Used to get graphics info. */
     const GraphicData& graphicData;
@@ -204,13 +262,23 @@ private:
     /** Used to run item init scripts. */
     ItemInitLua& itemInitLua;
 
-    /** Tracks the next numeric entity stored value ID to use (typically 1 greater 
-        than the highest ID in entityStoredValueIDMap). */
-    Uint32 nextStoredValueID;
+    /** Maps entity stored value numeric IDs -> their string ID (the reverse 
+        of entityStoredValueIDMap). Views into entityStoredValueIDMap's keys.
+        Index 0 is the null ID, so the next numeric ID to use is always 
+        size(). */
+    std::vector<std::string_view> entityStoredValueStringIDs;
 
     /** A scratch buffer used while processing string IDs. */
     std::string workStringID;
 
+    /** Init script -> the dialogue definition that it builds. Used to share 
+        definitions between entities with identical init scripts.
+        Weak, so a definition is freed when its last entity is destroyed or 
+        re-initialized. */
+    std::unordered_map<std::string, std::weak_ptr<Dialogue::Definition>,
+                       string_hash, std::equal_to<>>
+        sharedDialogues;
+
     // For random spawn points.
     std::random_device randomDevice;
     std::mt19937 generator;
@@ -4,6 +4,7 @@
 #include "ChunkPosition.h"
 #include "ChunkUpdate.h"
 #include "NetworkDefs.h"
+#include <SDL_stdinc.h>
 #include <vector>
 
 namespace AM
@@ -21,8 +22,18 @@ public:
     //--------------------------------------------------------------------------
     // Networked data
     //--------------------------------------------------------------------------
+    struct RequestedChunk {
+        /** The position of the requested chunk. */
+        ChunkPosition position{};
+
+        /** The version of this chunk that the client has cached, or 0 if 
+            it doesn't have one. If this matches the server's version, the 
+            server will reply with "unchanged" instead of resending it. */
+        Uint64 knownVersion{0};
+    };
+
     /** The chunks that the client is requesting. */
-    std::vector<ChunkPosition> requestedChunks;
+    std::vector<RequestedChunk> requestedChunks;
 
     //--------------------------------------------------------------------------
     // Local data
@@ -36,6 +47,13 @@ public:
     NetworkID netID{0};
 };
 
+template<typename S>
+void serialize(S& serializer, ChunkDataRequest::RequestedChunk& requestedChunk)
+{
+    serializer.object(requestedChunk.position);
+    serializer.value8b(requestedChunk.knownVersion);
+}
+
 template<typename S>
 void serialize(S& serializer, ChunkDataRequest& chunkDataRequest)
 {
@@ -2,6 +2,7 @@
 
 #include "EngineMessageType.h"
 #include "ChunkWireSnapshot.h"
+#include "ChunkPosition.h"
 #include <vector>
 
 namespace AM
@@ -24,12 +25,17 @@ public:
 
     /** The chunks that the client should load. */
     std::vector<ChunkWireSnapshot> chunks;
+
+    /** Requested chunks that haven't changed since the version that the 
+        client said it has. The client should load them from its cache. */
+    std::vector<ChunkPosition> unchangedChunks;
 };
 
 template<typename S>
 void serialize(S& serializer, ChunkUpdate& chunkUpdate)
 {
     serializer.container(chunkUpdate.chunks, ChunkUpdate::MAX_CHUNKS);
+    serializer.container(chunkUpdate.unchangedChunks, ChunkUpdate::MAX_CHUNKS);
 }
 
 } // End namespace AM
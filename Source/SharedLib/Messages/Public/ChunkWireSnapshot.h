@@ -43,6 +43,10 @@ public:
     /** This chunk's Z-axis coordinate. */
     Sint16 z{0};
 
+    /** The server's version of this chunk at the time it was sent. Used by 
+        the client to cache the chunk. 0 if unversioned. */
+    Uint64 version{0};
+
     /** Holds an entry for each graphic used in this chunk's tiles. Part of a
         space-saving approach that lets TileSnapshot hold indices into this
         palette instead of directly holding the data. */
@@ -112,6 +116,7 @@ void serialize(S& serializer, ChunkWireSnapshot& chunkSnapshot)
     serializer.value2b(chunkSnapshot.x);
     serializer.value2b(chunkSnapshot.y);
     serializer.value2b(chunkSnapshot.z);
+    serializer.value8b(chunkSnapshot.version);
     serializer.container(chunkSnapshot.palette,
                          ChunkSnapshot::MAX_PALETTE_ENTRIES);
     serializer.container1b(chunkSnapshot.tileLayerCounts);
@@ -50,6 +50,7 @@ enum class EngineMessageType : Uint8 {
     ItemInitScriptResponse,
     CombineItems,
     DialogueResponse,
+    TileUpdateBatch,
 
     // Bidirectional Messages
     TileAddLayer,
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "EngineMessageType.h"
+#include "TilePosition.h"
+#include "TileOffset.h"
+#include "TileLayer.h"
+#include "TileClearLayers.h"
+#include "TileExtentClearLayers.h"
+#include "bitsery/ext/std_variant.h"
+#include <SDL_stdinc.h>
+#include <variant>
+#include <vector>
+
+namespace AM
+{
+/**
+ * Sent by the server to tell a client about all of the tile updates that 
+ * happened near it during a tick.
+ *
+ * Adds and removes are run-length encoded: consecutive identical edits along 
+ * a straight line (e.g. a wall being dragged across many tiles) are sent as 
+ * a single LayerRun.
+ *
+ * Updates must be applied in order.
+ */
+struct TileUpdateBatch {
+public:
+    // The EngineMessageType enum value that this message corresponds to.
+    // Declares this struct as a message that the Network can send and receive.
+    static constexpr EngineMessageType MESSAGE_TYPE{
+        EngineMessageType::TileUpdateBatch};
+
+    /** Used as a "we should never hit this" cap on the number of updates. */
+    static constexpr std::size_t MAX_UPDATES{10000};
+
+    /**
+     * The same layer being added to or removed from a line of tiles.
+     */
+    struct LayerRun {
+        enum class Operation : Uint8 {
+            Add,
+            Remove
+        };
+
+        /** The direction that the run extends in, from startPosition. */
+        enum class Direction : Uint8 {
+            East,  // +X
+            West,  // -X
+            South, // +Y
+            North  // -Y
+        };
+
+        Operation operation{Operation::Add};
+
+        /** The position of the first tile in the run. */
+        TilePosition startPosition{};
+
+        Direction direction{Direction::East};
+
+        /** The number of tiles in the run. */
+        Uint16 length{1};
+
+        /** The layer to add or remove. See TileAddLayer and TileRemoveLayer 
+            for details on these fields. */
+        TileOffset tileOffset{};
+        TileLayer::Type layerType{TileLayer::Type::None};
+        Uint16 graphicSetID{0};
+        Uint8 graphicValue{0};
+
+        /**
+         * Returns the position of the tile at the given index in this run.
+         */
+        TilePosition getPosition(int index) const
+        {
+            switch (direction) {
+                case Direction::East:
+                    return {startPosition.x + index, startPosition.y,
+                            startPosition.z};
+                case Direction::West:
+                    return {startPosition.x - index, startPosition.y,
+                            startPosition.z};
+                case Direction::South:
+                    return {startPosition.x, startPosition.y + index,
+                            startPosition.z};
+                case Direction::North:
+                    return {startPosition.x, startPosition.y - index,
+                            startPosition.z};
+            }
+            return startPosition;
+        }
+    };
+
+    using UpdateVariant
+        = std::variant<LayerRun, TileClearLayers, TileExtentClearLayers>;
+
+    /** The tile updates, in the order that they occurred. */
+    std::vector<UpdateVariant> updates{};
+};
+
+template<typename S>
+void serialize(S& serializer, TileUpdateBatch::LayerRun& layerRun)
+{
+    serializer.value1b(layerRun.operation);
+    serializer.object(layerRun.startPosition);
+    serializer.value1b(layerRun.direction);
+    serializer.value2b(layerRun.length);
+    serializer.object(layerRun.tileOffset);
+    serializer.value1b(layerRun.layerType);
+    serializer.value2b(layerRun.graphicSetID);
+    serializer.value1b(layerRun.graphicValue);
+}
+
+template<typename S>
+void serialize(S& serializer, TileUpdateBatch& tileUpdateBatch)
+{
+    serializer.container(
+        tileUpdateBatch.updates, TileUpdateBatch::MAX_UPDATES,
+        [](S& serializer, TileUpdateBatch::UpdateVariant& update) {
+            // Note: This calls serialize() for each type.
+            serializer.ext(update, bitsery::ext::StdVariant{});
+        });
+}
+
+} // End namespace AM
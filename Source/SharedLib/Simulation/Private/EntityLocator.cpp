@@ -3,13 +3,22 @@
 #include "Position.h"
 #include "Cylinder.h"
 #include "BoundingBox.h"
-#include "Collision.h"
+#include "Ray.h"
 #include "CellPosition.h"
 #include "Log.h"
 #include "AMAssert.h"
 #include "entt/entity/registry.hpp"
 #include <cmath>
 #include <algorithm>
+#include <limits>
+
+// SSE2 is part of the x86-64 baseline, so we only need to check for it on
+// other architectures.
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)                  \
+    || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define AM_LOCATOR_USE_SSE 1
+#include <emmintrin.h>
+#endif
 
 namespace AM
 {
@@ -49,22 +58,7 @@ void EntityLocator::setEntityLocation(entt::entity entity,
                                       const BoundingBox& boundingBox)
 {
     // Find the cells that the bounding box intersects.
-    CellExtent boxCellExtent{};
-    boxCellExtent.x
-        = static_cast<int>(std::floor(boundingBox.minX / CELL_WORLD_WIDTH));
-    boxCellExtent.y
-        = static_cast<int>(std::floor(boundingBox.minY / CELL_WORLD_WIDTH));
-    boxCellExtent.z
-        = static_cast<int>(std::floor(boundingBox.minZ / CELL_WORLD_HEIGHT));
-    boxCellExtent.xLength
-        = (static_cast<int>(std::ceil(boundingBox.maxX / CELL_WORLD_WIDTH))
-           - boxCellExtent.x);
-    boxCellExtent.yLength
-        = (static_cast<int>(std::ceil(boundingBox.maxY / CELL_WORLD_WIDTH))
-           - boxCellExtent.y);
-    boxCellExtent.zLength
-        = (static_cast<int>(std::ceil(boundingBox.maxZ / CELL_WORLD_HEIGHT))
-           - boxCellExtent.z);
+    CellExtent boxCellExtent{boxToCellExtent(boundingBox)};
 
     if (!(gridCellExtent.containsExtent(boxCellExtent))) {
         LOG_ERROR("Tried to track entity that is outside of the locator's "
@@ -89,31 +83,44 @@ void EntityLocator::setEntityLocation(entt::entity entity,
     for (int z{boxCellExtent.z}; z <= boxCellExtent.zMax(); ++z) {
         for (int y{boxCellExtent.y}; y <= boxCellExtent.yMax(); ++y) {
             for (int x{boxCellExtent.x}; x <= boxCellExtent.xMax(); ++x) {
-                // Add the entity to this cell's entity vector.
+                // Add the entity and its bounds to this cell.
                 std::size_t linearizedIndex{linearizeCellIndex({x, y, z})};
-                std::vector<entt::entity>& entityVec{
-                    entityGrid[linearizedIndex]};
-
-                entityVec.push_back(entity);
+                Cell& cell{entityGrid[linearizedIndex]};
+
+                cell.entities.push_back(entity);
+                cell.minXs.push_back(boundingBox.minX);
+                cell.maxXs.push_back(boundingBox.maxX);
+                cell.minYs.push_back(boundingBox.minY);
+                cell.maxYs.push_back(boundingBox.maxY);
+                cell.minZs.push_back(boundingBox.minZ);
+                cell.maxZs.push_back(boundingBox.maxZ);
             }
         }
     }
 }
 
 std::vector<entt::entity>& EntityLocator::getEntities(const Cylinder& cylinder)
+{
+    getEntities(cylinder, returnVector);
+
+    return returnVector;
+}
+
+void EntityLocator::getEntities(const Cylinder& cylinder,
+                                std::vector<entt::entity>& outEntities) const
 {
     AM_ASSERT(cylinder.radius >= 0, "Cylinder can't have negative radius.");
 
     // Run a coarse pass.
-    getEntitiesCoarse(cylinder);
+    getEntitiesCoarse(cylinder, outEntities);
 
     // Erase any entities whose position isn't within the cylinder.
-    std::erase_if(returnVector, [this, &cylinder](entt::entity entity) {
-        const Position& position{registry.get<Position>(entity)};
+    // Note: We only use const registry access, so this is thread safe.
+    const entt::registry& constRegistry{registry};
+    std::erase_if(outEntities, [&](entt::entity entity) {
+        const Position& position{constRegistry.get<Position>(entity)};
         return !(cylinder.intersects(position));
     });
-
-    return returnVector;
 }
 
 std::vector<entt::entity>&
@@ -142,32 +149,74 @@ std::vector<entt::entity>&
 
 std::vector<entt::entity>&
     EntityLocator::getCollisions(const Cylinder& cylinder)
+{
+    getCollisions(cylinder, returnVector);
+
+    return returnVector;
+}
+
+void EntityLocator::getCollisions(const Cylinder& cylinder,
+                                  std::vector<entt::entity>& outEntities) const
 {
     AM_ASSERT(cylinder.radius >= 0, "Cylinder can't have negative radius.");
 
-    // Run a coarse pass.
-    getEntitiesCoarse(cylinder);
+    outEntities.clear();
 
-    // Erase any entities that don't actually intersect the cylinder.
-    std::erase_if(returnVector, [this, &cylinder](entt::entity entity) {
-        const Collision& collision{registry.get<Collision>(entity)};
-        return !(collision.worldBounds.intersects(cylinder));
-    });
+    // Calc the cell extent that is intersected by the cylinder, and clip it
+    // to the grid's bounds.
+    CellExtent cylinderCellExtent{cylinderToCellExtent(cylinder)};
+    cylinderCellExtent.intersectWith(gridCellExtent);
 
-    return returnVector;
+    // Add the entities in every intersected cell that actually intersect the
+    // cylinder.
+    for (int z{cylinderCellExtent.z}; z <= cylinderCellExtent.zMax(); ++z) {
+        for (int y{cylinderCellExtent.y}; y <= cylinderCellExtent.yMax(); ++y) {
+            for (int x{cylinderCellExtent.x}; x <= cylinderCellExtent.xMax();
+                 ++x) {
+                const Cell& cell{entityGrid[linearizeCellIndex({x, y, z})]};
+                for (std::size_t i{0}; i < cell.entities.size(); ++i) {
+                    BoundingBox bounds{cell.minXs[i], cell.maxXs[i],
+                                       cell.minYs[i], cell.maxYs[i],
+                                       cell.minZs[i], cell.maxZs[i]};
+                    if (bounds.intersects(cylinder)) {
+                        outEntities.push_back(cell.entities[i]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Remove duplicates from the return vector.
+    std::sort(outEntities.begin(), outEntities.end());
+    outEntities.erase(std::unique(outEntities.begin(), outEntities.end()),
+                      outEntities.end());
 }
 
 std::vector<entt::entity>&
     EntityLocator::getCollisions(const BoundingBox& boundingBox)
 {
-    // Run a coarse pass.
-    getEntitiesCoarse(boundingBox);
+    returnVector.clear();
 
-    // Erase any entities that don't actually intersect the extent.
-    std::erase_if(returnVector, [this, &boundingBox](entt::entity entity) {
-        const Collision& collision{registry.get<Collision>(entity)};
-        return !(collision.worldBounds.intersects(boundingBox));
-    });
+    // Calc the cell extent that is intersected by the box, and clip it to
+    // the grid's bounds.
+    CellExtent boxCellExtent{boxToCellExtent(boundingBox)};
+    boxCellExtent.intersectWith(gridCellExtent);
+
+    // Add the entities in every intersected cell that actually intersect the
+    // box.
+    for (int z{boxCellExtent.z}; z <= boxCellExtent.zMax(); ++z) {
+        for (int y{boxCellExtent.y}; y <= boxCellExtent.yMax(); ++y) {
+            for (int x{boxCellExtent.x}; x <= boxCellExtent.xMax(); ++x) {
+                const Cell& cell{entityGrid[linearizeCellIndex({x, y, z})]};
+                appendIntersecting<false>(cell, boundingBox, returnVector);
+            }
+        }
+    }
+
+    // Remove duplicates from the return vector.
+    std::sort(returnVector.begin(), returnVector.end());
+    returnVector.erase(std::unique(returnVector.begin(), returnVector.end()),
+                       returnVector.end());
 
     return returnVector;
 }
@@ -175,14 +224,39 @@ std::vector<entt::entity>&
 std::vector<entt::entity>&
     EntityLocator::getCollisions(const TileExtent& tileExtent)
 {
-    // Run a coarse pass.
-    getEntitiesCoarse(tileExtent);
+    static constexpr float TILE_WORLD_WIDTH{SharedConfig::TILE_WORLD_WIDTH};
+    static constexpr float TILE_WORLD_HEIGHT{SharedConfig::TILE_WORLD_HEIGHT};
 
-    // Erase any entities that don't actually intersect the extent.
-    std::erase_if(returnVector, [this, &tileExtent](entt::entity entity) {
-        const Collision& collision{registry.get<Collision>(entity)};
-        return !(collision.worldBounds.intersects(tileExtent));
-    });
+    returnVector.clear();
+
+    // Calc the cell extent that is intersected by the tile extent, and clip
+    // it to the grid's bounds.
+    CellExtent tileCellExtent{tileToCellExtent(tileExtent)};
+    tileCellExtent.intersectWith(gridCellExtent);
+
+    // Add the entities in every intersected cell that actually intersect the
+    // extent.
+    // Note: Like BoundingBox::intersects(TileExtent), shared edges count.
+    BoundingBox tileBounds{
+        (tileExtent.x * TILE_WORLD_WIDTH),
+        ((tileExtent.x + tileExtent.xLength) * TILE_WORLD_WIDTH),
+        (tileExtent.y * TILE_WORLD_WIDTH),
+        ((tileExtent.y + tileExtent.yLength) * TILE_WORLD_WIDTH),
+        (tileExtent.z * TILE_WORLD_HEIGHT),
+        ((tileExtent.z + tileExtent.zLength) * TILE_WORLD_HEIGHT)};
+    for (int z{tileCellExtent.z}; z <= tileCellExtent.zMax(); ++z) {
+        for (int y{tileCellExtent.y}; y <= tileCellExtent.yMax(); ++y) {
+            for (int x{tileCellExtent.x}; x <= tileCellExtent.xMax(); ++x) {
+                const Cell& cell{entityGrid[linearizeCellIndex({x, y, z})]};
+                appendIntersecting<true>(cell, tileBounds, returnVector);
+            }
+        }
+    }
+
+    // Remove duplicates from the return vector.
+    std::sort(returnVector.begin(), returnVector.end());
+    returnVector.erase(std::unique(returnVector.begin(), returnVector.end()),
+                       returnVector.end());
 
     return returnVector;
 }
@@ -196,6 +270,272 @@ std::vector<entt::entity>&
     return getCollisions(tileExtent);
 }
 
+std::vector<entt::entity>&
+    EntityLocator::getNearestEntities(const Position& position,
+                                      std::size_t count, float maxRadius,
+                                      const EntityFilter& filter)
+{
+    getNearestEntities(position, count, maxRadius, returnVector, filter);
+
+    return returnVector;
+}
+
+void EntityLocator::getNearestEntities(const Position& position,
+                                       std::size_t count, float maxRadius,
+                                       std::vector<entt::entity>& outEntities,
+                                       const EntityFilter& filter) const
+{
+    AM_ASSERT(maxRadius >= 0, "Radius can't be negative.");
+
+    outEntities.clear();
+    if (count == 0) {
+        return;
+    }
+
+    // Calc the range of cell Z levels that are within the radius.
+    const CellPosition centerCell{toCellPosition(position)};
+    const int minZ{std::max(
+        static_cast<int>(
+            std::floor((position.z - maxRadius) / CELL_WORLD_HEIGHT)),
+        gridCellExtent.z)};
+    const int maxZ{std::min(
+        static_cast<int>(
+            std::floor((position.z + maxRadius) / CELL_WORLD_HEIGHT)),
+        gridCellExtent.zMax())};
+
+    // The best entities that we've found so far, sorted nearest first.
+    std::vector<std::pair<float, entt::entity>> nearestEntities{};
+
+    // Every entity that we've considered so far, sorted.
+    // Note: Entities can span multiple cells, so we need to skip repeats.
+    std::vector<entt::entity> visitedEntities{};
+    std::vector<entt::entity> ringEntities{};
+
+    const float maxRadiusSquared{maxRadius * maxRadius};
+    const entt::registry& constRegistry{registry};
+    for (int ring{0};; ++ring) {
+        // Gather the entities in this ring's cells.
+        ringEntities.clear();
+        for (int z{minZ}; z <= maxZ; ++z) {
+            for (int y{centerCell.y - ring}; y <= (centerCell.y + ring); ++y) {
+                // Only the top and bottom rows are full. The rest of the rows
+                // only have their ends in the ring.
+                const bool isFullRow{(y == (centerCell.y - ring))
+                                     || (y == (centerCell.y + ring))};
+                const int xStep{isFullRow ? 1 : std::max(ring * 2, 1)};
+                for (int x{centerCell.x - ring}; x <= (centerCell.x + ring);
+                     x += xStep) {
+                    if (!(gridCellExtent.containsPosition({x, y, z}))) {
+                        continue;
+                    }
+
+                    const Cell& cell{
+                        entityGrid[linearizeCellIndex({x, y, z})]};
+                    ringEntities.insert(ringEntities.end(),
+                                        cell.entities.begin(),
+                                        cell.entities.end());
+                }
+            }
+        }
+        std::sort(ringEntities.begin(), ringEntities.end());
+        ringEntities.erase(
+            std::unique(ringEntities.begin(), ringEntities.end()),
+            ringEntities.end());
+
+        // Consider any entities that we haven't seen yet.
+        for (entt::entity entity : ringEntities) {
+            if (std::binary_search(visitedEntities.begin(),
+                                   visitedEntities.end(), entity)) {
+                continue;
+            }
+
+            const Position& entityPosition{
+                constRegistry.get<Position>(entity)};
+            float distanceSquared{position.squaredDistanceTo(entityPosition)};
+            if ((distanceSquared > maxRadiusSquared)
+                || ((nearestEntities.size() == count)
+                    && (distanceSquared >= nearestEntities.back().first))
+                || (filter && !(filter(entity)))) {
+                continue;
+            }
+
+            auto insertIt{std::upper_bound(
+                nearestEntities.begin(), nearestEntities.end(),
+                distanceSquared, [](float distance, const auto& pair) {
+                    return distance < pair.first;
+                })};
+            nearestEntities.insert(insertIt, {distanceSquared, entity});
+            if (nearestEntities.size() > count) {
+                nearestEntities.pop_back();
+            }
+        }
+
+        std::size_t oldVisitedSize{visitedEntities.size()};
+        visitedEntities.insert(visitedEntities.end(), ringEntities.begin(),
+                               ringEntities.end());
+        std::inplace_merge(visitedEntities.begin(),
+                           (visitedEntities.begin() + oldVisitedSize),
+                           visitedEntities.end());
+        visitedEntities.erase(
+            std::unique(visitedEntities.begin(), visitedEntities.end()),
+            visitedEntities.end());
+
+        // If the ring covers the whole grid, we're done.
+        if (((centerCell.x - ring) <= gridCellExtent.x)
+            && ((centerCell.x + ring) >= gridCellExtent.xMax())
+            && ((centerCell.y - ring) <= gridCellExtent.y)
+            && ((centerCell.y + ring) >= gridCellExtent.yMax())) {
+            break;
+        }
+
+        // If no cell outside of the ring could hold an entity within the
+        // radius or nearer than our furthest result, we're done.
+        float ringDistance{std::min(
+            {(position.x - ((centerCell.x - ring) * CELL_WORLD_WIDTH)),
+             (((centerCell.x + ring + 1) * CELL_WORLD_WIDTH) - position.x),
+             (position.y - ((centerCell.y - ring) * CELL_WORLD_WIDTH)),
+             (((centerCell.y + ring + 1) * CELL_WORLD_WIDTH) - position.y)})};
+        float ringDistanceSquared{ringDistance * ringDistance};
+        if ((ringDistanceSquared > maxRadiusSquared)
+            || ((nearestEntities.size() == count)
+                && (nearestEntities.back().first <= ringDistanceSquared))) {
+            break;
+        }
+    }
+
+    for (const auto& [distanceSquared, entity] : nearestEntities) {
+        outEntities.push_back(entity);
+    }
+}
+
+entt::entity EntityLocator::getFirstCollision(const Position& start,
+                                              const Position& end,
+                                              const EntityFilter& filter) const
+{
+    // DDA Algorithm Ref: https://lodev.org/cgtutor/raycasting.html
+    //                    http://www.cse.yorku.ca/~amana/research/grid.pdf
+
+    // Build a ray along the segment, so t is in world units.
+    Ray ray{start, (end.x - start.x), (end.y - start.y), (end.z - start.z)};
+    const float length{std::sqrt(start.squaredDistanceTo(end))};
+    if (length == 0) {
+        return entt::null;
+    }
+    ray.normalize();
+
+    // Clip the segment to the grid's bounds.
+    BoundingBox gridBounds{
+        (gridCellExtent.x * CELL_WORLD_WIDTH),
+        ((gridCellExtent.x + gridCellExtent.xLength) * CELL_WORLD_WIDTH),
+        (gridCellExtent.y * CELL_WORLD_WIDTH),
+        ((gridCellExtent.y + gridCellExtent.yLength) * CELL_WORLD_WIDTH),
+        (gridCellExtent.z * CELL_WORLD_HEIGHT),
+        ((gridCellExtent.z + gridCellExtent.zLength) * CELL_WORLD_HEIGHT)};
+    float segmentTMin{0};
+    float segmentTMax{length};
+    if (!clipRayToBox(ray, gridBounds, segmentTMin, segmentTMax)) {
+        return entt::null;
+    }
+
+    // Find the cell that the clipped segment starts in.
+    // Note: We clamp to the grid, in case of float error at its edges.
+    CellPosition cellPosition{
+        toCellPosition(ray.getPositionAtT(segmentTMin))};
+    cellPosition.x = std::clamp(cellPosition.x, gridCellExtent.x,
+                                gridCellExtent.xMax());
+    cellPosition.y = std::clamp(cellPosition.y, gridCellExtent.y,
+                                gridCellExtent.yMax());
+    cellPosition.z = std::clamp(cellPosition.z, gridCellExtent.z,
+                                gridCellExtent.zMax());
+
+    // For each axis, calc which way we step, the t at which we cross into
+    // the next cell, and how much t it takes to cross a whole cell.
+    static constexpr float INFINITE_T{std::numeric_limits<float>::infinity()};
+    auto initAxis = [](float origin, float direction, int cell,
+                       float cellWidth, int& step, float& nextT,
+                       float& deltaT) {
+        if (direction > 0) {
+            step = 1;
+            nextT = (((cell + 1) * cellWidth) - origin) / direction;
+            deltaT = cellWidth / direction;
+        }
+        else if (direction < 0) {
+            step = -1;
+            nextT = ((cell * cellWidth) - origin) / direction;
+            deltaT = cellWidth / -direction;
+        }
+        else {
+            step = 0;
+            nextT = INFINITE_T;
+            deltaT = INFINITE_T;
+        }
+    };
+    int stepX{};
+    int stepY{};
+    int stepZ{};
+    float nextTX{};
+    float nextTY{};
+    float nextTZ{};
+    float deltaTX{};
+    float deltaTY{};
+    float deltaTZ{};
+    initAxis(ray.origin.x, ray.directionX, cellPosition.x, CELL_WORLD_WIDTH,
+             stepX, nextTX, deltaTX);
+    initAxis(ray.origin.y, ray.directionY, cellPosition.y, CELL_WORLD_WIDTH,
+             stepY, nextTY, deltaTY);
+    initAxis(ray.origin.z, ray.directionZ, cellPosition.z, CELL_WORLD_HEIGHT,
+             stepZ, nextTZ, deltaTZ);
+
+    // Walk along the segment, checking each cell for a hit entity.
+    entt::entity closestEntity{entt::null};
+    float closestT{length};
+    while (true) {
+        const Cell& cell{entityGrid[linearizeCellIndex(cellPosition)]};
+        for (std::size_t i{0}; i < cell.entities.size(); ++i) {
+            BoundingBox bounds{cell.minXs[i], cell.maxXs[i], cell.minYs[i],
+                               cell.maxYs[i], cell.minZs[i], cell.maxZs[i]};
+            float hitTMin{0};
+            float hitTMax{closestT};
+            if (!clipRayToBox(ray, bounds, hitTMin, hitTMax)
+                || ((closestEntity != entt::null) && (hitTMin >= closestT))
+                || (filter && !(filter(cell.entities[i])))) {
+                continue;
+            }
+
+            closestEntity = cell.entities[i];
+            closestT = hitTMin;
+        }
+
+        // If we've hit something before leaving this cell, nothing further
+        // along can be closer.
+        float cellExitT{std::min({nextTX, nextTY, nextTZ})};
+        if (((closestEntity != entt::null) && (closestT <= cellExitT))
+            || (cellExitT > segmentTMax)) {
+            break;
+        }
+
+        // Move to the next cell along the segment.
+        if ((nextTX <= nextTY) && (nextTX <= nextTZ)) {
+            cellPosition.x += stepX;
+            nextTX += deltaTX;
+        }
+        else if (nextTY <= nextTZ) {
+            cellPosition.y += stepY;
+            nextTY += deltaTY;
+        }
+        else {
+            cellPosition.z += stepZ;
+            nextTZ += deltaTZ;
+        }
+
+        if (!(gridCellExtent.containsPosition(cellPosition))) {
+            break;
+        }
+    }
+
+    return closestEntity;
+}
+
 void EntityLocator::removeEntity(entt::entity entity)
 {
     auto entityIt{entityMap.find(entity)};
@@ -210,31 +550,20 @@ void EntityLocator::removeEntity(entt::entity entity)
 
 std::vector<entt::entity>&
     EntityLocator::getEntitiesCoarse(const Cylinder& cylinder)
+{
+    getEntitiesCoarse(cylinder, returnVector);
+
+    return returnVector;
+}
+
+void EntityLocator::getEntitiesCoarse(
+    const Cylinder& cylinder, std::vector<entt::entity>& outEntities) const
 {
     // Clear the return vector.
-    returnVector.clear();
+    outEntities.clear();
 
     // Calc the cell extent that is intersected by the cylinder.
-    CellExtent cylinderCellExtent{};
-    cylinderCellExtent.x = static_cast<int>(
-        std::floor((cylinder.center.x - cylinder.radius) / CELL_WORLD_WIDTH));
-    cylinderCellExtent.y = static_cast<int>(
-        std::floor((cylinder.center.y - cylinder.radius) / CELL_WORLD_WIDTH));
-    // TODO: This is incorrect
-    cylinderCellExtent.z = static_cast<int>(
-        std::floor((cylinder.center.z - cylinder.radius) / CELL_WORLD_HEIGHT));
-    cylinderCellExtent.xLength
-        = (static_cast<int>(std::ceil((cylinder.center.x + cylinder.radius)
-                                      / CELL_WORLD_WIDTH))
-           - cylinderCellExtent.x);
-    cylinderCellExtent.yLength
-        = (static_cast<int>(std::ceil((cylinder.center.y + cylinder.radius)
-                                      / CELL_WORLD_WIDTH))
-           - cylinderCellExtent.y);
-    cylinderCellExtent.zLength
-        = (static_cast<int>(std::ceil((cylinder.center.z + cylinder.radius)
-                                      / CELL_WORLD_HEIGHT))
-           - cylinderCellExtent.z);
+    CellExtent cylinderCellExtent{cylinderToCellExtent(cylinder)};
 
     // Clip the extent to the grid's bounds.
     cylinderCellExtent.intersectWith(gridCellExtent);
@@ -246,27 +575,18 @@ std::vector<entt::entity>&
                  ++x) {
                 // Add the entities in this cell to the return vector.
                 std::size_t linearizedIndex{linearizeCellIndex({x, y, z})};
-                std::vector<entt::entity>& entityVec{
-                    entityGrid[linearizedIndex]};
-                returnVector.insert(returnVector.end(), entityVec.begin(),
-                                    entityVec.end());
+                const std::vector<entt::entity>& entityVec{
+                    entityGrid[linearizedIndex].entities};
+                outEntities.insert(outEntities.end(), entityVec.begin(),
+                                   entityVec.end());
             }
         }
     }
 
     // Remove duplicates from the return vector.
-    std::sort(returnVector.begin(), returnVector.end());
-    returnVector.erase(std::unique(returnVector.begin(), returnVector.end()),
-                       returnVector.end());
-
-    return returnVector;
-}
-
-std::vector<entt::entity>&
-    EntityLocator::getEntitiesCoarse(const BoundingBox& boundingBox)
-{
-    // Convert to TileExtent.
-    return getEntitiesCoarse(boundingBox.asTileExtent());
+    std::sort(outEntities.begin(), outEntities.end());
+    outEntities.erase(std::unique(outEntities.begin(), outEntities.end()),
+                      outEntities.end());
 }
 
 std::vector<entt::entity>&
@@ -288,7 +608,7 @@ std::vector<entt::entity>&
                 // Add the entities in this cell to the return vector.
                 std::size_t linearizedIndex{linearizeCellIndex({x, y, z})};
                 std::vector<entt::entity>& entityVec{
-                    entityGrid[linearizedIndex]};
+                    entityGrid[linearizedIndex].entities};
                 returnVector.insert(returnVector.end(), entityVec.begin(),
                                     entityVec.end());
             }
@@ -321,20 +641,186 @@ void EntityLocator::clearEntityLocation(entt::entity entity,
             for (int x{clearExtent.x}; x <= clearExtent.xMax(); ++x) {
                 // Find the entity in this cell's entity vector.
                 std::size_t linearizedIndex{linearizeCellIndex({x, y, z})};
-                std::vector<entt::entity>& entityVec{
-                    entityGrid[linearizedIndex]};
-                auto entityIt{
-                    std::find(entityVec.begin(), entityVec.end(), entity)};
-
-                // Remove the entity from this cell's entity vector.
-                if (entityIt != entityVec.end()) {
-                    entityVec.erase(entityIt);
+                Cell& cell{entityGrid[linearizedIndex]};
+                auto entityIt{std::find(cell.entities.begin(),
+                                        cell.entities.end(), entity)};
+
+                // Remove the entity and its bounds from this cell, by
+                // swapping in the last element.
+                if (entityIt != cell.entities.end()) {
+                    std::size_t index{static_cast<std::size_t>(
+                        entityIt - cell.entities.begin())};
+                    cell.entities[index] = cell.entities.back();
+                    cell.minXs[index] = cell.minXs.back();
+                    cell.maxXs[index] = cell.maxXs.back();
+                    cell.minYs[index] = cell.minYs.back();
+                    cell.maxYs[index] = cell.maxYs.back();
+                    cell.minZs[index] = cell.minZs.back();
+                    cell.maxZs[index] = cell.maxZs.back();
+                    cell.entities.pop_back();
+                    cell.minXs.pop_back();
+                    cell.maxXs.pop_back();
+                    cell.minYs.pop_back();
+                    cell.maxYs.pop_back();
+                    cell.minZs.pop_back();
+                    cell.maxZs.pop_back();
                 }
             }
         }
     }
 }
 
+template<bool IncludeEdges>
+void EntityLocator::appendIntersecting(const Cell& cell,
+                                       const BoundingBox& bounds,
+                                       std::vector<entt::entity>& outEntities)
+{
+    std::size_t i{0};
+    std::size_t end{cell.entities.size()};
+
+#ifdef AM_LOCATOR_USE_SSE
+    // Picks the comparison that matches IncludeEdges.
+    auto lessThan = [](__m128 a, __m128 b) {
+        if constexpr (IncludeEdges) {
+            return _mm_cmple_ps(a, b);
+        }
+        else {
+            return _mm_cmplt_ps(a, b);
+        }
+    };
+
+    // Test 4 entities at a time, then add any hits.
+    const __m128 boundsMinX{_mm_set1_ps(bounds.minX)};
+    const __m128 boundsMaxX{_mm_set1_ps(bounds.maxX)};
+    const __m128 boundsMinY{_mm_set1_ps(bounds.minY)};
+    const __m128 boundsMaxY{_mm_set1_ps(bounds.maxY)};
+    const __m128 boundsMinZ{_mm_set1_ps(bounds.minZ)};
+    const __m128 boundsMaxZ{_mm_set1_ps(bounds.maxZ)};
+    for (; (i + 4) <= end; i += 4) {
+        __m128 hit{
+            _mm_and_ps(lessThan(_mm_loadu_ps(&(cell.minXs[i])), boundsMaxX),
+                       lessThan(boundsMinX, _mm_loadu_ps(&(cell.maxXs[i]))))};
+        hit = _mm_and_ps(hit,
+                         lessThan(_mm_loadu_ps(&(cell.minYs[i])), boundsMaxY));
+        hit = _mm_and_ps(hit,
+                         lessThan(boundsMinY, _mm_loadu_ps(&(cell.maxYs[i]))));
+        hit = _mm_and_ps(hit,
+                         lessThan(_mm_loadu_ps(&(cell.minZs[i])), boundsMaxZ));
+        hit = _mm_and_ps(hit,
+                         lessThan(boundsMinZ, _mm_loadu_ps(&(cell.maxZs[i]))));
+
+        int hitMask{_mm_movemask_ps(hit)};
+        for (std::size_t j{0}; hitMask != 0; ++j, hitMask >>= 1) {
+            if (hitMask & 1) {
+                outEntities.push_back(cell.entities[i + j]);
+            }
+        }
+    }
+#endif
+
+    // Test any remaining entities (or all of them, if SSE isn't available).
+    for (; i < end; ++i) {
+        bool hit{};
+        if constexpr (IncludeEdges) {
+            hit = (cell.minXs[i] <= bounds.maxX)
+                  && (bounds.minX <= cell.maxXs[i])
+                  && (cell.minYs[i] <= bounds.maxY)
+                  && (bounds.minY <= cell.maxYs[i])
+                  && (cell.minZs[i] <= bounds.maxZ)
+                  && (bounds.minZ <= cell.maxZs[i]);
+        }
+        else {
+            hit = (cell.minXs[i] < bounds.maxX)
+                  && (bounds.minX < cell.maxXs[i])
+                  && (cell.minYs[i] < bounds.maxY)
+                  && (bounds.minY < cell.maxYs[i])
+                  && (cell.minZs[i] < bounds.maxZ)
+                  && (bounds.minZ < cell.maxZs[i]);
+        }
+
+        if (hit) {
+            outEntities.push_back(cell.entities[i]);
+        }
+    }
+}
+
+CellPosition EntityLocator::toCellPosition(const Position& position)
+{
+    return {static_cast<int>(std::floor(position.x / CELL_WORLD_WIDTH)),
+            static_cast<int>(std::floor(position.y / CELL_WORLD_WIDTH)),
+            static_cast<int>(std::floor(position.z / CELL_WORLD_HEIGHT))};
+}
+
+bool EntityLocator::clipRayToBox(const Ray& ray, const BoundingBox& box,
+                                 float& tMin, float& tMax)
+{
+    auto clipAxis = [&](float origin, float direction, float min, float max) {
+        // If the ray is parallel to this axis, it's either always or never
+        // within the box's bounds.
+        if (direction == 0) {
+            return ((origin >= min) && (origin <= max));
+        }
+
+        float t1{(min - origin) / direction};
+        float t2{(max - origin) / direction};
+        tMin = std::max(tMin, std::min(t1, t2));
+        tMax = std::min(tMax, std::max(t1, t2));
+        return (tMin <= tMax);
+    };
+
+    return (clipAxis(ray.origin.x, ray.directionX, box.minX, box.maxX)
+            && clipAxis(ray.origin.y, ray.directionY, box.minY, box.maxY)
+            && clipAxis(ray.origin.z, ray.directionZ, box.minZ, box.maxZ));
+}
+
+CellExtent EntityLocator::boxToCellExtent(const BoundingBox& boundingBox)
+{
+    CellExtent boxCellExtent{};
+    boxCellExtent.x
+        = static_cast<int>(std::floor(boundingBox.minX / CELL_WORLD_WIDTH));
+    boxCellExtent.y
+        = static_cast<int>(std::floor(boundingBox.minY / CELL_WORLD_WIDTH));
+    boxCellExtent.z
+        = static_cast<int>(std::floor(boundingBox.minZ / CELL_WORLD_HEIGHT));
+    boxCellExtent.xLength
+        = (static_cast<int>(std::ceil(boundingBox.maxX / CELL_WORLD_WIDTH))
+           - boxCellExtent.x);
+    boxCellExtent.yLength
+        = (static_cast<int>(std::ceil(boundingBox.maxY / CELL_WORLD_WIDTH))
+           - boxCellExtent.y);
+    boxCellExtent.zLength
+        = (static_cast<int>(std::ceil(boundingBox.maxZ / CELL_WORLD_HEIGHT))
+           - boxCellExtent.z);
+
+    return boxCellExtent;
+}
+
+CellExtent EntityLocator::cylinderToCellExtent(const Cylinder& cylinder)
+{
+    CellExtent cylinderCellExtent{};
+    cylinderCellExtent.x = static_cast<int>(
+        std::floor((cylinder.center.x - cylinder.radius) / CELL_WORLD_WIDTH));
+    cylinderCellExtent.y = static_cast<int>(
+        std::floor((cylinder.center.y - cylinder.radius) / CELL_WORLD_WIDTH));
+    // TODO: This is incorrect
+    cylinderCellExtent.z = static_cast<int>(
+        std::floor((cylinder.center.z - cylinder.radius) / CELL_WORLD_HEIGHT));
+    cylinderCellExtent.xLength
+        = (static_cast<int>(std::ceil((cylinder.center.x + cylinder.radius)
+                                      / CELL_WORLD_WIDTH))
+           - cylinderCellExtent.x);
+    cylinderCellExtent.yLength
+        = (static_cast<int>(std::ceil((cylinder.center.y + cylinder.radius)
+                                      / CELL_WORLD_WIDTH))
+           - cylinderCellExtent.y);
+    cylinderCellExtent.zLength
+        = (static_cast<int>(std::ceil((cylinder.center.z + cylinder.radius)
+                                      / CELL_WORLD_HEIGHT))
+           - cylinderCellExtent.z);
+
+    return cylinderCellExtent;
+}
+
 CellExtent EntityLocator::tileToCellExtent(const TileExtent& tileExtent)
 {
     // Cast constants to float so we get float division below.
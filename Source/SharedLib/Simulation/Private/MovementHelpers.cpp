@@ -3,6 +3,9 @@
 #include "PreviousPosition.h"
 #include "BoundingBox.h"
 #include "TileMapBase.h"
+#include "Chunk.h"
+#include "ChunkPosition.h"
+#include "TilePosition.h"
 #include "EntityLocator.h"
 #include "IsClientEntity.h"
 #include "SharedConfig.h"
@@ -105,47 +108,93 @@ BoundingBox MovementHelpers::resolveCollisions(const BoundingBox& currentBounds,
         return currentBounds;
     }
 
+    // If the desired movement would intersect any tile collision, reject 
+    // the move.
+    if (intersectsTileCollision(desiredBounds, tileMap)) {
+        return currentBounds;
+    }
+
+    // If any non-client entity (besides the entity trying to move) intersects
+    // the desired bounds, reject the move.
+    std::vector<entt::entity>& collidedEntities{
+        entityLocator.getCollisions(desiredBounds)};
+    for (entt::entity collidedEntity : collidedEntities) {
+        if ((collidedEntity != movingEntity)
+            && !(registry.all_of<IsClientEntity>(collidedEntity))) {
+            return currentBounds;
+        }
+    }
+
+    return desiredBounds;
+}
+
+bool MovementHelpers::intersectsTileCollision(const BoundingBox& bounds,
+                                              const TileMapBase& tileMap)
+{
+    const TileExtent boxTileExtent{bounds.asTileExtent()};
+    const TileExtent mapExtent{tileMap.getTileExtent()};
+
     // Check for vertical collision up to 1 tile above and below the bounds.
     int minZ{boxTileExtent.z - 1};
     minZ = std::max(minZ, mapExtent.z);
     int maxZ{boxTileExtent.zMax() + 1};
     maxZ = std::min(maxZ, mapExtent.zMax());
 
-    // For each tile that the desired bounds is touching.
+    // Find the chunks that the desired bounds' tiles are in.
+    const ChunkPosition minChunk{
+        TilePosition{boxTileExtent.x, boxTileExtent.y, minZ}};
+    const ChunkPosition maxChunk{
+        TilePosition{boxTileExtent.xMax(), boxTileExtent.yMax(), maxZ}};
+
+    // For each chunk that the desired bounds is touching.
+    static constexpr int CHUNK_WIDTH{SharedConfig::CHUNK_WIDTH};
     for (int z{minZ}; z <= maxZ; ++z) {
-        for (int y{boxTileExtent.y}; y <= boxTileExtent.yMax(); ++y) {
-            for (int x{boxTileExtent.x}; x <= boxTileExtent.xMax(); ++x) {
-                // If this tile doesn't exist, it's empty so we can skip it.
-                const Tile* tile{tileMap.cgetTile({x, y, z})};
-                if (!tile) {
+        for (int cY{minChunk.y}; cY <= maxChunk.y; ++cY) {
+            for (int cX{minChunk.x}; cX <= maxChunk.x; ++cX) {
+                // If this chunk doesn't exist, it's empty so we can skip it.
+                const Chunk* chunk{tileMap.cgetChunk({cX, cY, z})};
+                if (!chunk) {
                     continue;
                 }
 
-                // For each collision volume in this tile.
-                for (const BoundingBox& collisionVolume :
-                     tile->getCollisionVolumes()) {
-                    // If the desired movement would intersect this volume, 
-                    // reject the move.
-                    if (desiredBounds.intersects(collisionVolume)) {
-                        return currentBounds;
-                    }
+                // Test the collision volumes of the tiles that the bounds 
+                // touch.
+                // Note: Volumes from tiles outside of the bounds' tile 
+                //       extent are never tested, regardless of which 
+                //       chunk they're in.
+                const int chunkOriginX{cX * CHUNK_WIDTH};
+                const int chunkOriginY{cY * CHUNK_WIDTH};
+                if (chunk->collisionIndex.intersectsAny(
+                        bounds, (boxTileExtent.x - chunkOriginX),
+                        (boxTileExtent.y - chunkOriginY),
+                        (boxTileExtent.xMax() - chunkOriginX),
+                        (boxTileExtent.yMax() - chunkOriginY))) {
+                    return true;
                 }
             }
         }
     }
 
-    // If any non-client entity (besides the entity trying to move) intersects
-    // the desired bounds, reject the move.
-    std::vector<entt::entity>& collidedEntities{
-        entityLocator.getCollisions(desiredBounds)};
-    for (entt::entity collidedEntity : collidedEntities) {
-        if ((collidedEntity != movingEntity)
-            && !(registry.all_of<IsClientEntity>(collidedEntity))) {
-            return currentBounds;
-        }
-    }
+    return false;
+}
 
-    return desiredBounds;
+ChunkExtent
+    MovementHelpers::getTileCollisionChunkExtent(const BoundingBox& bounds)
+{
+    // Note: This must match the chunks that intersectsTileCollision() visits.
+    const TileExtent boxTileExtent{bounds.asTileExtent()};
+    const ChunkPosition minChunk{TilePosition{
+        boxTileExtent.x, boxTileExtent.y, (boxTileExtent.z - 1)}};
+    const ChunkPosition maxChunk{TilePosition{boxTileExtent.xMax(),
+                                              boxTileExtent.yMax(),
+                                              (boxTileExtent.zMax() + 1)}};
+
+    return {minChunk.x,
+            minChunk.y,
+            minChunk.z,
+            (maxChunk.x - minChunk.x + 1),
+            (maxChunk.y - minChunk.y + 1),
+            (maxChunk.z - minChunk.z + 1)};
 }
 
 Rotation::Direction MovementHelpers::directionIntToDirection(int directionInt)
@@ -0,0 +1,162 @@
+#include "ChunkCollisionIndex.h"
+#include "Chunk.h"
+#include "Tile.h"
+#include "BoundingBox.h"
+#include <algorithm>
+
+// SSE2 is part of the x86-64 baseline, so we only need to check for it on
+// other architectures.
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)                  \
+    || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define AM_COLLISION_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace AM
+{
+void ChunkCollisionIndex::rebuild(const Chunk& chunk)
+{
+    minXs.clear();
+    maxXs.clear();
+    minYs.clear();
+    maxYs.clear();
+    minZs.clear();
+    maxZs.clear();
+
+    // Gather each tile's volumes.
+    for (Uint16 y{0}; y < CHUNK_WIDTH; ++y) {
+        for (Uint16 x{0}; x < CHUNK_WIDTH; ++x) {
+            tileStarts[(y * CHUNK_WIDTH) + x]
+                = static_cast<Uint32>(minXs.size());
+
+            const Tile& tile{chunk.getTile(x, y)};
+            for (const BoundingBox& volume : tile.getCollisionVolumes()) {
+                minXs.push_back(volume.minX);
+                maxXs.push_back(volume.maxX);
+                minYs.push_back(volume.minY);
+                maxYs.push_back(volume.maxY);
+                minZs.push_back(volume.minZ);
+                maxZs.push_back(volume.maxZ);
+            }
+        }
+    }
+    tileStarts[CHUNK_TILE_COUNT] = static_cast<Uint32>(minXs.size());
+}
+
+void ChunkCollisionIndex::updateTile(Uint16 tileX, Uint16 tileY,
+                                     const Tile& tile)
+{
+    std::size_t tileIndex{(tileY * CHUNK_WIDTH) + tileX};
+    std::size_t begin{tileStarts[tileIndex]};
+    std::size_t end{tileStarts[tileIndex + 1]};
+    const std::vector<BoundingBox>& volumes{tile.getCollisionVolumes()};
+
+    // Replace the tile's old values with its new ones.
+    auto replaceValues = [&](std::vector<float>& values,
+                             float BoundingBox::*member) {
+        auto it{values.erase((values.begin() + begin),
+                             (values.begin() + end))};
+        for (const BoundingBox& volume : volumes) {
+            it = values.insert(it, volume.*member);
+            ++it;
+        }
+    };
+    replaceValues(minXs, &BoundingBox::minX);
+    replaceValues(maxXs, &BoundingBox::maxX);
+    replaceValues(minYs, &BoundingBox::minY);
+    replaceValues(maxYs, &BoundingBox::maxY);
+    replaceValues(minZs, &BoundingBox::minZ);
+    replaceValues(maxZs, &BoundingBox::maxZ);
+
+    // Shift the start of every following tile.
+    Sint64 sizeChange{static_cast<Sint64>(volumes.size())
+                      - static_cast<Sint64>(end - begin)};
+    if (sizeChange != 0) {
+        for (std::size_t i{tileIndex + 1}; i <= CHUNK_TILE_COUNT; ++i) {
+            tileStarts[i] = static_cast<Uint32>(tileStarts[i] + sizeChange);
+        }
+    }
+}
+
+bool ChunkCollisionIndex::intersectsAny(const BoundingBox& bounds,
+                                        int firstX, int firstY, int lastX,
+                                        int lastY) const
+{
+    static constexpr int LAST_TILE{static_cast<int>(CHUNK_WIDTH) - 1};
+    firstX = std::max(firstX, 0);
+    firstY = std::max(firstY, 0);
+    lastX = std::min(lastX, LAST_TILE);
+    lastY = std::min(lastY, LAST_TILE);
+    if ((firstX > lastX) || (firstY > lastY)) {
+        return false;
+    }
+
+    // Each row's tiles are stored contiguously, so we can test each row's 
+    // run of tiles at once.
+    // Note: If the run spans the full width, the rows are contiguous too.
+    if ((firstX == 0) && (lastX == LAST_TILE)) {
+        return intersectsAny(bounds, tileStarts[firstY * CHUNK_WIDTH],
+                             tileStarts[(lastY + 1) * CHUNK_WIDTH]);
+    }
+    for (int y{firstY}; y <= lastY; ++y) {
+        std::size_t rowStart{static_cast<std::size_t>(y) * CHUNK_WIDTH};
+        if (intersectsAny(bounds, tileStarts[rowStart + firstX],
+                          tileStarts[rowStart + lastX + 1])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ChunkCollisionIndex::intersectsAny(const BoundingBox& bounds,
+                                        std::size_t begin,
+                                        std::size_t end) const
+{
+    std::size_t i{begin};
+
+    // Note: These tests must match BoundingBox::intersects(), so that
+    //       results don't change based on which path was taken.
+#ifdef AM_COLLISION_USE_SSE
+    const __m128 boundsMinX{_mm_set1_ps(bounds.minX)};
+    const __m128 boundsMaxX{_mm_set1_ps(bounds.maxX)};
+    const __m128 boundsMinY{_mm_set1_ps(bounds.minY)};
+    const __m128 boundsMaxY{_mm_set1_ps(bounds.maxY)};
+    const __m128 boundsMinZ{_mm_set1_ps(bounds.minZ)};
+    const __m128 boundsMaxZ{_mm_set1_ps(bounds.maxZ)};
+    for (; (i + 4) <= end; i += 4) {
+        __m128 hit{_mm_and_ps(
+            _mm_cmplt_ps(_mm_loadu_ps(&(minXs[i])), boundsMaxX),
+            _mm_cmpgt_ps(_mm_loadu_ps(&(maxXs[i])), boundsMinX))};
+        hit = _mm_and_ps(hit, _mm_cmplt_ps(_mm_loadu_ps(&(minYs[i])),
+                                           boundsMaxY));
+        hit = _mm_and_ps(hit, _mm_cmpgt_ps(_mm_loadu_ps(&(maxYs[i])),
+                                           boundsMinY));
+        hit = _mm_and_ps(hit, _mm_cmplt_ps(_mm_loadu_ps(&(minZs[i])),
+                                           boundsMaxZ));
+        hit = _mm_and_ps(hit, _mm_cmpgt_ps(_mm_loadu_ps(&(maxZs[i])),
+                                           boundsMinZ));
+        if (_mm_movemask_ps(hit) != 0) {
+            return true;
+        }
+    }
+#endif
+
+    // Test any remaining volumes (or all of them, if SSE isn't available).
+    for (; i < end; ++i) {
+        if ((minXs[i] < bounds.maxX) && (maxXs[i] > bounds.minX)
+            && (minYs[i] < bounds.maxY) && (maxYs[i] > bounds.minY)
+            && (minZs[i] < bounds.maxZ) && (maxZs[i] > bounds.minZ)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::size_t ChunkCollisionIndex::getVolumeCount() const
+{
+    return minXs.size();
+}
+
+} // End namespace AM
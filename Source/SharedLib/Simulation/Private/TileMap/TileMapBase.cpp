@@ -10,6 +10,7 @@
 #include "ChunkWireSnapshot.h"
 #include "Morton.h"
 #include "SharedConfig.h"
+#include "ThreadPool.h"
 #include "Timer.h"
 #include "Log.h"
 #include "AMAssert.h"
@@ -28,6 +29,9 @@ TileMapBase::TileMapBase(GraphicDataBase& inGraphicData, bool inTrackTileUpdates
 , chunks{}
 , autoRebuildCollision{true}
 , dirtyCollisionQueue{}
+, dirtyCollisionChunks{}
+, trackCollisionChanges{false}
+, collisionChangeHistory{}
 , trackTileUpdates{inTrackTileUpdates}
 , tileUpdateHistory{}
 {
@@ -424,7 +428,7 @@ const Chunk* TileMapBase::getChunk(const ChunkPosition& chunkPosition) const
         return &(chunkIt->second);
     }
 
-    // The requested chunk is empty or out of bounds.
+    // The requested chunk is empty, out of bounds, or not loaded.
     return nullptr;
 }
 
@@ -456,6 +460,36 @@ const Tile* TileMapBase::cgetTile(const TilePosition& tilePosition) const
     return getTile(tilePosition);
 }
 
+const Chunk* TileMapBase::ensureChunkLoaded(const ChunkPosition& chunkPosition)
+{
+    auto chunkIt{chunks.find(chunkPosition)};
+    if (chunkIt != chunks.end()) {
+        return &(chunkIt->second);
+    }
+
+    // If the derived map lazily loads chunks, try to load this one.
+    if (chunkExtent.containsPosition(chunkPosition)) {
+        return materializeChunk(chunkPosition);
+    }
+
+    // The requested chunk is out of bounds.
+    return nullptr;
+}
+
+void TileMapBase::ensureChunksLoaded(const ChunkExtent& extent)
+{
+    ChunkExtent loadExtent{extent};
+    loadExtent.intersectWith(chunkExtent);
+
+    for (int z{loadExtent.z}; z <= loadExtent.zMax(); ++z) {
+        for (int y{loadExtent.y}; y <= loadExtent.yMax(); ++y) {
+            for (int x{loadExtent.x}; x <= loadExtent.xMax(); ++x) {
+                ensureChunkLoaded({x, y, z});
+            }
+        }
+    }
+}
+
 const ChunkExtent& TileMapBase::getChunkExtent() const
 {
     return chunkExtent;
@@ -483,16 +517,52 @@ void TileMapBase::rebuildDirtyTileCollision()
     auto lastIt{
         std::unique(dirtyCollisionQueue.begin(), dirtyCollisionQueue.end())};
 
-    // Rebuild the collision of any dirty tiles.
+    // Rebuild the collision of any dirty tiles, tracking which chunks they 
+    // belong to.
+    // Note: Tiles whose chunk was erased have no collision to rebuild, but 
+    //       their chunk's collision still changed.
+    dirtyCollisionChunks.clear();
     for (auto it{dirtyCollisionQueue.begin()}; it != lastIt; ++it) {
         if (auto tileResult{getTile(*it)}) {
             tileResult->tile.get().rebuildCollision(*it);
         }
+        dirtyCollisionChunks.emplace_back(*it);
+    }
+
+    // Rebuild each affected chunk's collision index once.
+    std::sort(dirtyCollisionChunks.begin(), dirtyCollisionChunks.end());
+    auto lastChunkIt{std::unique(dirtyCollisionChunks.begin(),
+                                 dirtyCollisionChunks.end())};
+    for (auto it{dirtyCollisionChunks.begin()}; it != lastChunkIt; ++it) {
+        auto chunkIt{chunks.find(*it)};
+        if (chunkIt != chunks.end()) {
+            chunkIt->second.collisionIndex.rebuild(chunkIt->second);
+        }
+
+        if (trackCollisionChanges) {
+            collisionChangeHistory.push_back(*it);
+        }
     }
 
     dirtyCollisionQueue.clear();
 }
 
+void TileMapBase::setTrackCollisionChanges(bool newTrackCollisionChanges)
+{
+    trackCollisionChanges = newTrackCollisionChanges;
+}
+
+const std::vector<ChunkPosition>&
+    TileMapBase::getCollisionChangeHistory() const
+{
+    return collisionChangeHistory;
+}
+
+void TileMapBase::clearCollisionChangeHistory()
+{
+    collisionChangeHistory.clear();
+}
+
 const std::vector<TileMapBase::TileUpdateVariant>&
     TileMapBase::getTileUpdateHistory()
 {
@@ -516,6 +586,39 @@ void TileMapBase::loadChunk(const ChunkWireSnapshot& chunkSnapshot,
     loadChunkInternal(chunkSnapshot, chunkPosition);
 }
 
+void TileMapBase::loadChunks(
+    std::span<const ChunkSnapshot* const> chunkSnapshots,
+    std::span<const ChunkPosition> chunkPositions, ThreadPool& threadPool)
+{
+    loadChunksInternal(chunkSnapshots, chunkPositions, threadPool);
+}
+
+void TileMapBase::loadChunks(
+    std::span<const ChunkWireSnapshot* const> chunkSnapshots,
+    std::span<const ChunkPosition> chunkPositions, ThreadPool& threadPool)
+{
+    loadChunksInternal(chunkSnapshots, chunkPositions, threadPool);
+}
+
+void TileMapBase::loadChunks(std::span<const ChunkWireSnapshot> chunkSnapshots,
+                             ThreadPool& threadPool)
+{
+    // Wire snapshots hold their own positions. Pull them out so we can share 
+    // the same path as ChunkSnapshot.
+    std::vector<const ChunkWireSnapshot*> snapshotPtrs{};
+    std::vector<ChunkPosition> chunkPositions{};
+    snapshotPtrs.reserve(chunkSnapshots.size());
+    chunkPositions.reserve(chunkSnapshots.size());
+    for (const ChunkWireSnapshot& chunkSnapshot : chunkSnapshots) {
+        snapshotPtrs.push_back(&chunkSnapshot);
+        chunkPositions.emplace_back(chunkSnapshot.x, chunkSnapshot.y,
+                                    chunkSnapshot.z);
+    }
+
+    loadChunksInternal<ChunkWireSnapshot>(snapshotPtrs, chunkPositions,
+                                          threadPool);
+}
+
 std::expected<std::reference_wrapper<Chunk>, TileMapBase::ChunkError>
     TileMapBase::getChunk(const ChunkPosition& chunkPosition)
 {
@@ -524,16 +627,26 @@ std::expected<std::reference_wrapper<Chunk>, TileMapBase::ChunkError>
         return std::unexpected{ChunkError::InvalidPosition};
     }
 
-    // Find the requested tile's parent chunk. If it doesn't exist, return an 
-    // error.
+    // Find the requested tile's parent chunk. If it doesn't exist and can't 
+    // be lazily loaded, return an error.
     auto chunkIt{chunks.find(chunkPosition)};
     if (chunkIt == chunks.end()) {
+        if (Chunk* chunk{materializeChunk(chunkPosition)}) {
+            return *chunk;
+        }
+
         return std::unexpected{ChunkError::NotFound};
     }
 
     return chunkIt->second;
 }
 
+Chunk* TileMapBase::materializeChunk(const ChunkPosition&)
+{
+    // By default, all chunks live in memory.
+    return nullptr;
+}
+
 std::expected<TileMapBase::ChunkTilePair, TileMapBase::ChunkError>
     TileMapBase::getTile(const TilePosition& tilePosition)
 {
@@ -660,9 +773,29 @@ void TileMapBase::addTileLayer(Chunk& chunk, Tile& tile,
 
 void TileMapBase::rebuildTileCollision(Tile& tile, const TilePosition& tilePosition)
 {
-    // If auto rebuild is enabled, rebuild the affected tile's collision.
+    // If auto rebuild is enabled, rebuild the affected tile's collision and 
+    // update its volumes in its chunk's collision index.
     if (autoRebuildCollision) {
+        ChunkPosition chunkPosition{tilePosition};
+        if (trackCollisionChanges) {
+            collisionChangeHistory.push_back(chunkPosition);
+        }
+
+        // If the tile's chunk was erased (the tile is now empty), there's 
+        // nothing to rebuild.
+        auto chunkIt{chunks.find(chunkPosition)};
+        if (chunkIt == chunks.end()) {
+            return;
+        }
+
         tile.rebuildCollision(tilePosition);
+
+        const int CHUNK_WIDTH{static_cast<int>(SharedConfig::CHUNK_WIDTH)};
+        int relativeTileX{tilePosition.x - (chunkPosition.x * CHUNK_WIDTH)};
+        int relativeTileY{tilePosition.y - (chunkPosition.y * CHUNK_WIDTH)};
+        chunkIt->second.collisionIndex.updateTile(
+            static_cast<Uint16>(relativeTileX),
+            static_cast<Uint16>(relativeTileY), tile);
     }
     else {
         // Not enabled. Queue the affected tile to have its collision rebuilt.
@@ -981,7 +1114,7 @@ bool TileMapBase::remNorthWall(const TilePosition& tilePosition)
             if (remTileLayers(
                     eastChunk, eastTile, ChunkPosition{eastTilePosition},
                     TileLayer::Type::Wall, Wall::Type::NorthWestGapFill)) {
-                rebuildTileCollision(eastTile, tilePosition);
+                rebuildTileCollision(eastTile, eastTilePosition);
             }
         }
     }
@@ -1021,7 +1154,7 @@ bool TileMapBase::remWestWall(const TilePosition& tilePosition)
             if (remTileLayers(
                     southChunk, southTile, ChunkPosition{southTilePosition},
                     TileLayer::Type::Wall, Wall::Type::NorthWestGapFill)) {
-                rebuildTileCollision(southTile, tilePosition);
+                rebuildTileCollision(southTile, southTilePosition);
             }
         }
 
@@ -1091,87 +1224,167 @@ template<typename T>
 void TileMapBase::loadChunkInternal(const T& chunkSnapshot,
                                     const ChunkPosition& chunkPosition)
 {
-    // Note: We can't use the set/add functions because they'll push updates
-    //       into the history, and addWall() adds extra walls.
-
-    // If the chunk doesn't exist, create it.
-    Chunk* chunk{getOrCreateChunk(chunkPosition)};
-    if (!chunk) {
+    if (!(chunkExtent.containsPosition(chunkPosition))) {
         LOG_FATAL("Invalid chunk position.");
         return;
     }
 
+    // Build the chunk, then replace any existing chunk with it.
+    std::vector<const GraphicSet*> palette{};
+    resolvePalette(chunkSnapshot, palette);
+
+    Chunk chunk{};
+    buildChunk(chunkSnapshot, palette, chunkPosition, chunk);
+    insertChunk(chunkPosition, std::move(chunk));
+}
+
+template<typename T>
+void TileMapBase::loadChunksInternal(std::span<const T* const> chunkSnapshots,
+                                     std::span<const ChunkPosition> chunkPositions,
+                                     ThreadPool& threadPool)
+{
+    AM_ASSERT(chunkSnapshots.size() == chunkPositions.size(),
+              "Snapshot and position counts must match.");
+
+    // Resolve each chunk's palette.
+    // Note: We do this first because graphic set lookups aren't thread-safe.
+    std::size_t chunkCount{chunkSnapshots.size()};
+    std::vector<std::vector<const GraphicSet*>> palettes(chunkCount);
+    for (std::size_t i{0}; i < chunkCount; ++i) {
+        if (!(chunkExtent.containsPosition(chunkPositions[i]))) {
+            LOG_FATAL("Invalid chunk position.");
+            return;
+        }
+
+        resolvePalette(*(chunkSnapshots[i]), palettes[i]);
+    }
+
+    // Build the chunks in parallel. Each chunk only touches its own data.
+    std::vector<Chunk> builtChunks(chunkCount);
+    threadPool.parallelFor(chunkCount, [&](std::size_t i) {
+        buildChunk(*(chunkSnapshots[i]), palettes[i], chunkPositions[i],
+                   builtChunks[i]);
+    });
+
+    // Add the built chunks to the map.
+    for (std::size_t i{0}; i < chunkCount; ++i) {
+        insertChunk(chunkPositions[i], std::move(builtChunks[i]));
+    }
+}
+
+template<typename T>
+void TileMapBase::resolvePalette(const T& chunkSnapshot,
+                                 std::vector<const GraphicSet*>& outPalette)
+{
+    outPalette.clear();
+    outPalette.reserve(chunkSnapshot.palette.size());
+    for (const auto& paletteEntry : chunkSnapshot.palette) {
+        switch (paletteEntry.layerType) {
+            case TileLayer::Type::Terrain: {
+                outPalette.push_back(&(graphicData.getTerrainGraphicSet(
+                    paletteEntry.graphicSetID)));
+                break;
+            }
+            case TileLayer::Type::Floor: {
+                outPalette.push_back(&(
+                    graphicData.getFloorGraphicSet(paletteEntry.graphicSetID)));
+                break;
+            }
+            case TileLayer::Type::Wall: {
+                outPalette.push_back(&(
+                    graphicData.getWallGraphicSet(paletteEntry.graphicSetID)));
+                break;
+            }
+            case TileLayer::Type::Object: {
+                outPalette.push_back(&(graphicData.getObjectGraphicSet(
+                    paletteEntry.graphicSetID)));
+                break;
+            }
+            default: {
+                outPalette.push_back(nullptr);
+                break;
+            }
+        }
+    }
+}
+
+template<typename T>
+void TileMapBase::buildChunk(const T& chunkSnapshot,
+                             const std::vector<const GraphicSet*>& palette,
+                             const ChunkPosition& chunkPosition,
+                             Chunk& outChunk)
+{
+    // Note: We can't use the set/add functions because they'll push updates
+    //       into the history, and addWall() adds extra walls.
+    static constexpr int CHUNK_WIDTH{
+        static_cast<int>(SharedConfig::CHUNK_WIDTH)};
+
     // Iterate each of the tiles in the chunk snapshot.
     std::size_t currentTileLayerStartIndex{0};
     std::size_t currentTileIndex{0};
     std::size_t currentTileOffsetIndex{0};
     for (Uint8 tileLayerCount : chunkSnapshot.tileLayerCounts) {
-        Tile& tile{chunk->tiles[currentTileIndex]};
-        tile.clear();
+        Tile& tile{outChunk.tiles[currentTileIndex]};
         bool rebuildCollision{false};
 
-        // Add each of this tile's layers to the map.
+        // Add each of this tile's layers to the chunk.
         for (std::size_t i{0}; i < tileLayerCount; ++i) {
             Uint8 paletteIndex{
                 chunkSnapshot.tileLayers[currentTileLayerStartIndex + i]};
             const auto& paletteEntry{chunkSnapshot.palette[paletteIndex]};
+            const GraphicSet* graphicSet{palette[paletteIndex]};
+            if (!graphicSet) {
+                LOG_FATAL("Graphic set was not found for loaded tile layer.");
+            }
 
-            // Get this layer's graphic set and (if Floor/Object) tile offset.
-            const GraphicSet* graphicSet{nullptr};
+            // If Floor/Object, get this layer's tile offset.
             TileOffset tileOffset{};
-            switch (paletteEntry.layerType) {
-                case TileLayer::Type::Terrain: {
-                    graphicSet = &(graphicData.getTerrainGraphicSet(
-                        paletteEntry.graphicSetID));
-                    rebuildCollision = true;
-                    break;
-                }
-                case TileLayer::Type::Floor: {
-                    graphicSet = &(graphicData.getFloorGraphicSet(
-                        paletteEntry.graphicSetID));
-                    tileOffset
-                        = chunkSnapshot.tileOffsets[currentTileOffsetIndex++];
-                    break;
-                }
-                case TileLayer::Type::Wall: {
-                    graphicSet = &(graphicData.getWallGraphicSet(
-                        paletteEntry.graphicSetID));
-                    rebuildCollision = true;
-                    break;
-                }
-                case TileLayer::Type::Object: {
-                    graphicSet = &(graphicData.getObjectGraphicSet(
-                        paletteEntry.graphicSetID));
-                    tileOffset
-                        = chunkSnapshot.tileOffsets[currentTileOffsetIndex++];
-                    rebuildCollision = true;
-                    break;
-                }
-                default: {
-                    break;
-                }
+            if ((paletteEntry.layerType == TileLayer::Type::Floor)
+                || (paletteEntry.layerType == TileLayer::Type::Object)) {
+                tileOffset
+                    = chunkSnapshot.tileOffsets[currentTileOffsetIndex++];
             }
 
-            if (!graphicSet) {
-                LOG_FATAL("Graphic set was not found for loaded tile layer.");
+            // Terrain, Walls, and Objects have collision.
+            if (paletteEntry.layerType != TileLayer::Type::Floor) {
+                rebuildCollision = true;
             }
 
             // Add the layer to the tile.
-            addTileLayer(*chunk, tile, tileOffset, paletteEntry.layerType,
+            addTileLayer(outChunk, tile, tileOffset, paletteEntry.layerType,
                          *graphicSet, paletteEntry.graphicValue);
         }
 
-        // Rebuild the tile's collision if necessary.
+        // Build the tile's collision if necessary.
+        // Note: Collision only depends on the tile's own layers, so we can 
+        //       build it immediately instead of queueing it.
         if (rebuildCollision) {
             Morton::Result2D xyValues{Morton::m2D_reverse_lookup_16x16(
                 static_cast<Uint8>(currentTileIndex))};
-            rebuildTileCollision(tile,
-                                 {xyValues.x, xyValues.y, chunkPosition.z});
+            tile.rebuildCollision(
+                {((chunkPosition.x * CHUNK_WIDTH) + xyValues.x),
+                 ((chunkPosition.y * CHUNK_WIDTH) + xyValues.y),
+                 chunkPosition.z});
         }
 
         currentTileLayerStartIndex += tileLayerCount;
         currentTileIndex++;
     }
+
+    // Build the chunk's collision index.
+    outChunk.collisionIndex.rebuild(outChunk);
+}
+
+void TileMapBase::insertChunk(const ChunkPosition& chunkPosition, Chunk&& chunk)
+{
+    // If the chunk is empty, make sure it doesn't exist in the map (we don't 
+    // keep empty chunks around).
+    if (chunk.tileLayerCount == 0) {
+        chunks.erase(chunkPosition);
+        return;
+    }
+
+    chunks.insert_or_assign(chunkPosition, std::move(chunk));
 }
 
 } // End namespace AM
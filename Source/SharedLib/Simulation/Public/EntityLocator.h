@@ -5,6 +5,7 @@
 #include "TileExtent.h"
 #include "ChunkExtent.h"
 #include "entt/fwd.hpp"
+#include <functional>
 #include <vector>
 #include <unordered_map>
 
@@ -13,6 +14,7 @@ namespace AM
 struct Position;
 struct Cylinder;
 struct BoundingBox;
+struct Ray;
 
 /**
  * A spatial partitioning grid that tracks where entities are located.
@@ -27,6 +29,10 @@ struct BoundingBox;
 class EntityLocator
 {
 public:
+    /** Used to narrow down query results. Returns true if the given entity
+        should be included. */
+    using EntityFilter = std::function<bool(entt::entity)>;
+
     EntityLocator(entt::registry& inRegistry);
 
     /**
@@ -39,6 +45,9 @@ public:
      * Sets the given entity's location to the location of the given bounding
      * box.
      *
+     * Note: The collision queries test against the given box, so it should
+     *       match the entity's Collision::worldBounds.
+     *
      * Note: Assumes all values are valid. Don't pass in values that are
      *       outside of the map bounds.
      *
@@ -56,6 +65,16 @@ public:
      */
     std::vector<entt::entity>& getEntities(const Cylinder& cylinder);
 
+    /**
+     * Overload that writes into the given vector instead of returning our 
+     * shared one.
+     *
+     * Since this doesn't modify the locator, it's safe to call from multiple 
+     * threads at once, as long as nothing is moving entities.
+     */
+    void getEntities(const Cylinder& cylinder,
+                     std::vector<entt::entity>& outEntities) const;
+
     /**
      * Overload for TileExtent.
      */
@@ -76,6 +95,13 @@ public:
      */
     std::vector<entt::entity>& getCollisions(const Cylinder& cylinder);
 
+    /**
+     * Overload that writes into the given vector. Thread safe in the same way 
+     * as the getEntities() overload.
+     */
+    void getCollisions(const Cylinder& cylinder,
+                       std::vector<entt::entity>& outEntities) const;
+
     /**
      * Overload for BoundingBox.
      */
@@ -91,6 +117,46 @@ public:
      */
     std::vector<entt::entity>& getCollisions(const ChunkExtent& chunkExtent);
 
+    /**
+     * Returns up to count entities whose positions are within maxRadius of
+     * the given position, sorted nearest first.
+     *
+     * Cells are searched in rings around the position. The search stops as
+     * soon as no unsearched cell could hold a nearer entity, so a small count
+     * only touches the nearby cells.
+     *
+     * @param filter  If given, only entities that it returns true for are
+     *                included. It's only called for entities that would
+     *                otherwise make the cut.
+     */
+    std::vector<entt::entity>&
+        getNearestEntities(const Position& position, std::size_t count,
+                           float maxRadius, const EntityFilter& filter = {});
+
+    /**
+     * Overload that writes into the given vector. Thread safe in the same way
+     * as the getEntities() overload.
+     */
+    void getNearestEntities(const Position& position, std::size_t count,
+                            float maxRadius,
+                            std::vector<entt::entity>& outEntities,
+                            const EntityFilter& filter = {}) const;
+
+    /**
+     * Returns the first entity whose collision box is hit by the line segment
+     * from start to end, or entt::null if none are hit.
+     *
+     * Cells are walked in order along the segment, stopping at the first cell
+     * that's past a hit. Useful for e.g. line of sight checks.
+     *
+     * Thread safe in the same way as the getEntities() overload.
+     *
+     * @param filter  If given, only entities that it returns true for can be
+     *                hit (e.g. to skip the entity that's looking).
+     */
+    entt::entity getFirstCollision(const Position& start, const Position& end,
+                                   const EntityFilter& filter = {}) const;
+
     /**
      * If we're tracking the given entity, removes it from the entityGrid and
      * entityMap.
@@ -118,10 +184,10 @@ private:
     std::vector<entt::entity>& getEntitiesCoarse(const Cylinder& cylinder);
 
     /**
-     * Overload for BoundingBox.
+     * Overload that writes into the given vector.
      */
-    std::vector<entt::entity>&
-        getEntitiesCoarse(const BoundingBox& boundingBox);
+    void getEntitiesCoarse(const Cylinder& cylinder,
+                           std::vector<entt::entity>& outEntities) const;
 
     /**
      * Overload for TileExtent.
@@ -134,6 +200,36 @@ private:
     std::vector<entt::entity>&
         getEntitiesCoarse(const ChunkExtent& chunkExtent);
 
+    /** A grid cell. */
+    struct Cell {
+        /** The entities that currently intersect this cell. */
+        std::vector<entt::entity> entities{};
+
+        /** Each entity's bounds, as structure-of-arrays. Lets the collision
+            queries test entities 4 at a time, without fetching their
+            Collision components. */
+        std::vector<float> minXs{};
+        std::vector<float> maxXs{};
+        std::vector<float> minYs{};
+        std::vector<float> maxYs{};
+        std::vector<float> minZs{};
+        std::vector<float> maxZs{};
+    };
+
+    /**
+     * Appends the entities in the given cell whose bounds intersect the given
+     * bounds.
+     *
+     * @tparam IncludeEdges  If true, bounds that only share an edge count as
+     *                       intersecting (matching
+     *                       BoundingBox::intersects(TileExtent)). Else, they
+     *                       don't (matching
+     *                       BoundingBox::intersects(BoundingBox)).
+     */
+    template<bool IncludeEdges>
+    static void appendIntersecting(const Cell& cell, const BoundingBox& bounds,
+                                   std::vector<entt::entity>& outEntities);
+
     /**
      * Removes the given entity from the cells within the given extent.
      *
@@ -162,6 +258,33 @@ private:
             + positivePosition.x);
     }
 
+    /**
+     * Returns the position of the cell that contains the given position.
+     */
+    static CellPosition toCellPosition(const Position& position);
+
+    /**
+     * Narrows [tMin, tMax] to the part of the given ray that's within the
+     * given box.
+     *
+     * Unlike BoundingBox::getIntersections(), this handles rays that are
+     * parallel to an axis and start on the box's face.
+     *
+     * @return true if the ray is within the box somewhere in [tMin, tMax].
+     */
+    static bool clipRayToBox(const Ray& ray, const BoundingBox& box,
+                             float& tMin, float& tMax);
+
+    /**
+     * Returns the extent of cells that the given box intersects.
+     */
+    static CellExtent boxToCellExtent(const BoundingBox& boundingBox);
+
+    /**
+     * Returns the extent of cells that the given cylinder intersects.
+     */
+    static CellExtent cylinderToCellExtent(const Cylinder& cylinder);
+
     /**
      * Converts the given tile extent to a cell extent.
      */
@@ -173,11 +296,8 @@ private:
     /** The grid's extent, with cells as the unit. */
     CellExtent gridCellExtent;
 
-    /** The outer vector is a 3D grid stored in row-major order, holding the
-        grid's cells.
-        Each element in the grid is a vector of entities--the entities that
-        currently intersect with that cell. */
-    std::vector<std::vector<entt::entity>> entityGrid;
+    /** A 3D grid stored in row-major order, holding the grid's cells. */
+    std::vector<Cell> entityGrid;
 
     /** A map of entity ID -> the cells that the entity is located in.
         Used to easily clear out old entity data before setting their new
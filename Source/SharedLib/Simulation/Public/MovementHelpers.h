@@ -4,6 +4,7 @@
 #include "BoundingBox.h"
 #include "Tile.h"
 #include "TileExtent.h"
+#include "ChunkExtent.h"
 #include "Rotation.h"
 #include "Log.h"
 #include "entt/fwd.hpp"
@@ -74,6 +75,26 @@ public:
                                          const TileMapBase& tileMap,
                                          EntityLocator& entityLocator);
 
+    /**
+     * Returns true if the given bounds intersect any tile collision volume.
+     * Entities aren't considered.
+     *
+     * Note: Only tiles within the bounds' tile extent (plus 1 tile above and 
+     *       below it) are checked.
+     */
+    static bool intersectsTileCollision(const BoundingBox& bounds,
+                                        const TileMapBase& tileMap);
+
+    /**
+     * Returns the chunks that intersectsTileCollision() reads when testing 
+     * the given bounds.
+     *
+     * Maps that lazily load their chunks must load these (see 
+     * TileMapBase::ensureChunksLoaded()) before testing, or the unloaded 
+     * chunks will be treated as empty.
+     */
+    static ChunkExtent getTileCollisionChunkExtent(const BoundingBox& bounds);
+
 private:
     /**
      * Returns the appropriate direction for the given direction int.
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Tile.h"
+#include "ChunkCollisionIndex.h"
 #include "SharedConfig.h"
 #include <SDL_stdinc.h>
 #include <array>
@@ -27,6 +28,10 @@ public:
     /** The tiles that make up this chunk, stored in morton order. */
     std::array<Tile, SharedConfig::CHUNK_TILE_COUNT> tiles{};
 
+    /** A copy of this chunk's tile collision volumes, organized for fast 
+        queries. Kept up to date by TileMapBase. */
+    ChunkCollisionIndex collisionIndex{};
+
     /**
      * Returns the tile at the given tile coordinate offset (with respect to 
      * this chunk's origin).
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "SharedConfig.h"
+#include <SDL_stdinc.h>
+#include <vector>
+#include <array>
+
+namespace AM
+{
+class Chunk;
+class Tile;
+struct BoundingBox;
+
+/**
+ * A compact, query-friendly copy of a chunk's tile collision volumes.
+ *
+ * Volumes are stored as structure-of-arrays and grouped by the tile that
+ * they came from, in row-major order. A query only looks at the volumes of
+ * the tiles that it overlaps, and each row's run of tiles is tested 4
+ * volumes at a time using SSE (with a scalar fallback on other platforms).
+ *
+ * Owned by Chunk. TileMapBase updates a single tile's volumes when that
+ * tile's collision is rebuilt, and rebuilds the whole index when a chunk is
+ * built or after a batch of tile updates.
+ */
+class ChunkCollisionIndex
+{
+public:
+    /**
+     * Rebuilds this index from the collision volumes of the given chunk's
+     * tiles.
+     * Note: The tiles' collision must already be up to date.
+     */
+    void rebuild(const Chunk& chunk);
+
+    /**
+     * Replaces the volumes of the tile at the given position (relative to
+     * the chunk's origin) with the given tile's collision volumes.
+     * Note: The tile's collision must already be up to date.
+     */
+    void updateTile(Uint16 tileX, Uint16 tileY, const Tile& tile);
+
+    /**
+     * Returns true if the given bounds intersect any collision volume from
+     * a tile in columns [firstX, lastX] and rows [firstY, lastY] (relative to
+     * the chunk's origin).
+     */
+    bool intersectsAny(const BoundingBox& bounds, int firstX, int firstY,
+                       int lastX, int lastY) const;
+
+    /**
+     * Returns the number of volumes in this index.
+     */
+    std::size_t getVolumeCount() const;
+
+private:
+    static constexpr std::size_t CHUNK_WIDTH{SharedConfig::CHUNK_WIDTH};
+    static constexpr std::size_t CHUNK_TILE_COUNT{
+        SharedConfig::CHUNK_TILE_COUNT};
+
+    /**
+     * Returns true if the given bounds intersect any of the volumes in
+     * [begin, end).
+     */
+    bool intersectsAny(const BoundingBox& bounds, std::size_t begin,
+                       std::size_t end) const;
+
+    /** The index in the arrays below where each tile's volumes start, in
+        row-major order. The last element holds the total volume count. */
+    std::array<Uint32, CHUNK_TILE_COUNT + 1> tileStarts{};
+
+    /** The volumes' bounds. */
+    std::vector<float> minXs{};
+    std::vector<float> maxXs{};
+    std::vector<float> minYs{};
+    std::vector<float> maxYs{};
+    std::vector<float> minZs{};
+    std::vector<float> maxZs{};
+};
+
+} // End namespace AM
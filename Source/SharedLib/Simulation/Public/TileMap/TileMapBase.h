@@ -22,12 +22,14 @@
 #include <variant>
 #include <type_traits>
 #include <expected>
+#include <span>
 
 namespace AM
 {
 struct TileMapSnapshot;
 struct ChunkSnapshot;
 struct ChunkWireSnapshot;
+class ThreadPool;
 
 /**
  * Owns and manages the world's tile map state.
@@ -58,6 +60,8 @@ public:
      */
     TileMapBase(GraphicDataBase& inGraphicData, bool inTrackTileUpdates);
 
+    virtual ~TileMapBase() = default;
+
     /**
      * Adds the given terrain to the given tile.
      */
@@ -216,6 +220,10 @@ public:
      * Returns a const pointer to the chunk at the given coordinates, or nullptr 
      * if the chunk doesn't exist (out of bounds, empty).
      * Note: Make sure to nullptr check these! Chunks are commonly empty. 
+     * Note: This never loads chunks, so it's safe to call from multiple 
+     *       threads at once (as long as nothing is modifying the map). If the 
+     *       derived map lazily loads its chunks, chunks that haven't been 
+     *       loaded yet will return nullptr. Use ensureChunkLoaded() first.
      */
     const Chunk* getChunk(const ChunkPosition& chunkPosition) const;
     /** This lets us call getChunk on a non-const TileMap& without casting. */
@@ -229,6 +237,24 @@ public:
     const Tile* getTile(const TilePosition& tilePosition) const;
     const Tile* cgetTile(const TilePosition& tilePosition) const;
 
+    /**
+     * If the derived map lazily loads its chunks and the given chunk hasn't 
+     * been loaded yet, loads it. See materializeChunk().
+     *
+     * Note: Loading a chunk modifies the map, so this must only be called 
+     *       from the thread that owns it.
+     *
+     * @return The chunk, or nullptr if it doesn't exist (out of bounds, 
+     *         empty).
+     */
+    const Chunk* ensureChunkLoaded(const ChunkPosition& chunkPosition);
+
+    /**
+     * Calls ensureChunkLoaded() for each chunk in the given extent that's 
+     * within the map bounds.
+     */
+    void ensureChunksLoaded(const ChunkExtent& extent);
+
     /**
      * Returns the map extent, with chunks as the unit.
      */
@@ -252,12 +278,34 @@ public:
     /**
      * Rebuilds the collision of any tiles that have been updated since the 
      * last time this was called (while autoRebuildCollision is disabled).
+     * Each affected chunk's collision index is then rebuilt once.
      *
      * You normally don't need to call this manually, since it's called when 
      * autoRebuildCollision is re-enabled.
      */
     void rebuildDirtyTileCollision();
 
+    /**
+     * If true, the chunk of each tile whose collision is rebuilt will be 
+     * pushed into the collision change history.
+     * Defaults to false.
+     */
+    void setTrackCollisionChanges(bool newTrackCollisionChanges);
+
+    /**
+     * Returns the position of each chunk whose tile collision has changed 
+     * since the last time the history was cleared. May contain duplicates.
+     *
+     * Note: Chunks being loaded don't count as changes, since their 
+     *       collision was already there to be found.
+     */
+    const std::vector<ChunkPosition>& getCollisionChangeHistory() const;
+
+    /**
+     * Clears the collision change history vector.
+     */
+    void clearCollisionChangeHistory();
+
     using TileUpdateVariant
         = std::variant<TileAddLayer, TileRemoveLayer, TileClearLayers,
                        TileExtentClearLayers>;
@@ -280,6 +328,25 @@ public:
     void loadChunk(const ChunkWireSnapshot& chunkSnapshot,
                    const ChunkPosition& chunkPosition);
 
+    /**
+     * Adds the tile layers from each of the given chunk snapshots to the map.
+     *
+     * The chunks are built in parallel on the given thread pool, then added 
+     * to the map. Prefer this over loadChunk() when loading many chunks.
+     *
+     * @param chunkSnapshots  The snapshots to load.
+     * @param chunkPositions  The position of each snapshot's chunk. Must be 
+     *                        the same length as chunkSnapshots.
+     */
+    void loadChunks(std::span<const ChunkSnapshot* const> chunkSnapshots,
+                    std::span<const ChunkPosition> chunkPositions,
+                    ThreadPool& threadPool);
+    void loadChunks(std::span<const ChunkWireSnapshot* const> chunkSnapshots,
+                    std::span<const ChunkPosition> chunkPositions,
+                    ThreadPool& threadPool);
+    void loadChunks(std::span<const ChunkWireSnapshot> chunkSnapshots,
+                    ThreadPool& threadPool);
+
 protected:
     enum class ChunkError {
         /** The given position was outside of the map bounds. */
@@ -296,6 +363,21 @@ protected:
     std::expected<std::reference_wrapper<Chunk>, ChunkError>
         getChunk(const ChunkPosition& chunkPosition);
 
+    /**
+     * Called when a non-const chunk lookup or ensureChunkLoaded() doesn't 
+     * find the requested chunk in chunks.
+     *
+     * Maps that lazily load their chunks (e.g. the server's memory-mapped 
+     * TileMap.bin) can override this to load the chunk into chunks.
+     *
+     * Note: Overrides must make sure that a chunk is only ever materialized 
+     *       once. Otherwise, a chunk that was emptied and erased would be 
+     *       resurrected on the next lookup.
+     *
+     * @return The newly loaded chunk, or nullptr if there's nothing to load.
+     */
+    virtual Chunk* materializeChunk(const ChunkPosition& chunkPosition);
+
     struct ChunkTilePair
     {
         /** The tile's parent chunk. */
@@ -353,7 +435,8 @@ protected:
                       Uint8 graphicValue);
 
     /**
-     * If auto rebuild is enabled, rebuilds the given tile's collision.
+     * If auto rebuild is enabled, rebuilds the given tile's collision and its 
+     * chunk's collision index.
      * Otherwise, queues the collision to be rebuilt.
      */
     void rebuildTileCollision(Tile& tile, const TilePosition& tilePosition);
@@ -442,11 +525,47 @@ protected:
 
     /**
      * Adds the tile layers from the given chunk snapshot to the map.
+     * If the chunk already exists, it's replaced.
      */
     template<typename T>
     void loadChunkInternal(const T& chunkSnapshot,
                            const ChunkPosition& chunkPosition);
 
+    /**
+     * Adds the tile layers from each of the given chunk snapshots to the map,
+     * building the chunks in parallel.
+     */
+    template<typename T>
+    void loadChunksInternal(std::span<const T* const> chunkSnapshots,
+                            std::span<const ChunkPosition> chunkPositions,
+                            ThreadPool& threadPool);
+
+    /**
+     * Fills outPalette with the graphic set for each of the given snapshot's 
+     * palette entries.
+     */
+    template<typename T>
+    void resolvePalette(const T& chunkSnapshot,
+                        std::vector<const GraphicSet*>& outPalette);
+
+    /**
+     * Builds the given chunk from the given snapshot and resolved palette, 
+     * including its tiles' collision.
+     *
+     * Note: This doesn't touch any map state, so it's safe to call 
+     *       concurrently for different chunks.
+     */
+    template<typename T>
+    void buildChunk(const T& chunkSnapshot,
+                    const std::vector<const GraphicSet*>& palette,
+                    const ChunkPosition& chunkPosition, Chunk& outChunk);
+
+    /**
+     * Adds the given chunk to the map, replacing any existing chunk.
+     * If the given chunk is empty, erases any existing chunk instead.
+     */
+    void insertChunk(const ChunkPosition& chunkPosition, Chunk&& chunk);
+
     /**
      * Returns a bool array of layer types to clear, based on the given
      * list of type enums.
@@ -457,8 +576,11 @@ protected:
         const std::initializer_list<TileLayer::Type>& layerTypesToClear);
 
     /** The version of the map format. Kept as just a 16-bit int for now, we
-        can see later if we care to make it more complicated. */
-    static constexpr Uint16 MAP_FORMAT_VERSION{1};
+        can see later if we care to make it more complicated.
+        1: A single serialized TileMapSnapshot.
+        2: Chunk-indexed, see Server::TileMapFile.
+        3: Adds a save generation to the version 2 header. */
+    static constexpr Uint16 MAP_FORMAT_VERSION{3};
 
     /** Used to get graphics while constructing tiles. */
     GraphicDataBase& graphicData;
@@ -482,6 +604,18 @@ private:
     /** A queue of tiles that need their collision rebuilt. */
     std::vector<TilePosition> dirtyCollisionQueue;
 
+    /** Used by rebuildDirtyTileCollision() to track which chunks need their 
+        collision index rebuilt. */
+    std::vector<ChunkPosition> dirtyCollisionChunks;
+
+    /** If true, changed chunks will be pushed into collisionChangeHistory. */
+    bool trackCollisionChanges;
+
+    /** Holds the chunks whose tile collision has changed. The server's 
+        PathfindingSystem uses this to rebuild their nav data, then clears 
+        it. */
+    std::vector<ChunkPosition> collisionChangeHistory;
+
     /** If true, all tile updates will be pushed into tileUpdateHistory. */
     bool trackTileUpdates;
 
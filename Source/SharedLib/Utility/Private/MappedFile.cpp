@@ -0,0 +1,140 @@
+#include "MappedFile.h"
+#include "Log.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace AM
+{
+MappedFile::MappedFile()
+: mappedData{nullptr}
+, mappedSize{0}
+#ifdef _WIN32
+, fileHandle{INVALID_HANDLE_VALUE}
+, mappingHandle{nullptr}
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& filePath)
+{
+    close();
+
+#ifdef _WIN32
+    fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                             nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                             nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("Failed to open file: %s", filePath.c_str());
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(fileHandle, &fileSize) || (fileSize.QuadPart == 0)) {
+        LOG_ERROR("Failed to get file size, or file is empty: %s",
+                  filePath.c_str());
+        close();
+        return false;
+    }
+
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0,
+                                       0, nullptr);
+    if (!mappingHandle) {
+        LOG_ERROR("Failed to create file mapping: %s", filePath.c_str());
+        close();
+        return false;
+    }
+
+    void* view{MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0)};
+    if (!view) {
+        LOG_ERROR("Failed to map view of file: %s", filePath.c_str());
+        close();
+        return false;
+    }
+
+    mappedData = static_cast<const Uint8*>(view);
+    mappedSize = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+    int fileDescriptor{::open(filePath.c_str(), O_RDONLY)};
+    if (fileDescriptor < 0) {
+        LOG_ERROR("Failed to open file: %s", filePath.c_str());
+        return false;
+    }
+
+    struct stat fileStat{};
+    if ((fstat(fileDescriptor, &fileStat) != 0) || (fileStat.st_size == 0)) {
+        LOG_ERROR("Failed to get file size, or file is empty: %s",
+                  filePath.c_str());
+        ::close(fileDescriptor);
+        return false;
+    }
+
+    void* view{mmap(nullptr, static_cast<std::size_t>(fileStat.st_size),
+                    PROT_READ, MAP_PRIVATE, fileDescriptor, 0)};
+
+    // Note: The mapping stays valid after the descriptor is closed.
+    ::close(fileDescriptor);
+    if (view == MAP_FAILED) {
+        LOG_ERROR("Failed to map file: %s", filePath.c_str());
+        return false;
+    }
+
+    mappedData = static_cast<const Uint8*>(view);
+    mappedSize = static_cast<std::size_t>(fileStat.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (mappedData) {
+        UnmapViewOfFile(mappedData);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+    if (fileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(fileHandle);
+        fileHandle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (mappedData) {
+        munmap(const_cast<Uint8*>(mappedData), mappedSize);
+    }
+#endif
+
+    mappedData = nullptr;
+    mappedSize = 0;
+}
+
+bool MappedFile::isOpen() const
+{
+    return (mappedData != nullptr);
+}
+
+const Uint8* MappedFile::data() const
+{
+    return mappedData;
+}
+
+std::size_t MappedFile::size() const
+{
+    return mappedSize;
+}
+
+} // End namespace AM
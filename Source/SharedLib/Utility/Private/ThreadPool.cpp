@@ -0,0 +1,116 @@
+#include "ThreadPool.h"
+
+namespace AM
+{
+ThreadPool::ThreadPool(std::size_t inWorkerCount)
+: workers{}
+, jobMutex{}
+, jobCondVar{}
+, jobDoneCondVar{}
+, currentJob{nullptr}
+, currentJobCount{0}
+, nextJobIndex{0}
+, jobGeneration{0}
+, busyWorkerCount{0}
+, exitRequested{false}
+{
+    // If no count was given, use one thread per core (including the caller).
+    std::size_t workerCount{inWorkerCount};
+    if (workerCount == 0) {
+        unsigned int hardwareThreads{std::thread::hardware_concurrency()};
+        workerCount = (hardwareThreads > 1) ? (hardwareThreads - 1) : 0;
+    }
+
+    workers.reserve(workerCount);
+    for (std::size_t i{0}; i < workerCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock lock{jobMutex};
+        exitRequested = true;
+    }
+    jobCondVar.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::getThreadCount() const
+{
+    return (workers.size() + 1);
+}
+
+void ThreadPool::parallelFor(std::size_t count,
+                             const std::function<void(std::size_t)>& func)
+{
+    // If there's nothing worth splitting, just run it here.
+    if (workers.empty() || (count <= 1)) {
+        for (std::size_t i{0}; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    // Post the job and wake the workers.
+    {
+        std::unique_lock lock{jobMutex};
+        currentJob = &func;
+        currentJobCount = count;
+        nextJobIndex = 0;
+        busyWorkerCount = workers.size();
+        jobGeneration++;
+    }
+    jobCondVar.notify_all();
+
+    // Help out while we wait.
+    runCurrentJob();
+
+    // Wait for the workers to finish.
+    std::unique_lock lock{jobMutex};
+    jobDoneCondVar.wait(lock, [this] { return (busyWorkerCount == 0); });
+    currentJob = nullptr;
+}
+
+void ThreadPool::workerLoop()
+{
+    Uint64 lastJobGeneration{0};
+    while (true) {
+        // Wait until a new job is posted, or we're told to exit.
+        {
+            std::unique_lock lock{jobMutex};
+            jobCondVar.wait(lock, [&] {
+                return (exitRequested || (jobGeneration != lastJobGeneration));
+            });
+            if (exitRequested) {
+                return;
+            }
+            lastJobGeneration = jobGeneration;
+        }
+
+        runCurrentJob();
+
+        // Signal that we're done.
+        {
+            std::unique_lock lock{jobMutex};
+            busyWorkerCount--;
+            if (busyWorkerCount == 0) {
+                jobDoneCondVar.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::runCurrentJob()
+{
+    for (std::size_t i{nextJobIndex++}; i < currentJobCount;
+         i = nextJobIndex++) {
+        (*currentJob)(i);
+    }
+}
+
+} // End namespace AM
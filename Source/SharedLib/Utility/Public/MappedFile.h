@@ -0,0 +1,71 @@
+#pragma once
+
+#include <SDL_stdinc.h>
+#include <string>
+#include <cstddef>
+
+namespace AM
+{
+/**
+ * A read-only memory mapping of a file.
+ *
+ * Lets us hand out pointers into large files (e.g. TileMap.bin) without
+ * reading the whole thing up front. The OS will page data in as it's touched.
+ *
+ * Note: The mapping is read-only. If you need to overwrite the mapped file,
+ *       close() this first (Windows won't let you replace a mapped file).
+ */
+class MappedFile
+{
+public:
+    MappedFile();
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Maps the file at the given path, closing any previous mapping.
+     *
+     * @return true if the file was successfully mapped, else false.
+     */
+    bool open(const std::string& filePath);
+
+    /**
+     * Unmaps the current file, if one is mapped.
+     */
+    void close();
+
+    /**
+     * Returns true if a file is currently mapped.
+     */
+    bool isOpen() const;
+
+    /**
+     * Returns a pointer to the start of the mapped bytes, or nullptr if no
+     * file is mapped.
+     */
+    const Uint8* data() const;
+
+    /**
+     * Returns the size of the mapped file, in bytes.
+     */
+    std::size_t size() const;
+
+private:
+    /** The start of the mapped bytes. */
+    const Uint8* mappedData;
+
+    /** The size of the mapped bytes. */
+    std::size_t mappedSize;
+
+#ifdef _WIN32
+    /** The file and mapping handles. Stored as void* so we don't need to
+        pull windows.h into this header. */
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+} // End namespace AM
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <SDL_stdinc.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+namespace AM
+{
+/**
+ * A fixed set of worker threads, used to split embarrassingly parallel work
+ * (e.g. decoding map chunks) across cores.
+ *
+ * Work is submitted through parallelFor(), which blocks until all of the
+ * work is done. The calling thread also does work while it waits.
+ *
+ * Note: parallelFor() isn't re-entrant, and should only be called from one
+ *       thread at a time.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @param inWorkerCount  The number of worker threads to start. If 0,
+     *                       starts one less than the number of hardware
+     *                       threads (the calling thread makes up the rest).
+     */
+    explicit ThreadPool(std::size_t inWorkerCount = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Returns the number of threads that work is spread across, including
+     * the calling thread.
+     */
+    std::size_t getThreadCount() const;
+
+    /**
+     * Calls func(i) for each i in [0, count), spread across the worker
+     * threads and the calling thread.
+     * Blocks until every call has returned.
+     *
+     * Note: Calls may happen in any order, and func must be safe to call
+     *       concurrently.
+     */
+    void parallelFor(std::size_t count,
+                     const std::function<void(std::size_t)>& func);
+
+private:
+    /**
+     * Thread function. Waits for parallelFor() to post a job, then helps
+     * run it.
+     */
+    void workerLoop();
+
+    /**
+     * Runs indices from the current job until there are none left.
+     */
+    void runCurrentJob();
+
+    /** Our worker threads. */
+    std::vector<std::thread> workers;
+
+    /** Used for signaling the worker threads. */
+    std::mutex jobMutex;
+    std::condition_variable jobCondVar;
+    std::condition_variable jobDoneCondVar;
+
+    /** The function to call for the current job. */
+    const std::function<void(std::size_t)>* currentJob;
+
+    /** The number of indices in the current job. */
+    std::size_t currentJobCount;
+
+    /** The next index to be claimed from the current job. */
+    std::atomic<std::size_t> nextJobIndex;
+
+    /** Incremented each time a job is posted, so workers can tell when
+        there's a new one. */
+    Uint64 jobGeneration;
+
+    /** The number of workers that haven't finished the current job. */
+    std::size_t busyWorkerCount;
+
+    /** Turn true to signal that the worker threads should end. */
+    bool exitRequested;
+};
+
+} // End namespace AM
@@ -0,0 +1,165 @@
+#include "Database.h"
+#include "Timer.h"
+#include "Log.h"
+#include "Ignore.h"
+#include <SDL_stdinc.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <thread>
+#include <algorithm>
+
+/**
+ * Measures how long a save takes, and how many bytes it writes, in each of
+ * the database's storage modes.
+ *
+ * For each mode and entity count, we fill the database with entities, then
+ * run a series of saves that each update a small fraction of them (like an
+ * incremental SaveSystem save would).
+ *
+ * Note: Written bytes come from /proc/self/io, so they're only available on
+ *       Linux.
+ */
+
+using namespace AM;
+using namespace AM::Server;
+
+/** The entity counts to test. */
+static constexpr std::size_t ENTITY_COUNTS[]{10'000, 100'000};
+
+/** The size of each entity's data blob. Roughly the size of a typical
+    serialized PersistedEntityData. */
+static constexpr std::size_t ENTITY_DATA_SIZE{128};
+
+/** The fraction of entities that are updated in each save. */
+static constexpr double DIRTY_FRACTION{0.01};
+
+/** The number of saves to measure for each run. */
+static constexpr unsigned int SAVE_COUNT{16};
+
+static const std::string DATABASE_PATH{"SaveBenchmark.db3"};
+
+/**
+ * Returns the number of bytes that this process has written so far, or 0 if
+ * it isn't available on this platform.
+ */
+static Uint64 getWrittenBytes()
+{
+    std::ifstream ioFile{"/proc/self/io"};
+    std::string key{};
+    Uint64 value{0};
+    while (ioFile >> key >> value) {
+        if (key == "wchar:") {
+            return value;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Deletes the database file, along with its log files.
+ */
+static void deleteDatabaseFiles()
+{
+    std::filesystem::remove(DATABASE_PATH);
+    std::filesystem::remove(DATABASE_PATH + "-wal");
+    std::filesystem::remove(DATABASE_PATH + "-shm");
+}
+
+/**
+ * Commits the given entities to the database, then waits for the backup or
+ * checkpoint to finish.
+ */
+static void save(Database& database, const std::vector<Uint32>& entityIDs,
+                 std::vector<Uint8>& entityData)
+{
+    database.startTransaction();
+    for (Uint32 entityID : entityIDs) {
+        database.saveEntityData(static_cast<entt::entity>(entityID),
+                                entityData.data(), entityData.size());
+    }
+    database.commitTransaction();
+
+    database.backupToFile();
+    while (database.backupIsInProgress()) {
+        std::this_thread::yield();
+    }
+}
+
+static void runBenchmark(Database::StorageMode storageMode,
+                         const char* modeName, std::size_t entityCount)
+{
+    deleteDatabaseFiles();
+
+    std::mt19937 generator{12345};
+    std::uniform_int_distribution<Uint32> entityDistribution{
+        0, static_cast<Uint32>(entityCount - 1)};
+    std::uniform_int_distribution<unsigned int> byteDistribution{0, 255};
+    std::vector<Uint8> entityData(ENTITY_DATA_SIZE);
+    for (Uint8& byte : entityData) {
+        byte = static_cast<Uint8>(byteDistribution(generator));
+    }
+
+    {
+        Database database{storageMode, DATABASE_PATH};
+
+        // Fill the database.
+        std::vector<Uint32> entityIDs(entityCount);
+        for (std::size_t i{0}; i < entityCount; ++i) {
+            entityIDs[i] = static_cast<Uint32>(i);
+        }
+        save(database, entityIDs, entityData);
+
+        // Run the measured saves.
+        const std::size_t dirtyCount{
+            static_cast<std::size_t>(entityCount * DIRTY_FRACTION)};
+        Timer timer{};
+        double totalTimeS{0};
+        double maxTimeS{0};
+        Uint64 totalWrittenBytes{0};
+        for (unsigned int i{0}; i < SAVE_COUNT; ++i) {
+            entityIDs.clear();
+            for (std::size_t j{0}; j < dirtyCount; ++j) {
+                entityIDs.push_back(entityDistribution(generator));
+            }
+            entityData[0]++;
+
+            Uint64 startWrittenBytes{getWrittenBytes()};
+            timer.reset();
+            save(database, entityIDs, entityData);
+            double timeS{timer.getTime()};
+
+            totalTimeS += timeS;
+            maxTimeS = std::max(maxTimeS, timeS);
+            totalWrittenBytes += (getWrittenBytes() - startWrittenBytes);
+        }
+
+        LOG_INFO("%s, %zu entities (%zu updated per save): avg save %.2fms, "
+                 "max save %.2fms, avg written %.1fKiB",
+                 modeName, entityCount, dirtyCount,
+                 (totalTimeS / SAVE_COUNT * 1000), (maxTimeS * 1000),
+                 (static_cast<double>(totalWrittenBytes) / SAVE_COUNT
+                  / 1024));
+    }
+
+    deleteDatabaseFiles();
+}
+
+int main(int argc, char* argv[])
+{
+    // SDL2 needs this signature for main, but we don't use the parameters.
+    ignore(argc);
+    ignore(argv);
+
+    for (std::size_t entityCount : ENTITY_COUNTS) {
+        runBenchmark(Database::StorageMode::InMemory, "In-memory + backup",
+                     entityCount);
+        runBenchmark(Database::StorageMode::WriteAheadLog, "WAL",
+                     entityCount);
+    }
+
+    return 0;
+}
@@ -0,0 +1,219 @@
+#include "NavGraph.h"
+#include "TileMapBase.h"
+#include "GraphicDataBase.h"
+#include "ChunkExtent.h"
+#include "TileExtent.h"
+#include "TilePosition.h"
+#include "TileOffset.h"
+#include "Rotation.h"
+#include "SharedConfig.h"
+#include "Log.h"
+#include "Ignore.h"
+#include "nlohmann/json.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+/**
+ * Runs the NavGraph through a few scenarios on a small in-memory map:
+ *   1. A path across the map, which crosses several chunk borders.
+ *   2. A wall along a chunk border with a single gap. The changed chunks
+ *      are invalidated like PathfindingSystem does, and the new path must
+ *      go through the gap.
+ *   3. The gap is closed, so the goal is unreachable.
+ *
+ * Each found path is checked to be a connected series of tiles that ends at
+ * the goal and never enters a wall.
+ */
+
+using namespace AM;
+using namespace AM::Server;
+
+/** The map's size, in chunks. */
+static constexpr Uint16 MAP_X_LENGTH_CHUNKS{4};
+static constexpr Uint16 MAP_Y_LENGTH_CHUNKS{2};
+
+/** The numeric ID of our wall sprite and object graphic set. */
+static constexpr Uint16 WALL_ID{1};
+
+/**
+ * Returns resource data with a single object graphic set, whose sprite's
+ * collision fills its whole tile.
+ */
+static nlohmann::json getResourceDataJson()
+{
+    static constexpr float TILE_WORLD_WIDTH{SharedConfig::TILE_WORLD_WIDTH};
+    static constexpr float TILE_WORLD_HEIGHT{SharedConfig::TILE_WORLD_HEIGHT};
+
+    nlohmann::json spriteJson{};
+    spriteJson["numericID"] = WALL_ID;
+    spriteJson["displayName"] = "Wall";
+    spriteJson["stringID"] = "wall";
+    spriteJson["collisionEnabled"] = true;
+    spriteJson["modelBounds"] = {{"minX", 0.f},
+                                 {"maxX", TILE_WORLD_WIDTH},
+                                 {"minY", 0.f},
+                                 {"maxY", TILE_WORLD_WIDTH},
+                                 {"minZ", 0.f},
+                                 {"maxZ", TILE_WORLD_HEIGHT}};
+
+    nlohmann::json objectJson{};
+    objectJson["numericID"] = WALL_ID;
+    objectJson["displayName"] = "Wall";
+    objectJson["stringID"] = "wall";
+    objectJson["graphicIDs"] = std::vector<GraphicID>(
+        ObjectGraphicSet::VARIATION_COUNT, WALL_ID);
+
+    nlohmann::json json{};
+    json["spriteSheets"] = nlohmann::json::array(
+        {{{"sprites", nlohmann::json::array({spriteJson})}}});
+    json["animations"] = nlohmann::json::array();
+    json["terrain"] = nlohmann::json::array();
+    json["floors"] = nlohmann::json::array();
+    json["walls"] = nlohmann::json::array();
+    json["objects"] = nlohmann::json::array({objectJson});
+    json["entities"] = nlohmann::json::array();
+
+    return json;
+}
+
+/**
+ * A tile map that starts out empty, instead of loading from a file.
+ */
+class TestTileMap : public TileMapBase
+{
+public:
+    TestTileMap(GraphicDataBase& inGraphicData)
+    : TileMapBase{inGraphicData, false}
+    {
+        chunkExtent = ChunkExtent::fromMapLengths(MAP_X_LENGTH_CHUNKS,
+                                                  MAP_Y_LENGTH_CHUNKS, 1);
+        tileExtent = TileExtent{chunkExtent};
+    }
+};
+
+/**
+ * Throws out the nav data around each chunk whose collision changed, like
+ * PathfindingSystem does each tick.
+ */
+static void processCollisionChanges(TileMapBase& tileMap, NavGraph& navGraph)
+{
+    for (const ChunkPosition& changedChunk :
+         tileMap.getCollisionChangeHistory()) {
+        navGraph.invalidate(changedChunk);
+    }
+    tileMap.clearCollisionChangeHistory();
+}
+
+/**
+ * Returns true if the given path leads from start to goal one adjacent tile
+ * at a time, without entering any of the given wall tiles.
+ */
+static bool isValidPath(const TilePosition& start, const TilePosition& goal,
+                        const std::vector<TilePosition>& path,
+                        const std::vector<TilePosition>& wallTiles)
+{
+    if (path.empty() || (path.back() != goal)) {
+        LOG_INFO("Path doesn't end at the goal.");
+        return false;
+    }
+
+    TilePosition previousTile{start};
+    for (const TilePosition& tile : path) {
+        int xDistance{std::abs(tile.x - previousTile.x)};
+        int yDistance{std::abs(tile.y - previousTile.y)};
+        if ((xDistance > 1) || (yDistance > 1) || (tile.z != previousTile.z)
+            || (tile == previousTile)) {
+            LOG_INFO("Path jumps from (%d, %d) to (%d, %d).", previousTile.x,
+                     previousTile.y, tile.x, tile.y);
+            return false;
+        }
+
+        if (std::find(wallTiles.begin(), wallTiles.end(), tile)
+            != wallTiles.end()) {
+            LOG_INFO("Path enters wall tile (%d, %d).", tile.x, tile.y);
+            return false;
+        }
+
+        previousTile = tile;
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    // SDL2 needs this signature for main, but we don't use the parameters.
+    ignore(argc);
+    ignore(argv);
+
+    GraphicDataBase graphicData{getResourceDataJson()};
+    TestTileMap tileMap{graphicData};
+    tileMap.setTrackCollisionChanges(true);
+    NavGraph navGraph{tileMap};
+
+    const ChunkExtent& chunkExtent{tileMap.getChunkExtent()};
+    const TileExtent& tileExtent{tileMap.getTileExtent()};
+    TilePosition start{tileExtent.x + 2, tileExtent.y + 2, 0};
+    TilePosition goal{tileExtent.x + tileExtent.xLength - 3,
+                      tileExtent.y + tileExtent.yLength - 3, 0};
+    std::vector<TilePosition> wallTiles{};
+    std::vector<TilePosition> path{};
+    bool passed{true};
+
+    // 1. Path across chunk borders, on an empty map.
+    navGraph.ensureBuilt(chunkExtent);
+    if (navGraph.findPath(start, goal, chunkExtent, path)
+        && isValidPath(start, goal, path, wallTiles)) {
+        LOG_INFO("Path across chunk borders: passed (%zu tiles).",
+                 path.size());
+    }
+    else {
+        LOG_ERROR("Path across chunk borders: failed.");
+        passed = false;
+    }
+
+    // 2. Wall along the chunk border at x == 0, with a gap near one end.
+    //    Since the old path goes straight through it, the wall's chunks
+    //    must be invalidated for the new path to detour through the gap.
+    TilePosition gapTile{0, (tileExtent.y + 1), 0};
+    for (int y{tileExtent.y}; y < (tileExtent.y + tileExtent.yLength); ++y) {
+        TilePosition wallTile{0, y, 0};
+        if (wallTile != gapTile) {
+            tileMap.addObject(wallTile, TileOffset{}, WALL_ID,
+                              Rotation::Direction::South);
+            wallTiles.push_back(wallTile);
+        }
+    }
+    processCollisionChanges(tileMap, navGraph);
+    navGraph.ensureBuilt(chunkExtent);
+
+    if (navGraph.findPath(start, goal, chunkExtent, path)
+        && isValidPath(start, goal, path, wallTiles)
+        && (std::find(path.begin(), path.end(), gapTile) != path.end())) {
+        LOG_INFO("Path through a new wall's gap: passed (%zu tiles).",
+                 path.size());
+    }
+    else {
+        LOG_ERROR("Path through a new wall's gap: failed.");
+        passed = false;
+    }
+
+    // 3. Close the gap. The goal is now unreachable.
+    tileMap.addObject(gapTile, TileOffset{}, WALL_ID,
+                      Rotation::Direction::South);
+    wallTiles.push_back(gapTile);
+    processCollisionChanges(tileMap, navGraph);
+    navGraph.ensureBuilt(chunkExtent);
+
+    if (!(navGraph.findPath(start, goal, chunkExtent, path))) {
+        LOG_INFO("Unreachable goal: passed.");
+    }
+    else {
+        LOG_ERROR("Unreachable goal: failed (found a %zu tile path).",
+                  path.size());
+        passed = false;
+    }
+
+    return (passed ? 0 : 1);
+}
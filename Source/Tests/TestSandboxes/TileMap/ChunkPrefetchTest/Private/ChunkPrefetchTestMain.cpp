@@ -0,0 +1,250 @@
+#include "ChunkPrefetcher.h"
+#include "Position.h"
+#include "ChunkPosition.h"
+#include "ChunkExtent.h"
+#include "TilePosition.h"
+#include "TileExtent.h"
+#include "SharedConfig.h"
+#include "Log.h"
+#include "Ignore.h"
+#include <SDL_stdinc.h>
+#include <unordered_set>
+#include <deque>
+#include <vector>
+#include <random>
+#include <cmath>
+
+/**
+ * Simulates a player walking around a map while streaming chunks from a
+ * server, and measures how often a tile comes into view before its chunk
+ * has arrived.
+ *
+ * Chunks are requested through ChunkPrefetcher, the same way that
+ * ChunkUpdateSystem requests them. Runs once with chunk prefetching disabled
+ * (only requesting chunks after crossing into a new chunk, like
+ * ChunkUpdateSystem used to) and once with it enabled, at a few different
+ * movement speeds.
+ */
+
+using namespace AM;
+using namespace AM::Client;
+
+/** The map size, in chunks. */
+static constexpr Uint16 MAP_LENGTH_CHUNKS{64};
+
+/** The number of ticks to simulate for each run. */
+static constexpr unsigned int TICK_COUNT{SharedConfig::SIM_TICKS_PER_SECOND
+                                         * 60 * 30};
+
+/** The one-way latency between the client and server, in ticks. */
+static constexpr unsigned int ONE_WAY_LATENCY_TICKS{3};
+
+/** The max number of chunks that the simulated server sends per tick. */
+static constexpr std::size_t CHUNKS_SENT_PER_TICK{4};
+
+/** The radius, in tiles, of the area that the player can see. */
+static constexpr int VIEW_RADIUS_TILES{static_cast<int>(
+    SharedConfig::VIEW_RADIUS / SharedConfig::TILE_WORLD_WIDTH)};
+
+/** The player's speed is MOVEMENT_VELOCITY multiplied by each of these. */
+static constexpr float SPEED_MULTIPLIERS[]{1, 4, 8};
+
+struct PendingChunk {
+    /** The tick that this chunk will arrive at its destination. */
+    unsigned int arrivalTick{0};
+    ChunkPosition position{};
+};
+
+struct RunResult {
+    /** The number of tiles that came into view. */
+    Uint64 tilesEntered{0};
+    /** The number of those tiles whose chunk hadn't arrived yet. */
+    Uint64 tilesMissing{0};
+};
+
+/**
+ * Returns the extent of tiles that can be seen from the given position.
+ */
+static TileExtent getViewExtent(const Position& position)
+{
+    TilePosition centerTile{position.asTilePosition()};
+    return {(centerTile.x - VIEW_RADIUS_TILES),
+            (centerTile.y - VIEW_RADIUS_TILES),
+            centerTile.z,
+            ((VIEW_RADIUS_TILES * 2) + 1),
+            ((VIEW_RADIUS_TILES * 2) + 1),
+            1};
+}
+
+static RunResult runSimulation(bool prefetchEnabled, float speedMultiplier,
+                               unsigned int seed)
+{
+    static constexpr float CHUNK_WORLD_WIDTH{
+        static_cast<float>(SharedConfig::CHUNK_WIDTH
+                           * SharedConfig::TILE_WORLD_WIDTH)};
+    const ChunkExtent mapChunkExtent{ChunkExtent::fromMapLengths(
+        MAP_LENGTH_CHUNKS, MAP_LENGTH_CHUNKS, 1)};
+    const float mapMinX{mapChunkExtent.x * CHUNK_WORLD_WIDTH};
+    const float mapMaxX{(mapChunkExtent.xMax() + 1) * CHUNK_WORLD_WIDTH};
+    const float mapMinY{mapChunkExtent.y * CHUNK_WORLD_WIDTH};
+    const float mapMaxY{(mapChunkExtent.yMax() + 1) * CHUNK_WORLD_WIDTH};
+    const float speed{static_cast<float>(
+        SharedConfig::MOVEMENT_VELOCITY * speedMultiplier
+        * SharedConfig::SIM_TICK_TIMESTEP_S)};
+
+    std::mt19937 generator{seed};
+    std::uniform_int_distribution<int> directionDistribution{-1, 1};
+    std::uniform_int_distribution<unsigned int> walkTicksDistribution{
+        SharedConfig::SIM_TICKS_PER_SECOND,
+        SharedConfig::SIM_TICKS_PER_SECOND * 4};
+
+    // Start in the center of the map's middle chunk, with the surrounding
+    // chunks loaded.
+    // Note: The map is centered on the origin, so this is chunk (0, 0).
+    const ChunkPosition startChunk{
+        (mapChunkExtent.x + (mapChunkExtent.xLength / 2)),
+        (mapChunkExtent.y + (mapChunkExtent.yLength / 2)), 0};
+    Position position{((startChunk.x + 0.5f) * CHUNK_WORLD_WIDTH),
+                      ((startChunk.y + 0.5f) * CHUNK_WORLD_WIDTH), 0};
+    Position previousPosition{position};
+    ChunkPrefetcher prefetcher{};
+    std::vector<ChunkPosition> workChunks{};
+    prefetcher.getAllInRangeChunks(position, mapChunkExtent, workChunks);
+    std::unordered_set<ChunkPosition> loadedChunks(workChunks.begin(),
+                                                   workChunks.end());
+
+    std::deque<PendingChunk> requests{};
+    std::deque<PendingChunk> responses{};
+    TileExtent previousViewExtent{getViewExtent(position)};
+    int xDirection{1};
+    int yDirection{0};
+    unsigned int ticksUntilTurn{0};
+    RunResult result{};
+    for (unsigned int tick{0}; tick < TICK_COUNT; ++tick) {
+        // Occasionally pick a new direction.
+        if (ticksUntilTurn == 0) {
+            do {
+                xDirection = directionDistribution(generator);
+                yDirection = directionDistribution(generator);
+            } while ((xDirection == 0) && (yDirection == 0));
+            ticksUntilTurn = walkTicksDistribution(generator);
+        }
+        ticksUntilTurn--;
+
+        // Move, bouncing off of the map edges.
+        previousPosition = position;
+        position.x += (xDirection * speed);
+        position.y += (yDirection * speed);
+        if ((position.x < mapMinX) || (position.x >= mapMaxX)) {
+            xDirection = -xDirection;
+            position.x = previousPosition.x;
+        }
+        if ((position.y < mapMinY) || (position.y >= mapMaxY)) {
+            yDirection = -yDirection;
+            position.y = previousPosition.y;
+        }
+
+        // Request chunks, the same way ChunkUpdateSystem does.
+        // Note: Without prefetching, we only request the chunks that come
+        //       into range when we cross into a new chunk.
+        workChunks.clear();
+        if (prefetchEnabled) {
+            prefetcher.getChunksToRequest(position, previousPosition,
+                                          mapChunkExtent, workChunks);
+        }
+        else {
+            ChunkPosition previousChunk{previousPosition.asChunkPosition()};
+            if (previousChunk != position.asChunkPosition()) {
+                prefetcher.getNewInRangeChunks(previousChunk, position,
+                                               mapChunkExtent, workChunks);
+            }
+        }
+        for (const ChunkPosition& chunkPosition : workChunks) {
+            requests.emplace_back((tick + ONE_WAY_LATENCY_TICKS),
+                                  chunkPosition);
+        }
+
+        // Let the server respond to any requests that have arrived, up to
+        // its per-tick limit.
+        std::size_t chunksSent{0};
+        while (!(requests.empty()) && (requests.front().arrivalTick <= tick)
+               && (chunksSent < CHUNKS_SENT_PER_TICK)) {
+            responses.emplace_back((tick + ONE_WAY_LATENCY_TICKS),
+                                   requests.front().position);
+            requests.pop_front();
+            chunksSent++;
+        }
+
+        // Receive any responses that have arrived.
+        while (!(responses.empty())
+               && (responses.front().arrivalTick <= tick)) {
+            loadedChunks.insert(responses.front().position);
+            responses.pop_front();
+        }
+
+        // Check every tile that just came into view.
+        TileExtent viewExtent{getViewExtent(position)};
+        for (int y{viewExtent.y}; y <= viewExtent.yMax(); ++y) {
+            for (int x{viewExtent.x}; x <= viewExtent.xMax(); ++x) {
+                TilePosition tilePosition{x, y, 0};
+                ChunkPosition chunkPosition{
+                    static_cast<int>(std::floor(static_cast<float>(x)
+                                                / SharedConfig::CHUNK_WIDTH)),
+                    static_cast<int>(std::floor(static_cast<float>(y)
+                                                / SharedConfig::CHUNK_WIDTH)),
+                    0};
+                if (previousViewExtent.containsPosition(tilePosition)
+                    || !(mapChunkExtent.containsPosition(chunkPosition))) {
+                    continue;
+                }
+
+                result.tilesEntered++;
+                if (!(loadedChunks.contains(chunkPosition))) {
+                    result.tilesMissing++;
+                }
+            }
+        }
+        previousViewExtent = viewExtent;
+    }
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    // SDL2 needs this signature for main, but we don't use the parameters.
+    ignore(argc);
+    ignore(argv);
+
+    LOG_INFO("Simulating %u ticks per run. Latency: %ums one-way. View "
+             "radius: %d tiles.",
+             TICK_COUNT,
+             static_cast<unsigned int>(ONE_WAY_LATENCY_TICKS
+                                       * SharedConfig::SIM_TICK_TIMESTEP_S
+                                       * 1000),
+             VIEW_RADIUS_TILES);
+
+    static constexpr unsigned int SEED{12345};
+    for (float speedMultiplier : SPEED_MULTIPLIERS) {
+        RunResult baseline{runSimulation(false, speedMultiplier, SEED)};
+        RunResult prefetched{runSimulation(true, speedMultiplier, SEED)};
+
+        auto missRate = [](const RunResult& result) {
+            if (result.tilesEntered == 0) {
+                return 0.0;
+            }
+            return (100.0 * static_cast<double>(result.tilesMissing)
+                    / static_cast<double>(result.tilesEntered));
+        };
+        LOG_INFO("Speed x%.0f: Missing tiles without prefetch: %.3f%% "
+                 "(%llu/%llu). With prefetch: %.3f%% (%llu/%llu).",
+                 speedMultiplier, missRate(baseline),
+                 static_cast<unsigned long long>(baseline.tilesMissing),
+                 static_cast<unsigned long long>(baseline.tilesEntered),
+                 missRate(prefetched),
+                 static_cast<unsigned long long>(prefetched.tilesMissing),
+                 static_cast<unsigned long long>(prefetched.tilesEntered));
+    }
+
+    return 0;
+}
@@ -331,3 +331,156 @@ TEST_CASE("TestEntityLocator")
         REQUIRE(returnVector->at(1) == entity2);
     }
 }
+
+TEST_CASE("TestEntityLocatorQueries")
+{
+    entt::registry registry;
+    EntityLocator entityLocator{registry};
+    entityLocator.setGridSize({-32, -32, 0, 64, 64, 1});
+
+    // Model-space bounding box.
+    const float TILE_WORLD_WIDTH{SharedConfig::TILE_WORLD_WIDTH};
+    const float HALF_TILE{TILE_WORLD_WIDTH / 2.f};
+    BoundingBox modelBounds{0, HALF_TILE, 0, HALF_TILE, 0, HALF_TILE};
+
+    // Places an entity centered in the given tile.
+    auto addEntity = [&](int tileX, int tileY) {
+        entt::entity entity{registry.create()};
+        Position& position{registry.emplace<Position>(
+            entity, ((tileX * TILE_WORLD_WIDTH) + HALF_TILE),
+            ((tileY * TILE_WORLD_WIDTH) + HALF_TILE), 0.f)};
+        BoundingBox boundingBox{
+            Transforms::modelToWorldCentered(modelBounds, position)};
+        registry.emplace<Collision>(entity, Collision{{}, boundingBox});
+        entityLocator.setEntityLocation(entity, boundingBox);
+        return entity;
+    };
+
+    entt::entity near{addEntity(1, 0)};
+    entt::entity middle{addEntity(-4, 0)};
+    entt::entity far{addEntity(20, 0)};
+    Position origin{HALF_TILE, HALF_TILE, 0};
+
+    SECTION("Nearest entities")
+    {
+        std::vector<entt::entity> returnVector{
+            entityLocator.getNearestEntities(origin, 2, 1000.f)};
+
+        REQUIRE(returnVector.size() == 2);
+        REQUIRE(returnVector.at(0) == near);
+        REQUIRE(returnVector.at(1) == middle);
+
+        // Filter out the nearest, and limit the radius.
+        returnVector = entityLocator.getNearestEntities(
+            origin, 5, (5 * TILE_WORLD_WIDTH),
+            [&](entt::entity entity) { return entity != near; });
+
+        REQUIRE(returnVector.size() == 1);
+        REQUIRE(returnVector.at(0) == middle);
+    }
+
+    SECTION("First collision")
+    {
+        Position end{origin.x + (30 * TILE_WORLD_WIDTH), origin.y, 0};
+        REQUIRE(entityLocator.getFirstCollision(origin, end) == near);
+
+        // Skip the nearest.
+        REQUIRE(entityLocator.getFirstCollision(
+                    origin, end,
+                    [&](entt::entity entity) { return entity != near; })
+                == far);
+
+        // Stop short of everything.
+        end.x = origin.x + (2 * TILE_WORLD_WIDTH);
+        end.y = origin.y + (2 * TILE_WORLD_WIDTH);
+        REQUIRE(entityLocator.getFirstCollision({origin.x, end.y, 0}, end)
+                == entt::entity{entt::null});
+    }
+}
+
+TEST_CASE("TestEntityLocatorRemove")
+{
+    entt::registry registry;
+    EntityLocator entityLocator{registry};
+
+    const int CELL_WIDTH{
+        static_cast<int>(SharedConfig::ENTITY_LOCATOR_CELL_WIDTH)};
+    entityLocator.setGridSize({0, 0, 0, (4 * CELL_WIDTH), (4 * CELL_WIDTH), 1});
+
+    // Model-space bounding box.
+    const float TILE_WORLD_WIDTH{SharedConfig::TILE_WORLD_WIDTH};
+    const float HALF_TILE{TILE_WORLD_WIDTH / 2.f};
+    BoundingBox modelBounds{0, HALF_TILE, 0, HALF_TILE, 0, HALF_TILE};
+
+    // Places an entity at the given position.
+    auto addEntity = [&](const Position& position) {
+        entt::entity entity{registry.create()};
+        registry.emplace<Position>(entity, position);
+        BoundingBox boundingBox{
+            Transforms::modelToWorldCentered(modelBounds, position)};
+        registry.emplace<Collision>(entity, Collision{{}, boundingBox});
+        entityLocator.setEntityLocation(entity, boundingBox);
+        return entity;
+    };
+
+    SECTION("Other bounds stay with their entities")
+    {
+        // Fill a single cell with enough entities to take the 4-wide path,
+        // each in its own tile.
+        std::vector<entt::entity> entities{};
+        for (int i{0}; i < 6; ++i) {
+            int tileX{i % CELL_WIDTH};
+            int tileY{i / CELL_WIDTH};
+            entities.push_back(
+                addEntity({((tileX * TILE_WORLD_WIDTH) + HALF_TILE),
+                           ((tileY * TILE_WORLD_WIDTH) + HALF_TILE), 0.f}));
+        }
+
+        // Remove one from the middle, so the last entity gets swapped into
+        // its place.
+        entityLocator.removeEntity(entities[1]);
+
+        // Returns the entities that collide with the given tile.
+        // Note: We use a box instead of a TileExtent, since the extent would 
+        //       also include entities that share its edge.
+        auto getTileCollisions = [&](int tileX, int tileY) {
+            BoundingBox tileBounds{(tileX * TILE_WORLD_WIDTH),
+                                   ((tileX + 1) * TILE_WORLD_WIDTH),
+                                   (tileY * TILE_WORLD_WIDTH),
+                                   ((tileY + 1) * TILE_WORLD_WIDTH),
+                                   0,
+                                   HALF_TILE};
+            return entityLocator.getCollisions(tileBounds);
+        };
+
+        // Each remaining entity should only be found in its own tile.
+        for (int i{0}; i < 6; ++i) {
+            int tileX{i % CELL_WIDTH};
+            int tileY{i / CELL_WIDTH};
+            std::vector<entt::entity> returnVector{
+                getTileCollisions(tileX, tileY)};
+            if (i == 1) {
+                REQUIRE(returnVector.size() == 0);
+            }
+            else {
+                REQUIRE(returnVector.size() == 1);
+                REQUIRE(returnVector.at(0) == entities[i]);
+            }
+        }
+
+        // Move an entity and make sure it's found at its new location.
+        Position& position{registry.get<Position>(entities[5])};
+        position.x = ((4 * TILE_WORLD_WIDTH) + HALF_TILE);
+        position.y = HALF_TILE;
+        BoundingBox boundingBox{
+            Transforms::modelToWorldCentered(modelBounds, position)};
+        entityLocator.setEntityLocation(entities[5], boundingBox);
+
+        std::vector<entt::entity> returnVector{getTileCollisions(4, 0)};
+        REQUIRE(returnVector.size() == 1);
+        REQUIRE(returnVector.at(0) == entities[5]);
+
+        returnVector = getTileCollisions(1, 1);
+        REQUIRE(returnVector.size() == 0);
+    }
+}